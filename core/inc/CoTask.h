@@ -0,0 +1,71 @@
+#pragma once
+
+#include "TaskGraph_base.h"
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace TaskGraph
+{
+    /// <summary>
+    /// Return type of a coroutine task body (see Task::setCoroutineFunction). The body
+    /// starts suspended; the scheduler resumes it and keeps the frame alive while it
+    /// waits on one of the TaskContext awaitables. An exception leaving the body is
+    /// stored and fails the task like one thrown by a work function.
+    /// </summary>
+    class CoTask
+    {
+        public:
+        struct promise_type
+        {
+            std::exception_ptr error;
+
+            CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+
+        CoTask() = default;
+        CoTask(CoTask&& other) noexcept
+            : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        CoTask& operator=(CoTask&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+        CoTask(const CoTask&) = delete;
+        CoTask& operator=(const CoTask&) = delete;
+        ~CoTask() { reset(); }
+
+        explicit operator bool() const { return static_cast<bool>(m_handle); }
+
+        /// <summary>Runs the body up to its next suspension. Returns true once it has finished.</summary>
+        bool resume()
+        {
+            m_handle.resume();
+            return m_handle.done();
+        }
+        bool done() const { return m_handle && m_handle.done(); }
+        std::exception_ptr error() const { return m_handle ? m_handle.promise().error : nullptr; }
+
+        /// <summary>Destroys the frame, finished or not.</summary>
+        void reset()
+        {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = nullptr;
+        }
+
+        private:
+        explicit CoTask(std::coroutine_handle<promise_type> handle)
+            : m_handle(handle) {}
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "TaskGraph_global.h"
+#include <string>
+
+namespace TaskGraph
+{
+    /// <summary>
+    /// What determined a scheduler's thread count: the constructor / enableThreads
+    /// argument, or the smallest of the detected CPU limits.
+    /// </summary>
+    enum class ThreadCountSource : int
+    {
+        Explicit = 0,
+        HardwareConcurrency,   // std::thread::hardware_concurrency()
+        Affinity,              // sched_getaffinity mask
+        CgroupV1Quota,         // cpu.cfs_quota_us / cpu.cfs_period_us
+        CgroupV2Quota          // cpu.max
+    };
+
+    /// <summary>A detected default thread count and the limit it came from.</summary>
+    struct TASK_GRAPH_API DefaultThreadCount
+    {
+        unsigned int count = 1;
+        ThreadCountSource source = ThreadCountSource::HardwareConcurrency;
+
+        const char* sourceName() const;
+    };
+
+    namespace Internal
+    {
+        /// <summary>
+        /// Detects how many CPUs this process may actually use: the smallest of
+        /// hardware_concurrency(), the CPU affinity mask and the cgroup CPU quota
+        /// (v2 cpu.max, else v1 cpu.cfs_quota_us, the tightest limit on the way up the
+        /// hierarchy, rounded up to whole CPUs). On a tie the more specific limit is
+        /// reported. Off Linux only hardware_concurrency() counts.
+        /// </summary>
+        class TASK_GRAPH_API CpuQuota
+        {
+            public:
+            static DefaultThreadCount detect();
+
+            /// <summary>
+            /// CPUs granted by the cgroup quota, 0 if unlimited or not found. `root` is
+            /// prepended to every path read (/proc/self/..., the cgroup mounts), so a fake
+            /// tree can stand in for the real one.
+            /// </summary>
+            static double cgroupCpuLimit(const std::string& root, ThreadCountSource& source);
+
+            /// <summary>CPUs in the affinity mask of this process, 0 if unknown.</summary>
+            static unsigned int affinityCpuCount();
+        };
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "TaskGraph_base.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TaskGraph
+{
+    namespace Internal
+    {
+        /// <summary>
+        /// Asynchronous read / write / fsync on file descriptors into caller buffers.
+        /// On Linux the operations go through an io_uring: submitters write their entry
+        /// into the submission ring and one of them hands every entry queued so far to
+        /// the kernel in a single io_uring_enter, while a reaper thread collects the
+        /// completions. Without io_uring (old kernel, blocked by seccomp, other
+        /// platforms, or setUseIoUring(false)) a small dedicated thread pool runs the
+        /// blocking pread / pwrite / fsync calls (on Windows ReadFile / WriteFile at an
+        /// explicit offset and FlushFileBuffers). Started on the first submit.
+        /// Callbacks run on the service's threads and must be short.
+        /// </summary>
+        class FileIoService
+        {
+            public:
+            enum class Op : int
+            {
+                Read = 0,
+                Write,
+                Sync
+            };
+            enum class Backend : int
+            {
+                None = 0,   // not started yet
+                IoUring,
+                ThreadPool
+            };
+            // Bytes transferred, or -errno.
+            using Callback = std::function<void(long)>;
+
+            FileIoService();
+            ~FileIoService();
+            FileIoService(const FileIoService&) = delete;
+            FileIoService& operator=(const FileIoService&) = delete;
+
+            /// <summary>
+            /// Prefer io_uring (default) or always use the thread pool. Stops the running
+            /// backend; must not be called while operations are in flight.
+            /// </summary>
+            void setUseIoUring(bool use);
+            bool getUseIoUring() const;
+            Backend getBackend() const;
+
+            /// <summary>
+            /// Starts one operation. Like pread / pwrite the transfer may be short; Sync
+            /// ignores buffer, size and offset. The callback is always called once.
+            /// </summary>
+            void submit(Op op, int fd, void* buffer, size_t size, uint64_t offset, Callback callback);
+
+            size_t getInFlightCount() const;
+            // io_uring_enter calls that submitted entries (submitted / enters = batch size).
+            uint64_t getSubmitCalls() const;
+            uint64_t getSubmittedCount() const;
+
+            private:
+            struct Request
+            {
+                Op op;
+                int fd;
+                void* buffer;
+                size_t size;
+                uint64_t offset;
+                Callback callback;
+            };
+            struct Uring;
+
+            void startLocked();
+            void stop();
+            void submitToPoolLocked(Request request);
+            // Moves the ring entries the kernel has not consumed to the thread pool.
+            void reclaimToPoolLocked();
+            void poolThreadFunction();
+            void reaperThreadFunction();
+            static long runBlocking(const Request& request);
+
+            mutable std::mutex m_mutex;
+            bool m_useIoUring = true;
+            Backend m_backend = Backend::None;
+            size_t m_inFlight = 0;
+            uint64_t m_submitCalls = 0;
+            uint64_t m_submitted = 0;
+
+            std::unique_ptr<Uring> m_uring;
+            std::unique_ptr<std::thread> m_reaper;
+
+            // Thread pool backend, also taking the overflow of a full ring.
+            std::condition_variable m_poolCv;
+            std::deque<Request> m_poolQueue;
+            std::vector<std::thread> m_poolThreads;
+            bool m_poolStop = false;
+        };
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "TaskGraph_base.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace TaskGraph
+{
+    namespace Internal
+    {
+        /// <summary>
+        /// One thread waiting on an epoll set for any number of one-shot fd watches.
+        /// Each watch registers its own duplicate of the fd, so one fd can be watched
+        /// several times, and closing the caller's fd does not disturb the watch.
+        /// Linux only: elsewhere isSupported() is false and watch() fails. The thread
+        /// is started on the first watch() and joined by the destructor. Callbacks
+        /// run on the reactor thread and must be short.
+        /// </summary>
+        class IoReactor
+        {
+            public:
+            using WatchId = uint64_t;
+            static constexpr WatchId invalidWatch = 0;
+
+            // Interest and readiness flags (same values as TaskContext::IoEvent).
+            enum Event : int
+            {
+                Readable = 1,
+                Writable = 2,
+                Error = 4,
+                HangUp = 8
+            };
+
+            IoReactor();
+            ~IoReactor();
+            IoReactor(const IoReactor&) = delete;
+            IoReactor& operator=(const IoReactor&) = delete;
+
+            static bool isSupported();
+
+            /// <summary>
+            /// Calls `callback(events)` once `fd` is ready for any of `interest`; Error and
+            /// HangUp are always reported. Returns invalidWatch if the fd cannot be polled
+            /// (e.g. a regular file) or the platform has no reactor.
+            /// </summary>
+            WatchId watch(int fd, int interest, std::function<void(int)> callback);
+
+            /// <summary>
+            /// Removes a watch. Returns false if it already fired (or is firing) or the
+            /// id is unknown. Safe to call with invalidWatch.
+            /// </summary>
+            bool unwatch(WatchId id);
+
+            size_t getWatchCount() const;
+            bool isThreadRunning() const;
+
+            private:
+            struct Watch
+            {
+                int fd;
+                std::function<void(int)> callback;
+            };
+
+            bool startLocked();
+            void release(int fd);
+            void threadFunction();
+
+            mutable std::mutex m_mutex;
+            std::unordered_map<WatchId, Watch> m_watches;
+            WatchId m_nextId = 1;
+            int m_epollFd = -1;
+            // Wakes the thread for shutdown; registered under invalidWatch.
+            int m_wakeFd = -1;
+            bool m_stop = false;
+            std::unique_ptr<std::thread> m_thread;
+        };
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "TaskGraph_base.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace TaskGraph
+{
+    /// <summary>
+    /// Host pressure over one sampling interval, as fractions: the share of wall time
+    /// some task stalled on the CPU, on memory and on I/O, and how far the runnable
+    /// threads exceed the CPUs (0.5 = one and a half runnable threads per CPU).
+    /// </summary>
+    struct PressureSample
+    {
+        bool valid = false;
+        double cpu = 0.0;
+        double memory = 0.0;
+        double io = 0.0;
+        double runQueue = 0.0;
+
+        double pressure() const { return std::max({ cpu, memory, io, runQueue }); }
+    };
+
+    namespace Internal
+    {
+        /// <summary>
+        /// Reads the Linux pressure stall information (/proc/pressure/cpu, memory, io:
+        /// the "some" totals) and the runnable thread count (/proc/loadavg). Each sample
+        /// covers the time since the previous one; the first sample only primes the
+        /// totals and is invalid. Elsewhere, or without PSI (kernel older than 4.20 or
+        /// psi=0), every sample is invalid.
+        /// </summary>
+        class PressureMonitor
+        {
+            public:
+            using Clock = std::chrono::steady_clock;
+
+            static bool isSupported();
+
+            PressureSample sample();
+            void reset() { m_primed = false; }
+
+            private:
+            bool m_primed = false;
+            Clock::time_point m_last;
+            uint64_t m_cpuTotal = 0;
+            uint64_t m_memoryTotal = 0;
+            uint64_t m_ioTotal = 0;
+        };
+    }
+}
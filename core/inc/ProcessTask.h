@@ -0,0 +1,69 @@
+#pragma once
+
+#include "TaskGraph_base.h"
+#include "Task.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace TaskGraph
+{
+    /// <summary>
+    /// Runs an external program as a task body without holding a worker while the
+    /// child runs. The child is started with posix_spawn (PATH is searched), its
+    /// stdin is /dev/null, and stdout/stderr are read as they arrive: each line goes
+    /// to the task's logger (stdout as info, stderr as warning). The task completes
+    /// when the child exits; an exit code other than 0 or a fatal signal fails it.
+    /// Cancellation and setTimeout kill the child (SIGKILL) and reap it. Each retry
+    /// starts a new child. Linux only: elsewhere the task fails when it runs.
+    /// </summary>
+    class TASK_GRAPH_API ProcessTask : public Task
+    {
+        public:
+        ProcessTask(const std::string& name, const std::string& program,
+                    const std::vector<std::string>& arguments = {});
+
+        // Configuration is read when the child is started.
+        void setProgram(const std::string& program) { m_program = program; }
+        const std::string& getProgram() const { return m_program; }
+        void setArguments(const std::vector<std::string>& arguments) { m_arguments = arguments; }
+        const std::vector<std::string>& getArguments() const { return m_arguments; }
+
+        /// <summary>Directory the child starts in. Empty (default): the current directory.</summary>
+        void setWorkingDirectory(const std::string& directory) { m_workingDirectory = directory; }
+        const std::string& getWorkingDirectory() const { return m_workingDirectory; }
+
+        /// <summary>
+        /// "KEY=VALUE" entries that replace the child's environment. Empty (default):
+        /// the child inherits the environment of this process.
+        /// </summary>
+        void setEnvironment(const std::vector<std::string>& environment) { m_environment = environment; }
+        const std::vector<std::string>& getEnvironment() const { return m_environment; }
+
+        /// <summary>
+        /// When enabled, stdout is collected into the task result (std::string) instead
+        /// of being logged line by line. stderr is always logged. Default off.
+        /// </summary>
+        void setCaptureStdout(bool capture) { m_captureStdout = capture; }
+        bool getCaptureStdout() const { return m_captureStdout; }
+
+        /// <summary>
+        /// Exit code of the last child, -1 before it exited or if it was ended by a signal.
+        /// </summary>
+        int getExitCode() const { return m_exitCode.load(std::memory_order_acquire); }
+
+        /// <summary>Pid of the running child, 0 while none runs.</summary>
+        long getPid() const { return m_pid.load(std::memory_order_acquire); }
+
+        private:
+        CoTask runProcess(TaskContext& ctx);
+
+        std::string m_program;
+        std::vector<std::string> m_arguments;
+        std::string m_workingDirectory;
+        std::vector<std::string> m_environment;
+        bool m_captureStdout = false;
+        std::atomic<int> m_exitCode{-1};
+        std::atomic<long> m_pid{0};
+    };
+}
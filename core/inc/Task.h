@@ -1,19 +1,24 @@
 #pragma once
 
 #include "TaskGraph_base.h"
+#include "CoTask.h"
 #include <QObject>
 #include <QString>
 #include <QVariant>
 #include <string>
 #include <functional>
+#include <map>
 #include <vector>
 #include <memory>
+#include <optional>
 #include <atomic>
 #include <mutex>
 #include <any>
 #include <chrono>
 #include <typeinfo>
+#include <type_traits>
 #include <stdexcept>
+#include <coroutine>
 
 namespace Log { class LogObject; }
 
@@ -23,6 +28,50 @@ namespace TaskGraph
     class Task;
     class TaskGroup;
 
+    /// <summary>
+    /// Thrown by the TaskContext awaitables when the task is cancelled (or timed out)
+    /// while its coroutine body waits. A body left with it ends as Cancelled, or as
+    /// Failed with "timeout" if the watchdog fired.
+    /// </summary>
+    class CancelledError : public std::runtime_error
+    {
+        public:
+        CancelledError()
+            : std::runtime_error("Task cancelled") {}
+    };
+
+    /// <summary>
+    /// A read, write or fsync for TaskContext::fileIo / fileIoThen. Like pread and
+    /// pwrite a transfer may be short. The buffer must stay valid until it completed.
+    /// </summary>
+    struct FileIoRequest
+    {
+        enum class Kind : int
+        {
+            Read = 0,
+            Write,
+            Sync
+        };
+        Kind kind = Kind::Read;
+        int fd = -1;
+        void* buffer = nullptr;
+        size_t size = 0;
+        uint64_t offset = 0;
+
+        static FileIoRequest read(int fd, void* buffer, size_t size, uint64_t offset)
+        {
+            return FileIoRequest{ Kind::Read, fd, buffer, size, offset };
+        }
+        static FileIoRequest write(int fd, const void* buffer, size_t size, uint64_t offset)
+        {
+            return FileIoRequest{ Kind::Write, fd, const_cast<void*>(buffer), size, offset };
+        }
+        static FileIoRequest sync(int fd)
+        {
+            return FileIoRequest{ Kind::Sync, fd, nullptr, 0, 0 };
+        }
+    };
+
     /// <summary>
     /// Execution context handed to a task body. Provides result set/get, cancel
     /// polling, dependency-result access and dynamic child spawning. Only the
@@ -59,6 +108,43 @@ namespace TaskGraph
         /// </summary>
         bool spawn(const std::shared_ptr<Task>& child);
 
+        /// <summary>
+        /// Fork-join: spawn children that may start right away and return once all of
+        /// them are finished, so the body can use their results. While waiting, the
+        /// calling thread executes other ready tasks instead of blocking. The children
+        /// belong to the current run only and are not added to the graph. Returns true
+        /// if every child is Done. Not allowed from a Task with TaskAffinity::Gui.
+        /// </summary>
+        bool spawnAndWait(const std::shared_ptr<Task>& child);
+        bool spawnAndWait(const std::vector<std::shared_ptr<Task>>& children);
+
+        /// <summary>
+        /// Wait, while executing other ready tasks, until all `tasks` of the running
+        /// graph are finished. A task that depends on the caller, directly or through
+        /// other tasks, would never finish and is rejected. Returns true if every task
+        /// is Done.
+        /// </summary>
+        bool join(const std::vector<std::shared_ptr<Task>>& tasks);
+
+        /// <summary>
+        /// Data-parallel loop over [begin, end). The range is cut into chunks of `grain`
+        /// indices (0 picks a grain from the worker count) and `fn(chunkBegin, chunkEnd)`
+        /// runs on idle workers of the scheduler and on the calling thread. Returns once
+        /// every chunk has finished. No chunk starts after a cancel request; returns
+        /// false if chunks were left out. The first exception thrown by a chunk is
+        /// rethrown here. The loop stays part of this task: no graph nodes are created.
+        /// </summary>
+        bool parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+        /// <summary>
+        /// parallelFor that combines a result: `chunkFn(chunkBegin, chunkEnd)` returns a
+        /// T per chunk, folded in index order into `identity` with `combine(acc, part)`,
+        /// so the result does not depend on which thread ran which chunk. After a cancel
+        /// the result covers only the chunks that ran.
+        /// </summary>
+        template <class T, class ChunkFn, class CombineFn>
+        T parallelReduce(size_t begin, size_t end, size_t grain, T identity, ChunkFn chunkFn, CombineFn combine);
+
         /// <summary>Access the running task's per-instance logger.</summary>
         Log::LogObject& log();
 
@@ -69,7 +155,7 @@ namespace TaskGraph
         /// Task with TaskAffinity::Gui — either would deadlock. This primitive
         /// is the first scheduler-provided blocking point that is
         /// cancellation-aware; other blocking work in a task body must poll
-        /// isCancelRequested() cooperatively.
+        /// isCancelRequested() cooperatively. askGuiThen does not hold the worker.
         /// </summary>
         QVariant askGui(const QVariant& payload);
 
@@ -79,11 +165,182 @@ namespace TaskGraph
             return askGui(payload).value<T>();
         }
 
+        /// <summary>
+        /// RAII guard around a call that blocks the thread (a synchronous database
+        /// call, a legacy blocking API). While it lives the worker counts as blocked
+        /// instead of busy, and the scheduler starts or wakes a compensating worker so
+        /// the pool keeps its parallelism, up to TaskScheduler::setMaxCompensatingThreads.
+        /// The compensating worker retires after its current task once the guard is
+        /// gone. Nested guards count once. Does nothing outside a running scheduler.
+        /// </summary>
+        class TASK_GRAPH_API BlockingScope
+        {
+            public:
+            explicit BlockingScope(TaskScheduler* scheduler);
+            ~BlockingScope();
+            BlockingScope(const BlockingScope&) = delete;
+            BlockingScope& operator=(const BlockingScope&) = delete;
+
+            private:
+            // Null if this guard is not counted.
+            TaskScheduler* m_scheduler;
+        };
+        BlockingScope blockingScope();
+
+        /// <summary>
+        /// askGui without holding a worker: the question is posted once the body has
+        /// returned, and the worker moves on. When the GUI answers (respondToGuiEvent)
+        /// the task is queued again and `continuation(ctx, response)` runs on a worker;
+        /// it may call askGuiThen again. The task finishes with its last continuation.
+        /// On cancellation the continuation gets an invalid QVariant, like askGui.
+        /// Returns false without a scheduler, from a Task with TaskAffinity::Gui or a
+        /// coroutine body (use askGuiAsync), or if a continuation is already pending.
+        /// </summary>
+        bool askGuiThen(const QVariant& payload, std::function<void(TaskContext&, const QVariant&)> continuation);
+
+        /// <summary>Readiness flags for waitForFd / waitForFdThen. Error and HangUp are always reported.</summary>
+        enum IoEvent : int
+        {
+            Readable = 1,
+            Writable = 2,
+            Error = 4,
+            HangUp = 8
+        };
+
+        /// <summary>
+        /// askGuiThen for a file descriptor: once the body has returned, the worker moves
+        /// on and the scheduler's reactor watches `fd`. When it is ready for any of
+        /// `events` the task is queued again and `continuation(ctx, readyEvents)` runs on
+        /// a worker; it may chain further waits. A cancel or timeout ends the task without
+        /// running the continuation. Returns false in the same cases as askGuiThen.
+        /// Linux only; the fd must stay open until the continuation ran.
+        /// </summary>
+        bool waitForFdThen(int fd, int events, std::function<void(TaskContext&, int)> continuation);
+
+        /// <summary>
+        /// File I/O without holding a worker: `request` is handed to the scheduler's
+        /// file I/O service (io_uring, or a small I/O thread pool where io_uring is not
+        /// available) once the body has returned, and `continuation(ctx, result)` runs on
+        /// a worker when it completed. `result` is the byte count (0 for Sync) or -errno.
+        /// The continuation may start further I/O. A cancel or timeout does not interrupt
+        /// the operation, since the kernel may still use the buffer; it takes effect
+        /// after completion and the continuation does not run. Returns false in the same
+        /// cases as askGuiThen.
+        /// </summary>
+        bool fileIoThen(const FileIoRequest& request, std::function<void(TaskContext&, long)> continuation);
+
+        /// <summary>
+        /// Safe-point check of a long body: true once the body has run for the
+        /// scheduler's time slice (TaskScheduler::setTimeSlice) and a queued task is
+        /// waiting that is older or of higher priority. Cheap enough to call in a loop.
+        /// </summary>
+        bool shouldYield() const;
+
+        /// <summary>
+        /// Resumable work function: once the body has returned, the task is queued
+        /// again behind the waiting work and `continuation(ctx)` runs on a worker when
+        /// it is picked up. The state to go on with lives in the continuation's
+        /// captures. Typically called when shouldYield() is true; it may chain further
+        /// yields. Returns false in the same cases as askGuiThen.
+        /// </summary>
+        bool yieldThen(std::function<void(TaskContext&)> continuation);
+
+        /// <summary>
+        /// Awaitables for coroutine bodies (Task::setCoroutineFunction). Suspending gives
+        /// the worker back to the pool; the task is queued again once the awaited event
+        /// happened. A cancel or timeout resumes a waiting body with CancelledError
+        /// (askGuiAsync: with an invalid QVariant, like askGui).
+        /// </summary>
+        template <class T> class DependencyAwaiter;
+        class SleepAwaiter;
+        class GuiAwaiter;
+        class FdAwaiter;
+        class FileIoAwaiter;
+        class YieldAwaiter;
+
+        /// <summary>
+        /// Resumes once `task` (part of the same run) is finished, with its result as T
+        /// (nothing for T = void). Throws std::runtime_error if it did not end Done, or
+        /// right away if `task` depends on the awaiting task, directly or through others.
+        /// </summary>
+        template <class T = void>
+        DependencyAwaiter<T> dependency(const Task& task);
+        SleepAwaiter sleepFor(std::chrono::milliseconds delay);
+        GuiAwaiter askGuiAsync(const QVariant& payload);
+
+        /// <summary>
+        /// Resumes with the ready IoEvent flags once `fd` is ready for any of `events`,
+        /// without holding a worker while waiting. Throws std::runtime_error if the fd
+        /// cannot be watched (e.g. a regular file, or not on Linux).
+        /// </summary>
+        FdAwaiter waitForFd(int fd, int events);
+
+        /// <summary>
+        /// Runs `request` on the scheduler's file I/O service and resumes with the byte
+        /// count (0 for Sync). Throws std::runtime_error on an I/O error. Like
+        /// fileIoThen, a cancel or timeout takes effect only once the operation completed.
+        /// </summary>
+        FileIoAwaiter fileIo(const FileIoRequest& request);
+        FileIoAwaiter readAt(int fd, void* buffer, size_t size, uint64_t offset);
+        FileIoAwaiter writeAt(int fd, const void* buffer, size_t size, uint64_t offset);
+        FileIoAwaiter syncFile(int fd);
+
+        /// <summary>
+        /// Yield point: if shouldYield() the coroutine is queued again behind the waiting
+        /// work and resumes with its frame intact once a worker picks it up; otherwise
+        /// it goes on right away.
+        /// </summary>
+        YieldAwaiter yield();
+
         Task* task() const { return m_task; }
 
+        // Internal — used by Task and TaskScheduler. A body that returned with a pending
+        // askGuiThen / waitForFdThen continuation goes on as runContinuations(), which
+        // runs the body itself first if `runBody` (a retried attempt).
+        bool hasContinuation() const { return m_continuation.has_value(); }
+        void dropContinuation() { m_continuation.reset(); }
+        CoTask runContinuations(bool runBody);
+        // Starts the time slice; called whenever the body is dispatched to a worker.
+        void beginSlice() { m_sliceStart = std::chrono::steady_clock::now(); }
+
         private:
+        // A GUI question (onAnswer), an fd wait (onReady), file I/O (onFileIo) or a
+        // yield (onResume).
+        struct Continuation
+        {
+            QVariant payload;
+            int fd = -1;
+            int events = 0;
+            FileIoRequest fileIo;
+            std::function<void(TaskContext&, const QVariant&)> onAnswer;
+            std::function<void(TaskContext&, int)> onReady;
+            std::function<void(TaskContext&, long)> onFileIo;
+            std::function<void(TaskContext&)> onResume;
+        };
+        bool setContinuation(const char* caller, Continuation continuation);
+
+        // Suspension hooks of the awaitables, forwarded to the scheduler.
+        bool isSettled(const Task& task) const;
+        void suspendUntilSettled(const Task& task);
+        void checkAwaited(const Task& task) const;
+        void suspendFor(std::chrono::milliseconds delay);
+        void throwIfCancelled() const;
+        int suspendForGui(const QVariant& payload);
+        QVariant takeGuiResponse(int requestId);
+        uint64_t suspendForFd(int fd, int events, std::shared_ptr<std::atomic<int>>& ready);
+        int endFdWait(uint64_t watch, const std::shared_ptr<std::atomic<int>>& ready);
+        void suspendForFileIo(const FileIoRequest& request, std::shared_ptr<std::atomic<long>>& result);
+        long endFileIo(const std::shared_ptr<std::atomic<long>>& result, bool throwOnError);
+        void suspendForYield();
+
+        size_t resolveGrain(size_t count, size_t grain) const;
+        // Runs fn(chunkIndex, chunkBegin, chunkEnd) for every chunk of a resolved grain.
+        bool forEachChunk(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t, size_t)>& fn);
+
         Task* m_task;
         TaskScheduler* m_scheduler;
+        std::optional<Continuation> m_continuation;
+        std::chrono::steady_clock::time_point m_sliceStart = std::chrono::steady_clock::now();
     };
 
     /// <summary>
@@ -141,9 +398,42 @@ namespace TaskGraph
         void setWorkFunction(const std::function<void()>& workFunction) { m_workFunction = workFunction; }
         void setWorkFunction(const std::function<void(TaskContext&)>& workFunction) { m_workFunctionCtx = workFunction; }
 
+        /// <summary>
+        /// Coroutine body, used instead of a work function. Each co_await on a TaskContext
+        /// awaitable suspends the body and frees the worker. The function object stays in
+        /// the task and is invoked in place, so a lambda's captures outlive every frame.
+        /// </summary>
+        void setCoroutineFunction(const std::function<CoTask(TaskContext&)>& coroutineFunction) { m_coroutineFunction = coroutineFunction; }
+        bool isCoroutine() const { return static_cast<bool>(m_coroutineFunction); }
+
+        /// <summary>
+        /// Dispatch priority; higher runs first among ready tasks. Default 0. Read
+        /// when the task becomes ready (see TaskScheduler::setPriorityAging).
+        /// </summary>
+        void setPriority(int priority) { m_priority.store(priority, std::memory_order_release); }
+        int getPriority() const { return m_priority.load(std::memory_order_acquire); }
+
         void setAffinity(TaskAffinity a) { m_affinity.store(a, std::memory_order_release); }
         TaskAffinity getAffinity() const { return m_affinity.load(std::memory_order_acquire); }
 
+        /// <summary>
+        /// Units of a scheduler resource pool (TaskScheduler::setResourceCapacity) the
+        /// task holds while it runs, e.g. setResourceRequirement("licence", 1). Zero
+        /// removes the requirement. Read when a run starts; pools the scheduler does not
+        /// define are ignored.
+        /// </summary>
+        void setResourceRequirement(const std::string& resource, size_t units);
+        size_t getResourceRequirement(const std::string& resource) const;
+        const std::map<std::string, size_t>& getResourceRequirements() const { return m_resourceRequirements; }
+
+        /// <summary>
+        /// Memory the task is expected to use while it runs, in bytes. Counted against
+        /// TaskScheduler::setMemoryBudget. Zero (default) means not estimated: the task
+        /// is not throttled by the budget.
+        /// </summary>
+        void setMemoryEstimate(uint64_t bytes) { m_memoryEstimate.store(bytes, std::memory_order_release); }
+        uint64_t getMemoryEstimate() const { return m_memoryEstimate.load(std::memory_order_acquire); }
+
         /// <summary>Per-task progress weight; must be positive. Default 1.0.</summary>
         void setWeight(float w);
         float getWeight() const { return m_weight.load(std::memory_order_acquire); }
@@ -155,9 +445,38 @@ namespace TaskGraph
         void setMaxRetries(int n) { m_maxRetries.store(n < 0 ? 0 : n, std::memory_order_release); }
         int getMaxRetries() const { return m_maxRetries.load(std::memory_order_acquire); }
 
+        /// <summary>
+        /// Delay before a failed attempt is retried. The worker does not wait: the task
+        /// is parked by the scheduler and queued again once the delay has passed.
+        /// </summary>
         void setRetryBackoff(std::chrono::milliseconds t) { m_backoffMs.store(t.count(), std::memory_order_release); }
         std::chrono::milliseconds getRetryBackoff() const { return std::chrono::milliseconds(m_backoffMs.load(std::memory_order_acquire)); }
 
+        /// <summary>
+        /// Exponential backoff: retry n waits backoff * multiplier^(n-1), at most the cap
+        /// (zero = no cap). The default multiplier 1.0 keeps the backoff constant.
+        /// </summary>
+        void setRetryBackoffMultiplier(double m) { m_backoffMultiplier.store(m < 1.0 ? 1.0 : m, std::memory_order_release); }
+        double getRetryBackoffMultiplier() const { return m_backoffMultiplier.load(std::memory_order_acquire); }
+        void setRetryBackoffCap(std::chrono::milliseconds t) { m_backoffCapMs.store(t.count() > 0 ? t.count() : 0, std::memory_order_release); }
+        std::chrono::milliseconds getRetryBackoffCap() const { return std::chrono::milliseconds(m_backoffCapMs.load(std::memory_order_acquire)); }
+
+        /// <summary>
+        /// Randomizes each retry delay downwards by up to this fraction (0..1), so tasks
+        /// that failed together do not retry in lockstep. 1.0 is "full jitter". Default 0.
+        /// </summary>
+        void setRetryJitter(double fraction) { m_retryJitter.store(fraction < 0.0 ? 0.0 : (fraction > 1.0 ? 1.0 : fraction), std::memory_order_release); }
+        double getRetryJitter() const { return m_retryJitter.load(std::memory_order_acquire); }
+
+        /// <summary>Backoff before retry `attempt` (1-based), before jitter.</summary>
+        std::chrono::milliseconds getRetryDelay(int attempt) const;
+
+        /// <summary>
+        /// Wall-clock time the body took in its last successful run. Zero until the
+        /// task completed once. Used by SchedulingPolicy::CriticalPath as task cost.
+        /// </summary>
+        std::chrono::microseconds getLastDuration() const { return std::chrono::microseconds(m_lastDurationUs.load(std::memory_order_acquire)); }
+
         bool addDependency(const std::shared_ptr<Task>& task);
         /// <summary>Depend on every member of the group. Returns true only if all members were added successfully.</summary>
         bool addDependency(const TaskGroup& group);
@@ -200,8 +519,18 @@ namespace TaskGraph
         // Internal — used by TaskScheduler for retry/timeout bookkeeping. Not part of the public contract.
         void signalTimeout();
         void prepareRetry();
+        // runTask() in three steps, so a coroutine body can span several resumptions:
+        // beginBody() moves Pending -> Running (false: the body must not run), endBody()
+        // settles the final status from the exception that left the body, if any.
+        bool beginBody();
+        // Runs the body once; returns the exception that left it, if any.
+        std::exception_ptr invokeBody(TaskContext* ctx);
+        CoTask startCoroutine(TaskContext& ctx) { return m_coroutineFunction ? m_coroutineFunction(ctx) : ctx.runContinuations(true); }
+        bool endBody(std::exception_ptr error);
         uint64_t beginTimeoutWindow() { return m_timeoutGen.fetch_add(1, std::memory_order_acq_rel) + 1; }
         uint64_t currentTimeoutWindow() const { return m_timeoutGen.load(std::memory_order_acquire); }
+        // Bumped on every dependency change; lets the scheduler detect a stale compiled plan.
+        uint64_t getTopologyVersion() const { return m_topologyVersion.load(std::memory_order_acquire); }
 
         signals:
         void started();
@@ -226,16 +555,25 @@ namespace TaskGraph
 
         std::string m_name;
         std::string m_description;
+        std::map<std::string, size_t> m_resourceRequirements;
+        std::atomic<uint64_t> m_memoryEstimate{0};
         std::atomic<Status> m_status;
         std::atomic<TaskAffinity> m_affinity;
+        std::atomic<int> m_priority;
         std::atomic<bool> m_cancelRequested;
         std::atomic<bool> m_timeoutHit;
         std::atomic<uint64_t> m_timeoutGen;
+        std::atomic<uint64_t> m_topologyVersion;
 
         std::atomic<float> m_weight;
         std::atomic<int64_t> m_timeoutMs;
         std::atomic<int> m_maxRetries;
         std::atomic<int64_t> m_backoffMs;
+        std::atomic<double> m_backoffMultiplier;
+        std::atomic<int64_t> m_backoffCapMs;
+        std::atomic<double> m_retryJitter;
+        std::atomic<int64_t> m_lastDurationUs;
+        std::chrono::steady_clock::time_point m_bodyStart;
 
         mutable std::unique_ptr<Log::LogObject> m_logger;
         Log::LogObject* m_externalLogger = nullptr;
@@ -244,6 +582,7 @@ namespace TaskGraph
 
         std::function<void()> m_workFunction;
         std::function<void(TaskContext&)> m_workFunctionCtx;
+        std::function<CoTask(TaskContext&)> m_coroutineFunction;
         std::vector<std::weak_ptr<Task>> m_dependencies;
         mutable std::mutex m_depMutex;
 
@@ -262,6 +601,25 @@ namespace TaskGraph
         return std::any_cast<T>(r);
     }
 
+    template <class T, class ChunkFn, class CombineFn>
+    T TaskContext::parallelReduce(size_t begin, size_t end, size_t grain, T identity, ChunkFn chunkFn, CombineFn combine)
+    {
+        if (end <= begin)
+            return identity;
+        grain = resolveGrain(end - begin, grain);
+        std::vector<std::optional<T>> partial((end - begin + grain - 1) / grain);
+        forEachChunk(begin, end, grain, [&partial, &chunkFn](size_t chunk, size_t b, size_t e) {
+            partial[chunk].emplace(chunkFn(b, e));
+        });
+        T result = std::move(identity);
+        for (auto& p : partial)
+        {
+            if (p)
+                result = combine(std::move(result), std::move(*p));
+        }
+        return result;
+    }
+
     template <class T>
     T TaskContext::getDependencyResult(const Task& dep) const
     {
@@ -270,4 +628,109 @@ namespace TaskGraph
             throw std::runtime_error("Dependency has no result");
         return std::any_cast<T>(r);
     }
+
+    class TaskContext::SleepAwaiter
+    {
+        public:
+        SleepAwaiter(TaskContext& ctx, std::chrono::milliseconds delay)
+            : m_ctx(ctx), m_delay(delay) {}
+        bool await_ready() const { return m_delay.count() <= 0; }
+        void await_suspend(std::coroutine_handle<>) { m_ctx.suspendFor(m_delay); }
+        void await_resume() const { m_ctx.throwIfCancelled(); }
+
+        private:
+        TaskContext& m_ctx;
+        std::chrono::milliseconds m_delay;
+    };
+
+    class TaskContext::GuiAwaiter
+    {
+        public:
+        GuiAwaiter(TaskContext& ctx, const QVariant& payload)
+            : m_ctx(ctx), m_payload(payload) {}
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<>) { m_requestId = m_ctx.suspendForGui(m_payload); }
+        QVariant await_resume() { return m_ctx.takeGuiResponse(m_requestId); }
+
+        private:
+        TaskContext& m_ctx;
+        QVariant m_payload;
+        int m_requestId = 0;
+    };
+
+    class TaskContext::FdAwaiter
+    {
+        public:
+        FdAwaiter(TaskContext& ctx, int fd, int events)
+            : m_ctx(ctx), m_fd(fd), m_events(events) {}
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<>) { m_watch = m_ctx.suspendForFd(m_fd, m_events, m_ready); }
+        int await_resume() { return m_ctx.endFdWait(m_watch, m_ready); }
+
+        private:
+        TaskContext& m_ctx;
+        int m_fd;
+        int m_events;
+        uint64_t m_watch = 0;
+        // Written by the reactor thread: the ready events, or -1 if the fd cannot be watched.
+        std::shared_ptr<std::atomic<int>> m_ready;
+    };
+
+    class TaskContext::FileIoAwaiter
+    {
+        public:
+        FileIoAwaiter(TaskContext& ctx, const FileIoRequest& request, bool throwOnError)
+            : m_ctx(ctx), m_request(request), m_throwOnError(throwOnError) {}
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<>) { m_ctx.suspendForFileIo(m_request, m_result); }
+        long await_resume() { return m_ctx.endFileIo(m_result, m_throwOnError); }
+
+        private:
+        TaskContext& m_ctx;
+        FileIoRequest m_request;
+        bool m_throwOnError;
+        // Written by the I/O service: bytes transferred, or -errno.
+        std::shared_ptr<std::atomic<long>> m_result;
+    };
+
+    class TaskContext::YieldAwaiter
+    {
+        public:
+        // `always`: suspend without asking shouldYield() (yieldThen already did).
+        YieldAwaiter(TaskContext& ctx, bool always)
+            : m_ctx(ctx), m_always(always) {}
+        bool await_ready() const { return !m_always && !m_ctx.shouldYield(); }
+        void await_suspend(std::coroutine_handle<>) { m_ctx.suspendForYield(); }
+        void await_resume() const { m_ctx.throwIfCancelled(); }
+
+        private:
+        TaskContext& m_ctx;
+        bool m_always;
+    };
+
+    template <class T>
+    class TaskContext::DependencyAwaiter
+    {
+        public:
+        DependencyAwaiter(TaskContext& ctx, const Task& task)
+            : m_ctx(ctx), m_task(task) {}
+        bool await_ready() const { return m_ctx.isSettled(m_task); }
+        void await_suspend(std::coroutine_handle<>) { m_ctx.suspendUntilSettled(m_task); }
+        T await_resume() const
+        {
+            m_ctx.checkAwaited(m_task);
+            if constexpr (!std::is_void_v<T>)
+                return getResultAs<T>(m_task);
+        }
+
+        private:
+        TaskContext& m_ctx;
+        const Task& m_task;
+    };
+
+    template <class T>
+    TaskContext::DependencyAwaiter<T> TaskContext::dependency(const Task& task)
+    {
+        return DependencyAwaiter<T>(*this, task);
+    }
 }
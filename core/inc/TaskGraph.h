@@ -13,7 +13,9 @@
 #include "TaskGraph_info.h"
 
 /// USER_SECTION_START 2
+#include "CoTask.h"
 #include "Task.h"
 #include "TaskScheduler.h"
+#include "ProcessTask.h"
 
 /// USER_SECTION_END
\ No newline at end of file
@@ -22,7 +22,7 @@
 #define TOSTRING(x) STRINGIFY(x)
 
 /// USER_SECTION_START 2
-
+#include "CpuQuota.h"
 /// USER_SECTION_END
 
 class QWidget;
@@ -122,7 +122,9 @@ namespace TaskGraph
 		static QWidget *createInfoWidget(QWidget* parent = nullptr, bool disableHyperlink = false);
 
 /// USER_SECTION_START 5
-
+		// Worker count a default-constructed TaskScheduler gets on this machine and the
+		// limit that determined it (hardware_concurrency, affinity mask, cgroup CPU quota).
+		static DefaultThreadCount getDefaultThreadCount();
 /// USER_SECTION_END
 	};
 
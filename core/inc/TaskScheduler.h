@@ -2,6 +2,11 @@
 
 #include "TaskGraph_base.h"
 #include "Task.h"
+#include "TimerService.h"
+#include "IoReactor.h"
+#include "FileIoService.h"
+#include "PressureMonitor.h"
+#include "CpuQuota.h"
 #include <QObject>
 #include <QString>
 #include <QVariant>
@@ -10,11 +15,15 @@
 #include <mutex>
 #include <condition_variable>
 #include <deque>
+#include <map>
 #include <atomic>
+#include <chrono>
 #include <unordered_map>
 #include <unordered_set>
 #include <functional>
 #include <memory>
+#include <exception>
+#include <cstdint>
 
 namespace Log { class LogObject; }
 
@@ -74,12 +83,112 @@ namespace TaskGraph
             ContinueOthers
         };
 
-        TaskScheduler(size_t threadCount = std::thread::hardware_concurrency(), Log::LogObject* logger = nullptr);
+        /// <summary>
+        /// How ready tasks are handed to the worker threads.
+        /// SharedQueue: one FIFO ready queue guarded by the scheduler mutex (default).
+        /// WorkStealing: every worker owns a deque. Successors unblocked by a task are
+        /// pushed onto the completing worker's deque and popped LIFO by that worker;
+        /// idle workers steal FIFO from random victims.
+        /// </summary>
+        enum class ExecutionMode : int
+        {
+            SharedQueue = 0,
+            WorkStealing
+        };
+
+        /// <summary>
+        /// Order in which ready tasks are dispatched.
+        /// Fifo: in the order they became ready (default).
+        /// CriticalPath: highest upward rank first, i.e. the longest remaining path to a
+        /// sink. A task's cost is its last measured duration (Task::getLastDuration) or,
+        /// before it ever ran, its weight scaled to the measured tasks. In WorkStealing
+        /// mode the rank orders the shared injection queue and the initial roots; each
+        /// worker's own deque stays LIFO.
+        /// </summary>
+        enum class SchedulingPolicy : int
+        {
+            Fifo = 0,
+            CriticalPath
+        };
+
+        /// <summary>
+        /// What a worker does when it finds no ready task.
+        /// Blocking: park on a condition variable right away (default, no CPU use while idle).
+        /// SpinThenPark: poll for new work for the idle spin duration (CPU pause hint),
+        /// yield a few times, then park. Hides the wake-up latency between dependent
+        /// tiny tasks at the cost of some CPU time on idle workers.
+        /// BusyPoll: poll for as long as a run is active and park only between runs.
+        /// Lowest latency, but every idle worker keeps its core busy; meant for
+        /// dedicated cores.
+        /// </summary>
+        enum class IdlePolicy : int
+        {
+            Blocking = 0,
+            SpinThenPark,
+            BusyPoll
+        };
+
+        /// <summary>
+        /// How TaskContext::fileIo / fileIoThen reach the kernel.
+        /// Auto: io_uring where the kernel allows it, else a small I/O thread pool.
+        /// ThreadPool: always the I/O thread pool (blocking pread / pwrite / fsync).
+        /// </summary>
+        enum class FileIoBackend : int
+        {
+            Auto = 0,
+            ThreadPool
+        };
+
+        /// <summary>
+        /// Adaptive concurrency. While enabled, the scheduler samples the host pressure
+        /// (PressureSample) every `interval` during a run and changes how many of its
+        /// workers may pick up tasks, without stopping any thread: a worker above the
+        /// limit finishes its current task and parks. After `samples` consecutive samples
+        /// above `lowerAbove` the limit drops by a quarter (at least one worker, not
+        /// below `minThreads`); after `samples` consecutive samples below `raiseBelow`
+        /// it grows by one worker, up to getThreadCount(). Samples in between reset both
+        /// streaks. The limit carries over to the next run.
+        /// </summary>
+        struct AdaptiveConcurrency
+        {
+            bool enabled = false;
+            std::chrono::milliseconds interval{ 500 };
+            double lowerAbove = 0.20;
+            double raiseBelow = 0.05;
+            unsigned int samples = 2;
+            unsigned int minThreads = 1;
+        };
+
+        /// <summary>
+        /// Returns the pressure of the last interval. The default probe reads Linux PSI
+        /// (Internal::PressureMonitor); elsewhere its samples are invalid and the limit
+        /// stays where it is.
+        /// </summary>
+        using PressureProbe = std::function<PressureSample()>;
+
+        /// <summary>
+        /// Thread count argument: size the pool by detectDefaultThreadCount() instead of a
+        /// fixed number. Such a pool re-detects the count (at most once a second) when a
+        /// run starts and follows a changed CPU quota or affinity mask.
+        /// </summary>
+        static constexpr size_t autoThreadCount = SIZE_MAX;
+
+        TaskScheduler(size_t threadCount = autoThreadCount, Log::LogObject* logger = nullptr);
         ~TaskScheduler();
 
         bool enableThreads(size_t threadCount);
         bool disableThreads();
 
+        /// <summary>
+        /// The CPUs this process may use: the smallest of hardware_concurrency(), the
+        /// sched_getaffinity mask and the cgroup v2 / v1 CPU quota (rounded up), with the
+        /// limit that determined it. Inside a container with a 4-CPU quota this is 4, not
+        /// the host's core count.
+        /// </summary>
+        static DefaultThreadCount detectDefaultThreadCount();
+        /// <summary>Where the current thread count came from (Explicit unless autoThreadCount).</summary>
+        ThreadCountSource getThreadCountSource() const { return m_threadCountSource.load(std::memory_order_acquire); }
+
         bool addTask(const std::shared_ptr<Task>& task);
         bool removeTask(const std::shared_ptr<Task>& task);
 
@@ -100,6 +209,17 @@ namespace TaskGraph
         /// </summary>
         void setContextFactory(ContextFactory factory) { m_contextFactory = std::move(factory); }
 
+        /// <summary>
+        /// Freezes the current topology into an execution plan (dense, index-based
+        /// successor arrays and initial in-degrees). Later runs of the same graph only
+        /// reset counters instead of rebuilding the graph. Any addTask, removeTask or
+        /// Task::addDependency/clearDependencies invalidates the plan; runTasks then
+        /// compiles again on its own, so calling compile() is optional.
+        /// Returns false (see getLastError) if the graph is invalid or the scheduler is running.
+        /// </summary>
+        bool compile();
+        bool isCompiled() const;
+
         void runTasks();
         void runTasksAsync();
 
@@ -115,11 +235,171 @@ namespace TaskGraph
         void setFailurePolicy(FailurePolicy p) { m_failurePolicy.store(p, std::memory_order_release); }
         FailurePolicy getFailurePolicy() const { return m_failurePolicy.load(std::memory_order_acquire); }
 
+        /// <summary>Select the dispatch mode. Rejected with Error::busy while running.</summary>
+        bool setExecutionMode(ExecutionMode mode);
+        ExecutionMode getExecutionMode() const { return m_executionMode.load(std::memory_order_acquire); }
+        /// <summary>
+        /// Mode of the schedulers constructed from now on (SharedQueue unless set).
+        /// Existing schedulers keep theirs.
+        /// </summary>
+        static void setDefaultExecutionMode(ExecutionMode mode);
+        static ExecutionMode getDefaultExecutionMode();
+
+        /// <summary>Select the ready-queue order. Rejected with Error::busy while running.</summary>
+        bool setSchedulingPolicy(SchedulingPolicy policy);
+        SchedulingPolicy getSchedulingPolicy() const { return m_schedulingPolicy.load(std::memory_order_acquire); }
+
+        /// <summary>
+        /// Starvation guard for Task::setPriority: a ready task gains one priority level
+        /// per `interval` it waits, so it is eventually dispatched before newer tasks of a
+        /// higher priority. Zero (default) disables aging: a higher priority always wins.
+        /// Rejected with Error::busy while running.
+        /// </summary>
+        bool setPriorityAging(std::chrono::milliseconds interval);
+        std::chrono::milliseconds getPriorityAging() const { return std::chrono::milliseconds(m_priorityAgingMs.load(std::memory_order_acquire)); }
+
+        /// <summary>
+        /// Worker pool counters, accumulated over all runs until resetStats().
+        /// A worker is woken only for newly ready work: one notification per task that
+        /// became ready, minus the one the completing worker picks up itself.
+        /// </summary>
+        struct Stats
+        {
+            uint64_t tasksExecuted = 0;   // tasks taken from a ready queue and executed
+            uint64_t notifications = 0;   // sleeping workers signalled
+            uint64_t parks = 0;           // times a worker blocked waiting for work
+            uint64_t wakeups = 0;         // times a blocked worker woke up
+            uint64_t spuriousWakeups = 0; // wakeups after which the worker blocked again without running a task
+            uint64_t steals = 0;          // tasks taken from another worker's deque (WorkStealing)
+            uint64_t spinHits = 0;        // times an idle worker found new work while spinning (IdlePolicy)
+            uint64_t handoffs = 0;        // successors run directly by the completing worker
+            uint64_t retriesParked = 0;   // failed attempts parked until their retry backoff expired
+            uint64_t joinHelps = 0;       // tasks executed by a thread waiting in TaskContext::join
+            uint64_t loopHelps = 0;       // TaskContext::parallelFor chunks run by a worker for another task
+            uint64_t suspensions = 0;     // coroutine bodies that gave their worker back while waiting
+            uint64_t yields = 0;          // bodies that gave their worker to waiting work at a yield point
+            uint64_t compensations = 0;   // workers started or woken to stand in for one in a BlockingScope
+            uint64_t resourceWaits = 0;   // tasks set aside until a resource pool had units free
+            uint64_t peakMemoryInUse = 0; // highest sum of memory estimates of running tasks, in bytes
+            uint64_t concurrencyChanges = 0; // adaptive concurrency limit raised or lowered
+        };
+        Stats getStats() const;
+        void resetStats();
+
+        /// <summary>Select the idle strategy of the workers. Rejected with Error::busy while running.</summary>
+        bool setIdlePolicy(IdlePolicy policy);
+        IdlePolicy getIdlePolicy() const { return m_idlePolicy.load(std::memory_order_acquire); }
+
+        /// <summary>
+        /// How long an idle worker polls before it parks under IdlePolicy::SpinThenPark
+        /// (default 50 us). Rejected with Error::busy while running.
+        /// </summary>
+        bool setIdleSpinDuration(std::chrono::microseconds duration);
+        std::chrono::microseconds getIdleSpinDuration() const { return std::chrono::microseconds(m_idleSpinUs.load(std::memory_order_acquire)); }
+
+        /// <summary>
+        /// When a task completes on a worker and makes successors ready, the worker runs
+        /// one of them next itself instead of queueing it, while the data the task
+        /// produced is still in its cache; the others are queued as usual. GUI-affine
+        /// successors are never handed off, and a successor is queued normally if a
+        /// queued task outranks it (priority, critical path). On by default.
+        /// Rejected with Error::busy while running.
+        /// </summary>
+        bool setSuccessorHandoff(bool enabled);
+        bool getSuccessorHandoff() const { return m_successorHandoff.load(std::memory_order_acquire); }
+
+        /// <summary>
+        /// Lets the thread calling runTasks() execute ready tasks alongside the pool
+        /// until the run completes, instead of sleeping until the workers are done.
+        /// GUI-affine tasks are still marshalled to the GUI thread, unless the caller is
+        /// the GUI thread itself. Off by default. runTasksAsync() is not affected: with a
+        /// pool it uses no coordinator thread at all.
+        /// Rejected with Error::busy while running.
+        /// </summary>
+        bool setCallerParticipates(bool enabled);
+        bool getCallerParticipates() const { return m_callerParticipates.load(std::memory_order_acquire); }
+
+        /// <summary>
+        /// Time slice of a long task body: TaskContext::shouldYield() / yield() report true
+        /// once the body has run this long since it was last dispatched and a queued task
+        /// is waiting that is not outranked by it (older, or of higher priority). Default
+        /// 10 ms; zero yields at every check-in while work waits. Rejected with
+        /// Error::busy while running.
+        /// </summary>
+        bool setTimeSlice(std::chrono::microseconds slice);
+        std::chrono::microseconds getTimeSlice() const { return std::chrono::microseconds(m_timeSliceUs.load(std::memory_order_acquire)); }
+
+        /// <summary>
+        /// Upper limit of compensating workers that stand in for workers blocked in a
+        /// TaskContext::BlockingScope (default 8, 0 disables compensation). They are
+        /// not part of getThreadCount(). Rejected with Error::busy while running.
+        /// </summary>
+        bool setMaxCompensatingThreads(size_t count);
+        size_t getMaxCompensatingThreads() const { return m_maxCompensatingThreads.load(std::memory_order_acquire); }
+
+        /// <summary>
+        /// Configure adaptive concurrency (see AdaptiveConcurrency). Disabling it lets
+        /// all workers pick up tasks again. Rejected with Error::busy while running.
+        /// </summary>
+        bool setAdaptiveConcurrency(const AdaptiveConcurrency& settings);
+        AdaptiveConcurrency getAdaptiveConcurrency() const;
+        /// <summary>
+        /// Replace the pressure source, e.g. with an application metric or a fixed
+        /// sample in tests; {} restores the PSI probe. Called on the timer thread.
+        /// Rejected with Error::busy while running.
+        /// </summary>
+        bool setPressureProbe(PressureProbe probe);
+        /// <summary>Workers currently allowed to pick up tasks (getThreadCount() when not adaptive).</summary>
+        unsigned int getConcurrencyLimit() const;
+        /// <summary>The latest pressure sample (invalid before the first one).</summary>
+        PressureSample getLastPressure() const;
+
+        /// <summary>
+        /// Named resource pool, e.g. setResourceCapacity("disk", 2). A task that needs
+        /// units of it (Task::setResourceRequirement) starts only while they are free;
+        /// until then it waits without holding a worker, and waiting tasks get freed
+        /// units in the order they started waiting. A requirement above the capacity is
+        /// clamped to it, so the task runs alone on that pool. Capacity 0 removes the
+        /// pool. Rejected with Error::busy while running.
+        /// </summary>
+        bool setResourceCapacity(const std::string& resource, size_t capacity);
+        /// <summary>Capacity of the pool, 0 if it is not defined.</summary>
+        size_t getResourceCapacity(const std::string& resource) const;
+        /// <summary>Units held by running tasks.</summary>
+        size_t getResourceInUse(const std::string& resource) const;
+
+        /// <summary>
+        /// Scheduler-wide memory budget in bytes. A task with a memory estimate
+        /// (Task::setMemoryEstimate) starts only while the estimates of the running
+        /// tasks plus its own stay within the budget, and waits like a task of a full
+        /// resource pool otherwise. An estimate above the budget counts as the whole
+        /// budget, so the task runs once no other estimated task does. Zero (default)
+        /// admits everything. Rejected with Error::busy while running.
+        /// </summary>
+        bool setMemoryBudget(uint64_t bytes);
+        uint64_t getMemoryBudget() const;
+        /// <summary>Sum of the memory estimates of the running tasks (clamped to the budget).</summary>
+        uint64_t getMemoryInUse() const;
+
+        /// <summary>Select the file I/O backend. Rejected with Error::busy while running.</summary>
+        bool setFileIoBackend(FileIoBackend backend);
+        FileIoBackend getFileIoBackend() const;
+        /// <summary>"io_uring", "thread pool", or "none" before the first file operation.</summary>
+        std::string getActiveFileIoBackend() const;
+
         int getProgress() const { return m_progress; }
         float getProgressF() const { return m_progressF.load(std::memory_order_acquire); }
         bool isRunning() const { return m_isRunning.load(std::memory_order_acquire); }
         unsigned int getThreadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+        /// <summary>
+        /// Workers computing a task, compensating workers included. A worker blocked in
+        /// TaskContext::askGui or a TaskContext::BlockingScope is not counted.
+        /// </summary>
         unsigned int getBusyThreadCount() const;
+        /// <summary>Threads of this scheduler inside a TaskContext::BlockingScope.</summary>
+        unsigned int getBlockedThreadCount() const { return m_blockedThreads.load(std::memory_order_acquire); }
+        /// <summary>Compensating workers currently standing in for blocked ones.</summary>
+        unsigned int getCompensatingThreadCount() const;
         size_t getTotalTasks() const;
 
         Error getLastError() const { return m_lastError.load(std::memory_order_acquire); }
@@ -144,6 +424,49 @@ namespace TaskGraph
         /// </summary>
         QVariant waitForGuiResponse(int requestId, Task* task, const QVariant& payload);
 
+        /// <summary>
+        /// Helping wait called from a task body via TaskContext::join / spawnAndWait.
+        /// With `spawn` the tasks are first inserted as by addDynamicTask. Executes
+        /// ready tasks on the calling thread until all `tasks` are finished. Returns
+        /// false on validation failure or if a task did not end Done.
+        /// </summary>
+        bool joinTasks(const std::vector<std::shared_ptr<Task>>& tasks, Task* waiter, bool spawn);
+
+        /// <summary>
+        /// Chunked loop behind TaskContext::parallelFor / parallelReduce. `grain` must be
+        /// resolved (non-zero). Idle workers pick up chunks while the caller runs them too.
+        /// </summary>
+        bool runParallelLoop(const TaskContext& ctx, size_t begin, size_t end, size_t grain,
+                             const std::function<void(size_t, size_t, size_t)>& body);
+        size_t parallelGrain(size_t count, size_t grain) const;
+
+        /// <summary>
+        /// Suspension points of the TaskContext awaitables, called from a coroutine body
+        /// of `waiter`/`task` right before it suspends. Each registers the wake that
+        /// queues the task again. isTaskSettled throws std::runtime_error if `awaited` is
+        /// the waiter or (transitively) depends on it; a task outside the run counts as settled.
+        /// </summary>
+        bool isTaskSettled(Task* waiter, const Task& awaited);
+        void suspendUntilSettled(Task* waiter, const Task& awaited);
+        void suspendFor(Task* task, std::chrono::milliseconds delay);
+        int suspendForGui(Task* task, const QVariant& payload);
+        QVariant takeGuiResponse(int requestId);
+        // Watches `fd` on m_reactor; `ready` receives the events, or -1 (woken at once)
+        // if the fd cannot be watched. endFdWait removes a watch that did not fire.
+        uint64_t suspendForFd(Task* task, int fd, int events, std::shared_ptr<std::atomic<int>>& ready);
+        void endFdWait(uint64_t watch);
+        // TaskContext::BlockingScope. beginBlocking returns false if the calling thread
+        // is not counted (not a thread of a running run); endBlocking only follows true.
+        // Only the outermost guard of a thread blocks and compensates.
+        bool beginBlocking();
+        void endBlocking();
+        // Time-slice check of TaskContext::shouldYield; `sliceStart` is the last dispatch.
+        bool shouldYield(Task* task, std::chrono::steady_clock::time_point sliceStart);
+        // Marks the coroutine of `task` to be queued again once it has suspended.
+        void suspendForYield(Task* task);
+        // Runs `request` on m_fileIo; the wait cannot be interrupted by cancel or timeout.
+        void suspendForFileIo(Task* task, const FileIoRequest& request, std::shared_ptr<std::atomic<long>>& result);
+
         public slots:
         void respondToGuiEvent(int requestId, const QVariant& response);
 
@@ -168,17 +491,292 @@ namespace TaskGraph
         void taskFailed(QString taskName, QString error);
         void errorRaised(QString error);
 
+        // Adaptive concurrency changed the number of workers allowed to pick up tasks
+        // (emitted on the timer thread; `reason` names the pressure behind it).
+        void concurrencyLimitChanged(unsigned int limit, QString reason);
+
         private:
         Error buildTaskGraph(std::vector<TaskList> &taskGraph) const;
 
+        // Units of a named resource pool (or bytes of the memory budget).
+        struct ResourcePool
+        {
+            size_t capacity = 0;
+            size_t inUse = 0;
+        };
+
+        // Per-run bookkeeping for one task. The join counter and the retirement
+        // flag are atomics so that completions on independent branches never
+        // serialize on the scheduler mutex: readiness is decided by a single
+        // fetch_sub on `pending`.
+        struct RunNode
+        {
+            std::shared_ptr<Task> task;
+            // Dense plan index; nodes spawned during a run lie past the plan.
+            size_t index = 0;
+            // Spawned for this run only (fork-join): never added to the graph.
+            bool runOnly = false;
+            // Upward rank (SchedulingPolicy::CriticalPath), aged priority and enqueue
+            // order, used by ReadyQueue; only written while the node is not queued.
+            double rank = 0.0;
+            double priorityKey = 0.0;
+            uint64_t readySeq = 0;
+            // Positive priority in WorkStealing mode: queued in the injection queue
+            // and taken by workers before their own deque.
+            bool urgent = false;
+            std::atomic<int> pending{0};
+            // Set once the node has been counted towards m_remaining.
+            std::atomic<bool> retired{false};
+            // Guards `dependents` against dynamic spawns. Once sealed (the node
+            // reached a terminal state) the list is immutable and walked lock-free.
+            std::mutex edgeMutex;
+            bool sealed = false;
+            // Dependents attached by dynamic spawns. Compiled dependents live in the plan.
+            std::vector<RunNode*> dependents;
+            // Retries used in this run, and the task's context while a retry is parked
+            // or a coroutine body is suspended.
+            int retryAttempt = 0;
+            std::unique_ptr<TaskContext> context;
+            // Suspended coroutine body and its wake state (flags guarded by m_mutex).
+            // coWaiting: a wake is expected, coSeq tells a stale wake from the current
+            // one. coReleased: the executing thread gave the node up, so the waker
+            // queues it; otherwise the waker sets coWoken and the thread resumes it
+            // right away. coPinned: the wait must run to completion (file I/O into the
+            // body's buffer), so cancel and the watchdog do not wake it.
+            CoTask coroutine;
+            Internal::TimerService::TimerId coWatchdog = Internal::TimerService::invalidTimer;
+            uint64_t coSeq = 0;
+            bool coWaiting = false;
+            bool coReleased = false;
+            bool coWoken = false;
+            bool coPinned = false;
+            // Suspended at a yield point: queued behind the waiting work, not resumed inline.
+            bool coYielded = false;
+            // Resource pool units needed (resolved at run start, clamped to the capacity)
+            // and whether they are held; both guarded by m_mutex during a run.
+            std::vector<std::pair<ResourcePool*, size_t>> resourceNeeds;
+            bool holdsResources = false;
+            // Wakes of coroutines awaiting this node, fired once it is sealed (edgeMutex).
+            std::vector<std::function<void()>> settleWaiters;
+        };
+        using NodeDeque = std::deque<RunNode*>;
+
+        // Topology frozen by compile(), in CSR form: the successors of node i are
+        // successors[successorOffsets[i] .. successorOffsets[i + 1]). Immutable while
+        // running, so it is read without locks.
+        struct ExecutionPlan
+        {
+            bool valid = false;
+            // Sum of Task::getTopologyVersion() over all tasks at compile time.
+            uint64_t topologyVersion = 0;
+            std::vector<size_t> successorOffsets;
+            std::vector<RunNode*> successors;
+            std::vector<int> initialPending;
+            std::vector<RunNode*> roots;
+            // Topological order (layer by layer), walked backwards to compute ranks.
+            std::vector<RunNode*> order;
+        };
+
+        // Shared ready queue (the injection queue in WorkStealing mode). A plain FIFO
+        // until ordering is needed, then a binary heap on (aged priority, rank,
+        // enqueue order). It switches to the heap on its own when the first task with
+        // a non-zero priority arrives. Aging subtracts the enqueue time (in aging
+        // intervals) from the priority: all waiting tasks age at the same rate, so the
+        // key is fixed at push time and the heap stays valid.
+        class ReadyQueue
+        {
+            public:
+            // Called at run start on an empty queue.
+            void configure(bool ordered, std::chrono::microseconds aging);
+            bool empty() const { return m_fifo.empty() && m_heap.empty(); }
+            // Written under the scheduler mutex only, but may be read without it.
+            bool isOrdered() const { return m_ordered.load(std::memory_order_acquire); }
+            void push(RunNode* node);
+            // True if `node`, pushed now, would be popped before every queued node.
+            // Only meaningful for an ordered queue; assigns the node's key.
+            bool outranksQueued(RunNode* node);
+            RunNode* pop();
+            void clear();
+            // Moves every queued node to the back of `out`.
+            void drainTo(NodeDeque& out);
+
+            private:
+            static bool lowerPriority(const RunNode* a, const RunNode* b);
+            void assignKey(RunNode* node);
+
+            std::atomic<bool> m_ordered{false};
+            std::chrono::microseconds m_aging{0};
+            std::chrono::steady_clock::time_point m_epoch;
+            uint64_t m_sequence = 0;
+            NodeDeque m_fifo;
+            std::vector<RunNode*> m_heap;
+        };
+
+        // Retirements collected while walking nodes. Applied to the shared
+        // counters in one step once no node is touched anymore.
+        struct RetireBatch
+        {
+            size_t count = 0;
+            double weight = 0.0;
+            // Settle waiters of the sealed nodes, fired outside of any lock.
+            std::vector<std::function<void()>> wakes;
+        };
+
+        Error compileLocked();
+        uint64_t topologyVersion() const;
+        template <typename Fn>
+        void forEachDependent(RunNode* node, Fn&& fn);
+
+        void computeRanks();
+        double taskCost(const Task& task) const;
+
         void ensureThreadsSpawned();
+        // Grows or shrinks the pool to `threadCount` workers (not while running).
+        void resizeWorkers(size_t threadCount);
+        // An autoThreadCount pool follows a changed CPU limit; called when a run starts.
+        void refreshDefaultThreadCount();
         void runTasksBody();
-        void onTaskCompleted(const std::shared_ptr<Task>& task);
-        void skipDescendantsLocked(Task* root);
-        void cancelPendingLocked();
+        // Run setup up to the seeded ready queues. With finishOnDrain the thread that
+        // retires the last task calls finishRun(); otherwise the caller does.
+        bool beginRun(bool finishOnDrain);
+        void finishRun();
+        // Removes the nodes spawned during the run that just ended.
+        void dropSpawnedNodes();
+        void participateUntilDrained();
+        // Sleeps until work is queued (returns true) or the run drained (false).
+        bool waitForWorkOrDrain();
+        // Wakes threads waiting in joinTasks; called whenever nodes are retired.
+        void wakeJoiners();
+        // True if `node` is `waiter` or reaches it through unretired dependencies.
+        bool waitsForLocked(RunNode* node, const Task* waiter);
+        // addDynamicTask; a `runOnly` child is dropped when the run ends.
+        bool insertDynamicTask(const std::shared_ptr<Task>& child, Task* parent, bool runOnly);
+
+        // A parallelFor in progress. Chunks are claimed through `nextChunk`; helpers
+        // register under m_mutex while the loop is listed in m_loops, so once it is
+        // delisted `helpers` only falls and the caller waits for it to reach zero.
+        struct ParallelLoop
+        {
+            const TaskContext* ctx = nullptr;
+            const std::function<void(size_t, size_t, size_t)>* body = nullptr;
+            size_t begin = 0;
+            size_t end = 0;
+            size_t grain = 1;
+            size_t chunkCount = 0;
+            std::atomic<size_t> nextChunk{0};
+            // Set by a cancel request or a throwing chunk: no further chunk starts.
+            std::atomic<bool> stopped{false};
+            std::atomic<size_t> finished{0};
+            std::mutex mutex;
+            std::condition_variable cv;
+            size_t helpers = 0;
+            std::exception_ptr error;
+        };
+        void runLoopChunks(ParallelLoop& loop, bool helping);
+        void delistLoop(const std::shared_ptr<ParallelLoop>& loop);
+        // Runs chunks of the newest open loop. False if none is open.
+        bool helpParallelLoop();
+        // Both return the successor handed off to the calling worker (or nullptr),
+        // already counted in m_inFlight.
+        RunNode* executeNode(RunNode* node);
+        RunNode* onTaskCompleted(RunNode* node);
+        std::unique_ptr<TaskContext> makeContext(Task* task);
+
+        // Coroutine bodies (Task::setCoroutineFunction). A suspended body leaves
+        // m_inFlight but stays in m_remaining; the wake returned by beginSuspend()
+        // queues the node again and the next worker resumes the frame.
+        RunNode* executeCoroutine(RunNode* node);
+        std::function<void()> beginSuspend(Task* task, bool interruptible = true);
+        // seq 0 wakes whatever wait is current (the timeout watchdog).
+        void wakeCoroutine(RunNode* node, uint64_t seq, uint64_t run);
+        // True if the node has to be queued by the caller.
+        bool wakeCoroutineLocked(RunNode* node);
+        bool canHandOff(RunNode* successor);
+
+        // Failed attempts with a retry backoff leave the worker and wait on m_timers;
+        // requeueRetry puts them back into the ready queue.
+        std::chrono::milliseconds retryDelay(const Task& task, int attempt) const;
+        void parkForRetry(RunNode* node, std::unique_ptr<TaskContext> ctx, std::chrono::milliseconds delay);
+        void requeueRetry(RunNode* node, uint64_t run);
+        bool retire(RunNode* node, RetireBatch& batch);
+        void seal(RunNode* node, RetireBatch& batch);
+        void commitRetired(const RetireBatch& batch);
+        void finishInFlight();
+        void notifyIfRunDrained();
+        void skipDescendants(RunNode* root, RetireBatch& batch);
+        // Returns the number of woken coroutines it left queued.
+        size_t cancelPendingLocked(RetireBatch& batch);
+
+        // Per-worker deque used by ExecutionMode::WorkStealing. The owner pushes and
+        // pops at the back, thieves take from the front.
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            NodeDeque tasks;
+        };
 
-        // Arms a detached watchdog for `task` if a positive timeout is configured.
-        void armWatchdog(const std::shared_ptr<Task>& task);
+        // Queues visible to thieves. Published as an immutable snapshot so idle
+        // workers never read m_workerQueues while the pool is being resized.
+        struct StealTargets
+        {
+            std::vector<WorkerQueue*> queues;
+        };
+
+        void spawnWorker(size_t index);
+
+        // Resource pools: resolveResourcesLocked fills node.resourceNeeds. acquireResources
+        // takes the units or sets the node aside in m_resourceWaiters (releasing the
+        // worker) and returns false. releaseResources hands freed units to the waiters
+        // and queues those that got theirs.
+        void resolveResourcesLocked(RunNode& node);
+        bool acquireResources(RunNode* node);
+        void releaseResources(RunNode* node);
+        bool resourcesFreeLocked(const RunNode* node) const;
+        void takeResourcesLocked(RunNode* node);
+        void returnResourcesLocked(RunNode* node);
+
+        // A thread standing in for a worker blocked in a BlockingScope. Between
+        // activations it sleeps as a spare on m_cvCompensator.
+        struct Compensator
+        {
+            std::shared_ptr<std::thread> thread;
+            // Makes the worker loop return after the current task.
+            std::shared_ptr<std::atomic<bool>> exit;
+            bool active = false; // guarded by m_compensatorMutex
+        };
+        static void compensatorThreadFunction(TaskScheduler* obj, Compensator* compensator);
+        void stopCompensators();
+        void publishStealTargets(size_t count);
+        // Frees the replaced steal snapshots once no thief can still read them.
+        void releaseStealTargets();
+        void enqueueReady(RunNode* node);
+        void enqueueReadyLocked(RunNode* node);
+        // Adaptive concurrency: a pool worker with an index at or above the limit
+        // does not pick up tasks. Compensators and the caller are never throttled.
+        bool isThrottled(int threadIndex) const
+        {
+            return threadIndex >= 0 && static_cast<size_t>(threadIndex) >= m_concurrencyLimit.load(std::memory_order_acquire);
+        }
+        // Arms the next pressure sample of run `run`; the first one only primes the probe.
+        void armPressureSample(uint64_t run, bool prime);
+        void samplePressure(uint64_t run, bool prime);
+        // Signals up to `newTasks` sleeping workers (all of them if fewer are asleep).
+        void wakeWorkers(size_t newTasks);
+        // Polls for queued work according to the idle policy. Returns true if work
+        // showed up, false once the worker should park.
+        bool spinForWork(const std::atomic<bool>& localExit);
+        RunNode* popLocalOrSteal(WorkerQueue* own, uint32_t& rng);
+        // One ready node for a thread helping out (participating caller, joining
+        // task), or nullptr. `own` is the caller's deque, if it has one.
+        RunNode* takeReadyNode(WorkerQueue* own, uint32_t& rng);
+        RunNode* popReadyLocked();
+        RunNode* popUrgent();
+        void clearReadyQueuesLocked();
+
+        // Arms a timeout on m_timers for `task` if a positive timeout is configured.
+        // The returned id must be disarmed once the attempt has returned. With
+        // `coroutine` a body suspended at the deadline is woken to see the timeout.
+        Internal::TimerService::TimerId armWatchdog(const std::shared_ptr<Task>& task, RunNode* coroutine = nullptr);
 
         TaskList m_allTasks;
         mutable std::vector<TaskList> m_taskGraph;
@@ -189,32 +787,137 @@ namespace TaskGraph
         std::condition_variable m_cvTask;
         std::condition_variable m_cvComplete;
         bool m_stopThreads;
-        unsigned int m_busyThreads;
+        std::atomic<unsigned int> m_busyThreads;
+        std::atomic<unsigned int> m_idleWorkers{0};
         std::atomic<bool> m_isRunning;
         std::atomic<bool> m_paused;
         std::atomic<bool> m_cancelRequested;
-        bool m_aborting;
+        std::atomic<bool> m_aborting;
         size_t m_desiredThreadCount;
+        bool m_autoThreadCount = false;
+        std::atomic<ThreadCountSource> m_threadCountSource{ThreadCountSource::Explicit};
+        std::chrono::steady_clock::time_point m_threadCountCheckedAt;
         std::atomic<int> m_progress;
         std::atomic<float> m_progressF;
 
-        TaskDeque m_readyQueue;
-        std::unordered_map<Task*, int> m_inDegree;
-        std::unordered_map<Task*, std::vector<Task*>> m_dependents;
-        std::unordered_map<Task*, std::shared_ptr<Task>> m_aliveByPtr;
-        size_t m_totalTasks;
-        size_t m_remaining;
-
-        double m_weightSum;
-        double m_completedWeight;
+        ReadyQueue m_readyQueue;
+        std::atomic<ExecutionMode> m_executionMode{ExecutionMode::SharedQueue};
+        std::atomic<SchedulingPolicy> m_schedulingPolicy{SchedulingPolicy::Fifo};
+        std::atomic<int64_t> m_priorityAgingMs{0};
+        // Urgent nodes in m_readyQueue (WorkStealing only).
+        std::atomic<size_t> m_urgentQueued{0};
+        // Cost per unit of weight for tasks without a measured duration; set by computeRanks.
+        double m_costPerWeight = 1.0;
+        // Fixed for the duration of a run: WorkStealing selected and workers exist.
+        std::atomic<bool> m_stealingRun{false};
+        // Worker deques are never destroyed before the scheduler. Replaced steal
+        // snapshots stay in the history while a thief may still read them.
+        std::vector<std::unique_ptr<WorkerQueue>> m_workerQueues;
+        std::vector<std::unique_ptr<StealTargets>> m_stealTargetHistory;
+        std::atomic<StealTargets*> m_stealTargets{nullptr};
+        // Threads inside popLocalOrSteal's victim probe.
+        std::atomic<unsigned int> m_stealReaders{0};
+        // Ready tasks across all worker deques plus m_readyQueue. Lets idle workers
+        // poll for work without taking any lock.
+        std::atomic<size_t> m_queuedTasks{0};
+        std::atomic<IdlePolicy> m_idlePolicy{IdlePolicy::Blocking};
+        std::atomic<int64_t> m_idleSpinUs{50};
+        std::atomic<bool> m_successorHandoff{true};
+        std::atomic<bool> m_callerParticipates{false};
+        std::atomic<int64_t> m_timeSliceUs{10000};
+        std::atomic<size_t> m_maxCompensatingThreads{8};
+        std::atomic<unsigned int> m_blockedThreads{0};
+        mutable std::mutex m_compensatorMutex;
+        std::condition_variable m_cvCompensator;
+        std::vector<std::unique_ptr<Compensator>> m_compensators;
+        size_t m_activeCompensators = 0;
+        bool m_stopCompensators = false;
+        // The participating caller waits on m_cvComplete; set while it does.
+        std::atomic<bool> m_callerIdle{false};
+        // Task bodies blocked in joinTasks wait on m_cvJoin.
+        std::condition_variable m_cvJoin;
+        std::atomic<unsigned int> m_joinWaiters{0};
+        // Loops with unclaimed chunks, newest last; m_openLoops mirrors the size.
+        std::vector<std::shared_ptr<ParallelLoop>> m_loops;
+        std::atomic<size_t> m_openLoops{0};
+        // Asynchronous run: finished by the draining thread, exactly once.
+        std::atomic<bool> m_finishOnDrain{false};
+        std::atomic<bool> m_finishClaimed{false};
+        // Incremented per run under m_mutex; stale retry timers compare against it.
+        uint64_t m_runGeneration = 0;
+        std::atomic<size_t> m_parkedRetries{0};
+
+        // Run nodes live in a deque so their addresses stay stable while dynamic
+        // spawns append. They are built by compile() and reused across runs.
+        // m_nodes, m_nodeOf and m_plan are only modified under m_mutex.
+        ExecutionPlan m_plan;
+        std::deque<RunNode> m_nodes;
+        std::unordered_map<Task*, RunNode*> m_nodeOf;
+        // Resource pools by name (a map: nodes point at its values) and the nodes
+        // waiting for units, oldest first. Guarded by m_mutex.
+        std::map<std::string, ResourcePool> m_resources;
+        // The memory budget as a pool of bytes; without a budget its capacity is
+        // unlimited and it only measures.
+        ResourcePool m_memory{ SIZE_MAX, 0 };
+        NodeDeque m_resourceWaiters;
+        std::atomic<size_t> m_totalTasks;
+        std::atomic<size_t> m_remaining;
+        // Nodes taken from a ready queue whose completion has not finished yet. A
+        // run only ends once this and m_remaining are both zero, so no worker can
+        // still be touching a node when the next run rebuilds m_nodes.
+        std::atomic<size_t> m_inFlight{0};
+
+        std::atomic<double> m_weightSum;
+        std::atomic<double> m_completedWeight;
 
         ContextFactory m_contextFactory;
 
+        // Backing store of getStats(); relaxed, they are only diagnostics.
+        struct StatCounters
+        {
+            std::atomic<uint64_t> tasksExecuted{0};
+            std::atomic<uint64_t> notifications{0};
+            std::atomic<uint64_t> parks{0};
+            std::atomic<uint64_t> wakeups{0};
+            std::atomic<uint64_t> spuriousWakeups{0};
+            std::atomic<uint64_t> steals{0};
+            std::atomic<uint64_t> spinHits{0};
+            std::atomic<uint64_t> handoffs{0};
+            std::atomic<uint64_t> retriesParked{0};
+            std::atomic<uint64_t> joinHelps{0};
+            std::atomic<uint64_t> loopHelps{0};
+            std::atomic<uint64_t> suspensions{0};
+            std::atomic<uint64_t> yields{0};
+            std::atomic<uint64_t> compensations{0};
+            std::atomic<uint64_t> resourceWaits{0};
+            std::atomic<uint64_t> peakMemoryInUse{0};
+            std::atomic<uint64_t> concurrencyChanges{0};
+        };
+        StatCounters m_stats;
+
+        // Adaptive concurrency. Settings, probe and streaks are guarded by m_mutex (the
+        // probe runs on the timer thread, one sample at a time); SIZE_MAX = no limit.
+        AdaptiveConcurrency m_adaptive;
+        PressureProbe m_pressureProbe;
+        Internal::PressureMonitor m_pressureMonitor;
+        PressureSample m_lastPressure;
+        unsigned int m_highPressureStreak = 0;
+        unsigned int m_lowPressureStreak = 0;
+        size_t m_adaptiveLimit = 0;
+        std::atomic<size_t> m_concurrencyLimit{SIZE_MAX};
+
+        // Single watchdog thread for all task timeouts (started on first use).
+        Internal::TimerService m_timers;
+        // Single epoll thread for TaskContext::waitForFd / waitForFdThen (started on first use).
+        Internal::IoReactor m_reactor;
+        // io_uring or I/O thread pool for TaskContext::fileIo / fileIoThen (started on first use).
+        Internal::FileIoService m_fileIo;
+
         std::shared_ptr<std::thread> m_asyncThread = nullptr;
         mutable std::atomic<Error> m_lastError;
         std::atomic<FailurePolicy> m_failurePolicy;
 
-        static void taskThreadFunction(TaskScheduler *obj, int threadIndex, std::shared_ptr<std::atomic<bool>> localExit);
+        static void taskThreadFunction(TaskScheduler *obj, int threadIndex, WorkerQueue* ownQueue, std::shared_ptr<std::atomic<bool>> localExit);
 
         struct PendingGuiRequest
         {
@@ -223,6 +926,8 @@ namespace TaskGraph
             QVariant response;
             bool ready = false;
             bool cancelled = false;
+            // Set for TaskContext::askGuiAsync: called once answered or cancelled.
+            std::function<void()> onDone;
         };
 
         Log::LogObject* m_logger = nullptr;
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "TaskGraph_base.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TaskGraph
+{
+    namespace Internal
+    {
+        /// <summary>
+        /// One thread serving any number of one-shot timers, ordered by a min-heap.
+        /// Arming is O(log n), disarming is O(1): the callback is released at once and
+        /// the heap entry is dropped lazily (compacted once stale entries dominate).
+        /// The thread is started on the first arm() and joined by the destructor.
+        /// Callbacks run on the timer thread and must be short.
+        /// </summary>
+        class TimerService
+        {
+            public:
+            using Clock = std::chrono::steady_clock;
+            using TimerId = uint64_t;
+            static constexpr TimerId invalidTimer = 0;
+
+            TimerService();
+            ~TimerService();
+            TimerService(const TimerService&) = delete;
+            TimerService& operator=(const TimerService&) = delete;
+
+            TimerId arm(Clock::duration delay, std::function<void()> callback);
+
+            /// <summary>
+            /// Cancels a timer. Returns false if it already fired (or is firing) or the
+            /// id is unknown. Safe to call with invalidTimer.
+            /// </summary>
+            bool disarm(TimerId id);
+
+            size_t getPendingCount() const;
+            bool isThreadRunning() const;
+
+            private:
+            // Slots are recycled through a free list; the generation makes ids of a
+            // recycled slot distinct so a stale disarm cannot hit the new timer.
+            struct Slot
+            {
+                std::function<void()> callback;
+                uint32_t generation = 1;
+                bool armed = false;
+            };
+
+            struct HeapEntry
+            {
+                Clock::time_point deadline;
+                uint32_t slot;
+                uint32_t generation;
+            };
+
+            static TimerId makeId(uint32_t slot, uint32_t generation);
+            bool isLive(const HeapEntry& entry) const;
+            void releaseSlotLocked(uint32_t slot);
+            void compactLocked();
+            void threadFunction();
+
+            mutable std::mutex m_mutex;
+            std::condition_variable m_cv;
+            std::vector<Slot> m_slots;
+            std::vector<uint32_t> m_freeSlots;
+            std::vector<HeapEntry> m_heap;
+            size_t m_pending = 0;
+            bool m_stop = false;
+            std::unique_ptr<std::thread> m_thread;
+        };
+    }
+}
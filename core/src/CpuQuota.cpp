@@ -0,0 +1,234 @@
+#include "CpuQuota.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+#if defined(__linux__)
+#include <fstream>
+#include <sstream>
+#include <sched.h>
+#endif
+
+namespace TaskGraph
+{
+    const char* DefaultThreadCount::sourceName() const
+    {
+        switch (source)
+        {
+            case ThreadCountSource::Explicit:               return "explicit";
+            case ThreadCountSource::HardwareConcurrency:    return "hardware_concurrency";
+            case ThreadCountSource::Affinity:               return "sched_getaffinity";
+            case ThreadCountSource::CgroupV1Quota:          return "cgroup v1 cpu.cfs_quota_us";
+            case ThreadCountSource::CgroupV2Quota:          return "cgroup v2 cpu.max";
+        }
+        return "unknown";
+    }
+
+    namespace Internal
+    {
+#if defined(__linux__)
+        namespace
+        {
+            bool readFile(const std::string& path, std::string& content)
+            {
+                std::ifstream in(path);
+                if (!in)
+                    return false;
+                std::stringstream ss;
+                ss << in.rdbuf();
+                content = ss.str();
+                return true;
+            }
+
+            bool hasToken(const std::string& list, const std::string& token)
+            {
+                size_t begin = 0;
+                while (begin <= list.size())
+                {
+                    size_t end = list.find(',', begin);
+                    if (end == std::string::npos)
+                        end = list.size();
+                    if (list.compare(begin, end - begin, token) == 0)
+                        return true;
+                    begin = end + 1;
+                }
+                return false;
+            }
+
+            struct Mount
+            {
+                std::string root;
+                std::string point;
+            };
+
+            // The cgroup2 mount, or the cgroup v1 mount carrying the cpu controller.
+            bool findMount(const std::string& mountinfo, bool v2, Mount& mount)
+            {
+                std::istringstream lines(mountinfo);
+                std::string line;
+                while (std::getline(lines, line))
+                {
+                    const size_t dash = line.find(" - ");
+                    if (dash == std::string::npos)
+                        continue;
+                    std::istringstream pre(line.substr(0, dash));
+                    std::istringstream post(line.substr(dash + 3));
+                    std::string id, parent, device, root, point, fstype, source, options;
+                    pre >> id >> parent >> device >> root >> point;
+                    post >> fstype >> source >> options;
+                    if (v2 ? fstype != "cgroup2" : (fstype != "cgroup" || !hasToken(options, "cpu")))
+                        continue;
+                    mount.root = root;
+                    mount.point = point;
+                    return true;
+                }
+                return false;
+            }
+
+            // The process's cgroup: "0::/path" (v2) or "N:cpu,cpuacct:/path" (v1).
+            bool findCgroupPath(const std::string& cgroup, bool v2, std::string& path)
+            {
+                std::istringstream lines(cgroup);
+                std::string line;
+                while (std::getline(lines, line))
+                {
+                    const size_t first = line.find(':');
+                    const size_t second = first == std::string::npos ? first : line.find(':', first + 1);
+                    if (second == std::string::npos)
+                        continue;
+                    const std::string hierarchy = line.substr(0, first);
+                    const std::string controllers = line.substr(first + 1, second - first - 1);
+                    if (v2 ? (hierarchy != "0" || !controllers.empty()) : !hasToken(controllers, "cpu"))
+                        continue;
+                    path = line.substr(second + 1);
+                    return true;
+                }
+                return false;
+            }
+
+            // CPUs of one cgroup directory, 0 if it sets no limit.
+            double quotaOf(const std::string& dir, bool v2)
+            {
+                std::string content;
+                double quota = 0.0, period = 0.0;
+                if (v2)
+                {
+                    if (!readFile(dir + "/cpu.max", content))
+                        return 0.0;
+                    std::istringstream in(content);
+                    std::string max;
+                    in >> max >> period;
+                    if (max == "max" || !in)
+                        return 0.0;
+                    quota = std::strtod(max.c_str(), nullptr);
+                }
+                else
+                {
+                    if (!readFile(dir + "/cpu.cfs_quota_us", content))
+                        return 0.0;
+                    quota = std::strtod(content.c_str(), nullptr);
+                    if (!readFile(dir + "/cpu.cfs_period_us", content))
+                        return 0.0;
+                    period = std::strtod(content.c_str(), nullptr);
+                }
+                return quota > 0.0 && period > 0.0 ? quota / period : 0.0;
+            }
+
+            // The tightest quota from the process's cgroup up to the mount point.
+            double hierarchyLimit(const std::string& root, bool v2)
+            {
+                std::string mountinfo, cgroup, path;
+                Mount mount;
+                if (!readFile(root + "/proc/self/mountinfo", mountinfo) || !findMount(mountinfo, v2, mount)
+                    || !readFile(root + "/proc/self/cgroup", cgroup) || !findCgroupPath(cgroup, v2, path))
+                    return 0.0;
+
+                // Inside a cgroup namespace the mount root may not prefix the path.
+                std::string relative = path;
+                if (mount.root != "/")
+                    relative = path.compare(0, mount.root.size(), mount.root) == 0 ? path.substr(mount.root.size()) : std::string();
+                std::string top = root + mount.point;
+                while (top.size() > 1 && top.back() == '/')
+                    top.pop_back();
+                std::string dir = top + relative;
+                while (dir.size() > top.size() && dir.back() == '/')
+                    dir.pop_back();
+
+                double limit = 0.0;
+                while (true)
+                {
+                    const double cpus = quotaOf(dir, v2);
+                    if (cpus > 0.0 && (limit == 0.0 || cpus < limit))
+                        limit = cpus;
+                    if (dir.size() <= top.size())
+                        break;
+                    dir.erase(dir.rfind('/'));
+                }
+                return limit;
+            }
+        }
+
+        double CpuQuota::cgroupCpuLimit(const std::string& root, ThreadCountSource& source)
+        {
+            // Hybrid hosts mount cgroup2 without the cpu controller: fall back to v1.
+            if (const double v2 = hierarchyLimit(root, true); v2 > 0.0)
+            {
+                source = ThreadCountSource::CgroupV2Quota;
+                return v2;
+            }
+            if (const double v1 = hierarchyLimit(root, false); v1 > 0.0)
+            {
+                source = ThreadCountSource::CgroupV1Quota;
+                return v1;
+            }
+            return 0.0;
+        }
+
+        unsigned int CpuQuota::affinityCpuCount()
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) != 0)
+                return 0;
+            return static_cast<unsigned int>(CPU_COUNT(&set));
+        }
+#else
+        double CpuQuota::cgroupCpuLimit(const std::string&, ThreadCountSource&)
+        {
+            return 0.0;
+        }
+
+        unsigned int CpuQuota::affinityCpuCount()
+        {
+            return 0;
+        }
+#endif
+
+        DefaultThreadCount CpuQuota::detect()
+        {
+            DefaultThreadCount result;
+            result.count = std::max(1u, std::thread::hardware_concurrency());
+            result.source = ThreadCountSource::HardwareConcurrency;
+
+            const unsigned int affinity = affinityCpuCount();
+            if (affinity > 0 && affinity <= result.count)
+            {
+                result.count = affinity;
+                result.source = ThreadCountSource::Affinity;
+            }
+            ThreadCountSource quotaSource = ThreadCountSource::CgroupV2Quota;
+            const double quota = cgroupCpuLimit(std::string(), quotaSource);
+            if (quota > 0.0)
+            {
+                const unsigned int cpus = std::max(1u, static_cast<unsigned int>(std::ceil(quota)));
+                if (cpus <= result.count)
+                {
+                    result.count = cpus;
+                    result.source = quotaSource;
+                }
+            }
+            return result;
+        }
+    }
+}
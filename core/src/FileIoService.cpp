@@ -0,0 +1,568 @@
+#include "FileIoService.h"
+#include <algorithm>
+#include <cerrno>
+#include <unordered_map>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define TG_HAS_IO_URING 1
+#endif
+#endif
+
+#if defined(TG_HAS_IO_URING)
+#include <atomic>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace TaskGraph
+{
+    namespace Internal
+    {
+#if defined(TG_HAS_IO_URING)
+        namespace
+        {
+            constexpr unsigned uringEntries = 256;
+
+            int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+            {
+                return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+            }
+
+            unsigned loadAcquire(unsigned* p)
+            {
+                return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+            }
+
+            void storeRelease(unsigned* p, unsigned v)
+            {
+                std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+            }
+        }
+
+        // Ring mappings and the operations the kernel owns (guarded by the service mutex).
+        struct FileIoService::Uring
+        {
+            struct Pending
+            {
+                iovec iov;
+                Callback callback;
+            };
+
+            int fd = -1;
+            // Signalled by the kernel for every completion and by stop(), so the reaper
+            // wakes even if no entry can be queued.
+            int eventFd = -1;
+            void* sqRing = nullptr;
+            size_t sqRingSize = 0;
+            void* cqRing = nullptr;
+            size_t cqRingSize = 0;
+            io_uring_sqe* sqes = nullptr;
+            size_t sqesSize = 0;
+
+            unsigned* sqHead = nullptr;
+            unsigned* sqTail = nullptr;
+            unsigned sqMask = 0;
+            unsigned sqEntries = 0;
+            unsigned* sqArray = nullptr;
+            unsigned* cqHead = nullptr;
+            unsigned* cqTail = nullptr;
+            unsigned cqMask = 0;
+            unsigned cqEntries = 0;
+            io_uring_cqe* cqes = nullptr;
+
+            // Node-based: the iovec addresses handed to the kernel stay valid.
+            std::unordered_map<uint64_t, Pending> pending;
+            uint64_t nextId = 1;
+            unsigned unsubmitted = 0;
+            bool submitting = false;
+            bool stopping = false;
+
+            ~Uring()
+            {
+                if (eventFd >= 0)
+                    ::close(eventFd);
+                if (sqes)
+                    ::munmap(sqes, sqesSize);
+                if (cqRing && cqRing != sqRing)
+                    ::munmap(cqRing, cqRingSize);
+                if (sqRing)
+                    ::munmap(sqRing, sqRingSize);
+                if (fd >= 0)
+                    ::close(fd);
+            }
+
+            bool open(unsigned entries)
+            {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+                fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+                if (fd < 0)
+                    return false;
+                eventFd = ::eventfd(0, EFD_CLOEXEC);
+                if (eventFd < 0
+                    || ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_EVENTFD, &eventFd, 1) != 0)
+                    return false;
+
+                sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                if (single)
+                    sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+                sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+                if (sqRing == MAP_FAILED)
+                {
+                    sqRing = nullptr;
+                    return false;
+                }
+                cqRing = single ? sqRing
+                                : ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                if (cqRing == MAP_FAILED)
+                {
+                    cqRing = nullptr;
+                    return false;
+                }
+                sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+                void* sqesMap = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+                if (sqesMap == MAP_FAILED)
+                    return false;
+                sqes = static_cast<io_uring_sqe*>(sqesMap);
+
+                char* sq = static_cast<char*>(sqRing);
+                sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+                sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                sqEntries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+                sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+                char* cq = static_cast<char*>(cqRing);
+                cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                cqEntries = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_entries);
+                cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+                return true;
+            }
+
+            // False if the ring has no room; the caller uses the thread pool instead.
+            bool push(uint8_t opcode, int file, iovec* iov, uint64_t offset, uint64_t userData)
+            {
+                const unsigned tail = *sqTail;
+                if (tail - loadAcquire(sqHead) >= sqEntries || pending.size() >= cqEntries)
+                    return false;
+                const unsigned index = tail & sqMask;
+                io_uring_sqe* sqe = &sqes[index];
+                std::memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = opcode;
+                sqe->fd = file;
+                if (iov)
+                {
+                    sqe->addr = reinterpret_cast<uint64_t>(iov);
+                    sqe->len = 1;
+                    sqe->off = offset;
+                }
+                sqe->user_data = userData;
+                sqArray[index] = index;
+                storeRelease(sqTail, tail + 1);
+                ++unsubmitted;
+                return true;
+            }
+
+            // Takes back the entries the kernel has not consumed. Without SQPOLL it only
+            // consumes them inside io_uring_enter, so this is safe while nobody submits.
+            void reclaim(std::vector<Request>& requests)
+            {
+                const unsigned head = loadAcquire(sqHead);
+                for (unsigned i = head; i != *sqTail; ++i)
+                {
+                    const io_uring_sqe& sqe = sqes[sqArray[i & sqMask]];
+                    auto it = pending.find(sqe.user_data);
+                    if (it == pending.end())
+                        continue;
+                    Op op = Op::Sync;
+                    if (sqe.opcode == IORING_OP_READV)
+                        op = Op::Read;
+                    else if (sqe.opcode == IORING_OP_WRITEV)
+                        op = Op::Write;
+                    requests.push_back(Request{ op, sqe.fd, it->second.iov.iov_base, it->second.iov.iov_len,
+                                                sqe.off, std::move(it->second.callback) });
+                    pending.erase(it);
+                }
+                storeRelease(sqTail, head);
+                unsubmitted = 0;
+            }
+        };
+#else
+        struct FileIoService::Uring
+        {
+        };
+#endif
+
+        FileIoService::FileIoService()
+        {
+        }
+
+        FileIoService::~FileIoService()
+        {
+            stop();
+        }
+
+        void FileIoService::setUseIoUring(bool use)
+        {
+            stop();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_useIoUring = use;
+        }
+
+        bool FileIoService::getUseIoUring() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_useIoUring;
+        }
+
+        FileIoService::Backend FileIoService::getBackend() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_backend;
+        }
+
+        size_t FileIoService::getInFlightCount() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_inFlight;
+        }
+
+        uint64_t FileIoService::getSubmitCalls() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_submitCalls;
+        }
+
+        uint64_t FileIoService::getSubmittedCount() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_submitted;
+        }
+
+        void FileIoService::startLocked()
+        {
+            // While stop() winds down, requests go to the pool: a backend started
+            // meanwhile would be torn down under them.
+            if (m_backend != Backend::None || m_poolStop)
+                return;
+#if defined(TG_HAS_IO_URING)
+            if (m_useIoUring)
+            {
+                auto uring = std::make_unique<Uring>();
+                if (uring->open(uringEntries))
+                {
+                    m_uring = std::move(uring);
+                    m_reaper = std::make_unique<std::thread>(&FileIoService::reaperThreadFunction, this);
+                    m_backend = Backend::IoUring;
+                    return;
+                }
+            }
+#endif
+            m_backend = Backend::ThreadPool;
+        }
+
+        void FileIoService::submit(Op op, int fd, void* buffer, size_t size, uint64_t offset, Callback callback)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            startLocked();
+            ++m_inFlight;
+#if defined(TG_HAS_IO_URING)
+            if (m_backend == Backend::IoUring)
+            {
+                Uring& ring = *m_uring;
+                const uint64_t id = ring.nextId++;
+                Uring::Pending& pending = ring.pending[id];
+                pending.iov.iov_base = buffer;
+                pending.iov.iov_len = size;
+                pending.callback = std::move(callback);
+                uint8_t opcode = IORING_OP_FSYNC;
+                if (op == Op::Read)
+                    opcode = IORING_OP_READV;
+                else if (op == Op::Write)
+                    opcode = IORING_OP_WRITEV;
+                if (ring.stopping || !ring.push(opcode, fd, op == Op::Sync ? nullptr : &pending.iov, offset, id))
+                {
+                    Callback overflow = std::move(pending.callback);
+                    ring.pending.erase(id);
+                    submitToPoolLocked(Request{ op, fd, buffer, size, offset, std::move(overflow) });
+                    return;
+                }
+                // Whoever finds no submitter active enters the kernel for every entry
+                // queued meanwhile, so concurrent submits share one syscall.
+                if (ring.submitting)
+                    return;
+                ring.submitting = true;
+                while (ring.unsubmitted > 0)
+                {
+                    const unsigned count = ring.unsubmitted;
+                    ring.unsubmitted = 0;
+                    lock.unlock();
+                    const int submitted = uringEnter(ring.fd, count, 0, 0);
+                    const int error = errno;
+                    lock.lock();
+                    if (submitted < 0)
+                    {
+                        ring.unsubmitted += count;
+                        if (error == EINTR || error == EAGAIN || error == EBUSY)
+                        {
+                            lock.unlock();
+                            std::this_thread::yield();
+                            lock.lock();
+                            continue;
+                        }
+                    }
+                    else
+                    {
+                        ++m_submitCalls;
+                        m_submitted += static_cast<uint64_t>(submitted);
+                        ring.unsubmitted += count - static_cast<unsigned>(submitted);
+                        if (submitted > 0)
+                            continue;
+                    }
+                    // The kernel took none of them. Left in the ring they would wait for
+                    // a submit that may never come: the thread pool runs them instead.
+                    reclaimToPoolLocked();
+                    break;
+                }
+                ring.submitting = false;
+                // stop() may have woken the reaper while this thread still held the
+                // ring; it waits for the submitter to leave as well.
+                if (ring.stopping)
+                {
+                    const uint64_t wake = 1;
+                    (void)!::write(ring.eventFd, &wake, sizeof(wake));
+                }
+                return;
+            }
+#endif
+            submitToPoolLocked(Request{ op, fd, buffer, size, offset, std::move(callback) });
+        }
+
+        void FileIoService::submitToPoolLocked(Request request)
+        {
+            if (m_poolStop)
+            {
+                // The pool is winding down and its threads may already have left:
+                // the request brings its own, which stop() joins as well.
+                m_poolThreads.emplace_back(&FileIoService::poolThreadFunction, this);
+            }
+            else if (m_poolThreads.empty())
+            {
+                // Enough to overlap device latency; the work itself is in the kernel.
+                for (int i = 0; i < 2; ++i)
+                    m_poolThreads.emplace_back(&FileIoService::poolThreadFunction, this);
+            }
+            m_poolQueue.push_back(std::move(request));
+            m_poolCv.notify_one();
+        }
+
+        void FileIoService::reclaimToPoolLocked()
+        {
+#if defined(TG_HAS_IO_URING)
+            std::vector<Request> reclaimed;
+            m_uring->reclaim(reclaimed);
+            for (Request& request : reclaimed)
+                submitToPoolLocked(std::move(request));
+#endif
+        }
+
+#if defined(_WIN32)
+        namespace
+        {
+            // The errno closest to a Win32 error, for the -errno results.
+            long errnoFromWin32(DWORD error)
+            {
+                switch (error)
+                {
+                    case ERROR_INVALID_HANDLE:      return EBADF;
+                    case ERROR_ACCESS_DENIED:       return EACCES;
+                    case ERROR_DISK_FULL:
+                    case ERROR_HANDLE_DISK_FULL:    return ENOSPC;
+                    case ERROR_NOT_ENOUGH_MEMORY:
+                    case ERROR_OUTOFMEMORY:         return ENOMEM;
+                    case ERROR_INVALID_PARAMETER:   return EINVAL;
+                    case ERROR_BROKEN_PIPE:         return EPIPE;
+                    case ERROR_OPERATION_ABORTED:   return ECANCELED;
+                    default:                        return EIO;
+                }
+            }
+        }
+#endif
+
+        long FileIoService::runBlocking(const Request& request)
+        {
+#if defined(_WIN32)
+            const HANDLE handle = reinterpret_cast<HANDLE>(::_get_osfhandle(request.fd));
+            if (handle == INVALID_HANDLE_VALUE)
+                return -EBADF;
+            if (request.op == Op::Sync)
+                return ::FlushFileBuffers(handle) ? 0 : -errnoFromWin32(::GetLastError());
+
+            // The offset in the OVERLAPPED makes the call positional like pread / pwrite.
+            // A handle opened for overlapped I/O completes asynchronously: wait for it.
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = static_cast<DWORD>(request.offset & 0xFFFFFFFFu);
+            overlapped.OffsetHigh = static_cast<DWORD>(request.offset >> 32);
+            // At most 2 GiB - 1 per call, so the count fits a long; short transfers are
+            // allowed as for pread.
+            const DWORD size = static_cast<DWORD>(std::min<size_t>(request.size, 0x7FFFFFFFu));
+            DWORD transferred = 0;
+            BOOL ok = request.op == Op::Read
+                ? ::ReadFile(handle, request.buffer, size, &transferred, &overlapped)
+                : ::WriteFile(handle, request.buffer, size, &transferred, &overlapped);
+            if (!ok && ::GetLastError() == ERROR_IO_PENDING)
+                ok = ::GetOverlappedResult(handle, &overlapped, &transferred, TRUE);
+            if (ok)
+                return static_cast<long>(transferred);
+            const DWORD error = ::GetLastError();
+            // Reading at or past the end of the file is no error for pread either.
+            if (error == ERROR_HANDLE_EOF)
+                return 0;
+            return -errnoFromWin32(error);
+#else
+            while (true)
+            {
+                ssize_t result = -1;
+                switch (request.op)
+                {
+                    case Op::Read:
+                        result = ::pread(request.fd, request.buffer, request.size, static_cast<off_t>(request.offset));
+                        break;
+                    case Op::Write:
+                        result = ::pwrite(request.fd, request.buffer, request.size, static_cast<off_t>(request.offset));
+                        break;
+                    case Op::Sync:
+                        result = ::fsync(request.fd);
+                        break;
+                }
+                if (result >= 0)
+                    return static_cast<long>(result);
+                if (errno != EINTR)
+                    return -errno;
+            }
+#endif
+        }
+
+        void FileIoService::poolThreadFunction()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true)
+            {
+                m_poolCv.wait(lock, [this] { return m_poolStop || !m_poolQueue.empty(); });
+                if (m_poolQueue.empty())
+                    return;
+                Request request = std::move(m_poolQueue.front());
+                m_poolQueue.pop_front();
+                lock.unlock();
+                const long result = runBlocking(request);
+                lock.lock();
+                --m_inFlight;
+                lock.unlock();
+                request.callback(result);
+                request.callback = nullptr;
+                lock.lock();
+            }
+        }
+
+        void FileIoService::reaperThreadFunction()
+        {
+#if defined(TG_HAS_IO_URING)
+            Uring& ring = *m_uring;
+            std::vector<std::pair<Callback, long>> done;
+            while (true)
+            {
+                // One read covers every completion signalled since the previous one.
+                uint64_t signalled = 0;
+                while (::read(ring.eventFd, &signalled, sizeof(signalled)) < 0 && errno == EINTR)
+                {
+                }
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    unsigned head = *ring.cqHead;
+                    const unsigned tail = loadAcquire(ring.cqTail);
+                    for (; head != tail; ++head)
+                    {
+                        const io_uring_cqe& cqe = ring.cqes[head & ring.cqMask];
+                        auto it = ring.pending.find(cqe.user_data);
+                        if (it == ring.pending.end())
+                            continue;
+                        done.emplace_back(std::move(it->second.callback), static_cast<long>(cqe.res));
+                        ring.pending.erase(it);
+                        --m_inFlight;
+                    }
+                    storeRelease(ring.cqHead, head);
+                }
+                for (auto& entry : done)
+                    entry.first(entry.second);
+                done.clear();
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (ring.stopping && ring.pending.empty() && !ring.submitting)
+                    return;
+            }
+#endif
+        }
+
+        void FileIoService::stop()
+        {
+            std::unique_ptr<std::thread> reaper;
+            std::vector<std::thread> pool;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+#if defined(TG_HAS_IO_URING)
+                if (m_uring && m_reaper)
+                {
+                    // Later submits use the pool. So do entries nobody entered the kernel
+                    // for; an active submitter hands over its own if the kernel refuses them.
+                    m_uring->stopping = true;
+                    if (!m_uring->submitting)
+                        reclaimToPoolLocked();
+                    // The reaper leaves once nothing is in the kernel anymore. The eventfd
+                    // wakes it without needing room in the ring.
+                    const uint64_t wake = 1;
+                    (void)!::write(m_uring->eventFd, &wake, sizeof(wake));
+                }
+#endif
+                reaper = std::move(m_reaper);
+                m_poolStop = true;
+                pool = std::move(m_poolThreads);
+            }
+            m_poolCv.notify_all();
+            if (reaper && reaper->joinable())
+                reaper->join();
+            // Requests handed to the pool meanwhile started threads of their own.
+            while (true)
+            {
+                for (std::thread& t : pool)
+                    t.join();
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_poolThreads.empty())
+                {
+                    m_uring.reset();
+                    m_poolStop = false;
+                    m_backend = Backend::None;
+                    return;
+                }
+                pool = std::move(m_poolThreads);
+            }
+        }
+    }
+}
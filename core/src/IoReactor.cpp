@@ -0,0 +1,219 @@
+#include "IoReactor.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace TaskGraph
+{
+    namespace Internal
+    {
+#if defined(__linux__)
+        namespace
+        {
+            uint32_t toEpoll(int interest)
+            {
+                uint32_t events = 0;
+                if (interest & IoReactor::Readable)
+                    events |= EPOLLIN | EPOLLRDHUP;
+                if (interest & IoReactor::Writable)
+                    events |= EPOLLOUT;
+                return events;
+            }
+
+            int fromEpoll(uint32_t events)
+            {
+                int ready = 0;
+                if (events & EPOLLIN)
+                    ready |= IoReactor::Readable;
+                if (events & EPOLLOUT)
+                    ready |= IoReactor::Writable;
+                if (events & EPOLLERR)
+                    ready |= IoReactor::Error;
+                if (events & (EPOLLHUP | EPOLLRDHUP))
+                    ready |= IoReactor::HangUp;
+                return ready;
+            }
+        }
+#endif
+
+        IoReactor::IoReactor()
+        {
+        }
+
+        IoReactor::~IoReactor()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+#if defined(__linux__)
+            if (m_wakeFd >= 0)
+            {
+                const uint64_t one = 1;
+                (void)::write(m_wakeFd, &one, sizeof(one));
+            }
+#endif
+            if (m_thread && m_thread->joinable())
+                m_thread->join();
+            for (auto& kv : m_watches)
+                release(kv.second.fd);
+            m_watches.clear();
+#if defined(__linux__)
+            if (m_epollFd >= 0)
+                ::close(m_epollFd);
+            if (m_wakeFd >= 0)
+                ::close(m_wakeFd);
+#endif
+        }
+
+        bool IoReactor::isSupported()
+        {
+#if defined(__linux__)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        bool IoReactor::startLocked()
+        {
+#if defined(__linux__)
+            m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+            m_wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = invalidWatch;
+            if (m_epollFd < 0 || m_wakeFd < 0
+                || ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev) != 0)
+            {
+                if (m_epollFd >= 0)
+                    ::close(m_epollFd);
+                if (m_wakeFd >= 0)
+                    ::close(m_wakeFd);
+                m_epollFd = -1;
+                m_wakeFd = -1;
+                return false;
+            }
+            m_thread = std::make_unique<std::thread>(&IoReactor::threadFunction, this);
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        IoReactor::WatchId IoReactor::watch(int fd, int interest, std::function<void(int)> callback)
+        {
+            if (fd < 0 || !callback)
+                return invalidWatch;
+#if defined(__linux__)
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop || (!m_thread && !startLocked()))
+                return invalidWatch;
+
+            const int own = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+            if (own < 0)
+                return invalidWatch;
+            const WatchId id = m_nextId++;
+            epoll_event ev{};
+            ev.events = toEpoll(interest) | EPOLLONESHOT;
+            ev.data.u64 = id;
+            if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, own, &ev) != 0)
+            {
+                ::close(own);
+                return invalidWatch;
+            }
+            m_watches.emplace(id, Watch{ own, std::move(callback) });
+            return id;
+#else
+            (void)interest;
+            return invalidWatch;
+#endif
+        }
+
+        bool IoReactor::unwatch(WatchId id)
+        {
+            if (id == invalidWatch)
+                return false;
+            Watch removed;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_watches.find(id);
+                if (it == m_watches.end())
+                    return false;
+                removed = std::move(it->second);
+                m_watches.erase(it);
+            }
+            // The callback (and whatever it captured) is destroyed outside the lock.
+            release(removed.fd);
+            return true;
+        }
+
+        void IoReactor::release(int fd)
+        {
+#if defined(__linux__)
+            // Removed before the close, so the number cannot be reused while still registered.
+            ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+#else
+            (void)fd;
+#endif
+        }
+
+        size_t IoReactor::getWatchCount() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_watches.size();
+        }
+
+        bool IoReactor::isThreadRunning() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_thread != nullptr;
+        }
+
+        void IoReactor::threadFunction()
+        {
+#if defined(__linux__)
+            epoll_event events[64];
+            while (true)
+            {
+                const int n = ::epoll_wait(m_epollFd, events, 64, -1);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return;
+                }
+                for (int i = 0; i < n; ++i)
+                {
+                    const WatchId id = events[i].data.u64;
+                    if (id == invalidWatch)
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (m_stop)
+                            return;
+                        continue;
+                    }
+                    Watch fired;
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        auto it = m_watches.find(id);
+                        // Unwatched after epoll_wait returned.
+                        if (it == m_watches.end())
+                            continue;
+                        fired = std::move(it->second);
+                        m_watches.erase(it);
+                    }
+                    release(fired.fd);
+                    fired.callback(fromEpoll(events[i].events));
+                }
+            }
+#endif
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#include "PressureMonitor.h"
+
+#if defined(__linux__)
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#endif
+
+namespace TaskGraph
+{
+    namespace Internal
+    {
+#if defined(__linux__)
+        namespace
+        {
+            // The "total=" of the "some" line: accumulated stall time in microseconds.
+            bool readSomeTotal(const char* path, uint64_t& total)
+            {
+                std::FILE* file = std::fopen(path, "r");
+                if (!file)
+                    return false;
+                char line[256];
+                bool found = false;
+                while (!found && std::fgets(line, sizeof(line), file))
+                {
+                    if (std::strncmp(line, "some ", 5) != 0)
+                        continue;
+                    const char* pos = std::strstr(line, "total=");
+                    unsigned long long value = 0;
+                    found = pos && std::sscanf(pos + 6, "%llu", &value) == 1;
+                    total = value;
+                }
+                std::fclose(file);
+                return found;
+            }
+
+            // The fourth field of /proc/loadavg, "running/total".
+            bool readRunnable(unsigned int& runnable)
+            {
+                std::FILE* file = std::fopen("/proc/loadavg", "r");
+                if (!file)
+                    return false;
+                double a, b, c;
+                unsigned int running = 0, total = 0;
+                const bool ok = std::fscanf(file, "%lf %lf %lf %u/%u", &a, &b, &c, &running, &total) == 5;
+                std::fclose(file);
+                runnable = running;
+                return ok;
+            }
+        }
+
+        bool PressureMonitor::isSupported()
+        {
+            uint64_t total;
+            return readSomeTotal("/proc/pressure/cpu", total);
+        }
+
+        PressureSample PressureMonitor::sample()
+        {
+            PressureSample result;
+            uint64_t cpu = 0, memory = 0, io = 0;
+            if (!readSomeTotal("/proc/pressure/cpu", cpu))
+                return result;
+            // Memory and I/O pressure are optional (e.g. no memory controller).
+            readSomeTotal("/proc/pressure/memory", memory);
+            readSomeTotal("/proc/pressure/io", io);
+            const Clock::time_point now = Clock::now();
+
+            if (m_primed)
+            {
+                const double elapsedUs = std::chrono::duration<double, std::micro>(now - m_last).count();
+                if (elapsedUs > 0.0)
+                {
+                    auto share = [elapsedUs](uint64_t current, uint64_t previous) {
+                        return current >= previous ? std::min(1.0, double(current - previous) / elapsedUs) : 0.0;
+                    };
+                    result.cpu = share(cpu, m_cpuTotal);
+                    result.memory = share(memory, m_memoryTotal);
+                    result.io = share(io, m_ioTotal);
+                    unsigned int runnable = 0;
+                    const unsigned int cpus = std::max(1u, std::thread::hardware_concurrency());
+                    // The reading thread itself is one of the runnable ones.
+                    if (readRunnable(runnable) && runnable > cpus + 1)
+                        result.runQueue = double(runnable - 1 - cpus) / cpus;
+                    result.valid = true;
+                }
+            }
+            m_primed = true;
+            m_last = now;
+            m_cpuTotal = cpu;
+            m_memoryTotal = memory;
+            m_ioTotal = io;
+            return result;
+        }
+#else
+        bool PressureMonitor::isSupported()
+        {
+            return false;
+        }
+
+        PressureSample PressureMonitor::sample()
+        {
+            return PressureSample();
+        }
+#endif
+    }
+}
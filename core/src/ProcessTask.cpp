@@ -0,0 +1,275 @@
+#include "ProcessTask.h"
+#include "LogObject.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace TaskGraph
+{
+#if defined(__linux__)
+    namespace
+    {
+        // Owns the child and the parent's pipe ends. A child still running when this is
+        // destroyed (cancel, timeout, exception) is killed and reaped.
+        struct ChildProcess
+        {
+            pid_t pid = -1;
+            bool reaped = false;
+            int pidFd = -1;
+            int epollFd = -1;
+            int out = -1;
+            int err = -1;
+            std::atomic<long>* pidOut = nullptr;
+
+            ~ChildProcess()
+            {
+                if (pid > 0 && !reaped)
+                {
+                    ::kill(pid, SIGKILL);
+                    int status = 0;
+                    while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+                }
+                for (int fd : { out, err, pidFd, epollFd })
+                    if (fd >= 0)
+                        ::close(fd);
+                if (pidOut)
+                    pidOut->store(0, std::memory_order_release);
+            }
+        };
+
+        // Closes both ends of a pipe unless released.
+        struct PipePair
+        {
+            int fds[2] = { -1, -1 };
+            ~PipePair()
+            {
+                for (int fd : fds)
+                    if (fd >= 0)
+                        ::close(fd);
+            }
+        };
+
+        std::string errnoText(int error)
+        {
+            return std::strerror(error);
+        }
+
+        int openPidFd(pid_t pid)
+        {
+#if defined(SYS_pidfd_open)
+            return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+            (void)pid;
+            return -1;
+#endif
+        }
+
+        void makePipe(PipePair& pipe)
+        {
+            if (::pipe2(pipe.fds, O_CLOEXEC) != 0)
+                throw std::runtime_error("ProcessTask: pipe failed: " + errnoText(errno));
+            // Only the parent's read end: the child must see a blocking stdout/stderr.
+            ::fcntl(pipe.fds[0], F_SETFL, ::fcntl(pipe.fds[0], F_GETFL) | O_NONBLOCK);
+        }
+    }
+#endif
+
+    ProcessTask::ProcessTask(const std::string& name, const std::string& program,
+                             const std::vector<std::string>& arguments)
+        : Task(name)
+        , m_program(program)
+        , m_arguments(arguments)
+    {
+        setCoroutineFunction([this](TaskContext& ctx) { return runProcess(ctx); });
+    }
+
+    CoTask ProcessTask::runProcess(TaskContext& ctx)
+    {
+#if defined(__linux__)
+        m_exitCode.store(-1, std::memory_order_release);
+        if (m_program.empty())
+            throw std::runtime_error("ProcessTask: no program set");
+
+        ChildProcess child;
+        {
+            PipePair outPipe;
+            PipePair errPipe;
+            makePipe(outPipe);
+            makePipe(errPipe);
+
+            std::vector<char*> argv;
+            argv.push_back(const_cast<char*>(m_program.c_str()));
+            for (const std::string& arg : m_arguments)
+                argv.push_back(const_cast<char*>(arg.c_str()));
+            argv.push_back(nullptr);
+            std::vector<char*> envp;
+            for (const std::string& entry : m_environment)
+                envp.push_back(const_cast<char*>(entry.c_str()));
+            envp.push_back(nullptr);
+
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+            posix_spawn_file_actions_adddup2(&actions, outPipe.fds[1], 1);
+            posix_spawn_file_actions_adddup2(&actions, errPipe.fds[1], 2);
+            if (!m_workingDirectory.empty())
+            {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+                posix_spawn_file_actions_addchdir_np(&actions, m_workingDirectory.c_str());
+#else
+                posix_spawn_file_actions_destroy(&actions);
+                throw std::runtime_error("ProcessTask: working directory needs glibc 2.29 or newer");
+#endif
+            }
+            // An ignored SIGPIPE would be inherited across exec.
+            posix_spawnattr_t attr;
+            posix_spawnattr_init(&attr);
+            sigset_t defaults;
+            sigemptyset(&defaults);
+            sigaddset(&defaults, SIGPIPE);
+            posix_spawnattr_setsigdefault(&attr, &defaults);
+            posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+
+            pid_t pid = -1;
+            const int spawnError = ::posix_spawnp(&pid, m_program.c_str(), &actions, &attr, argv.data(),
+                                                  m_environment.empty() ? environ : envp.data());
+            posix_spawnattr_destroy(&attr);
+            posix_spawn_file_actions_destroy(&actions);
+            if (spawnError != 0)
+                throw std::runtime_error("ProcessTask: cannot start \"" + m_program + "\": " + errnoText(spawnError));
+
+            child.pid = pid;
+            child.pidOut = &m_pid;
+            m_pid.store(pid, std::memory_order_release);
+            child.out = outPipe.fds[0];
+            child.err = errPipe.fds[0];
+            outPipe.fds[0] = -1;
+            errPipe.fds[0] = -1;
+            // The write ends close here, so EOF arrives once the child (and its children) exit.
+        }
+        ctx.log().logInfo("Started \"" + m_program + "\" (pid " + std::to_string(child.pid) + ")");
+
+        // One epoll set for both pipes and the pidfd, awaited as a single fd.
+        child.pidFd = openPidFd(child.pid);
+        child.epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (child.epollFd < 0)
+            throw std::runtime_error("ProcessTask: epoll_create1 failed: " + errnoText(errno));
+        for (int fd : { child.out, child.err, child.pidFd })
+        {
+            if (fd < 0)
+                continue;
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            ::epoll_ctl(child.epollFd, EPOLL_CTL_ADD, fd, &ev);
+        }
+
+        std::string captured;
+        std::string outLine;
+        std::string errLine;
+        Log::LogObject& log = ctx.log();
+        auto emitLines = [&](std::string& pending, bool isErr, bool flush) {
+            size_t start = 0;
+            size_t nl;
+            while ((nl = pending.find('\n', start)) != std::string::npos)
+            {
+                const std::string line = pending.substr(start, nl - start);
+                if (isErr) log.logWarning(line);
+                else log.logInfo(line);
+                start = nl + 1;
+            }
+            pending.erase(0, start);
+            if (flush && !pending.empty())
+            {
+                if (isErr) log.logWarning(pending);
+                else log.logInfo(pending);
+                pending.clear();
+            }
+        };
+        // Reads what is buffered; closes the pipe at EOF.
+        auto drain = [&](int& fd, bool isErr) {
+            char buffer[4096];
+            while (fd >= 0)
+            {
+                const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+                if (n > 0)
+                {
+                    if (!isErr && m_captureStdout)
+                        captured.append(buffer, static_cast<size_t>(n));
+                    else
+                        (isErr ? errLine : outLine).append(buffer, static_cast<size_t>(n));
+                    continue;
+                }
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    break;
+                ::epoll_ctl(child.epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                ::close(fd);
+                fd = -1;
+            }
+            emitLines(isErr ? errLine : outLine, isErr, fd < 0);
+        };
+
+        int status = 0;
+        bool lost = false;
+        while (!child.reaped)
+        {
+            if (child.pidFd < 0 && child.out < 0 && child.err < 0)
+            {
+                // No pidfd (kernel < 5.3) and the pipes are closed: poll for the exit.
+                co_await ctx.sleepFor(std::chrono::milliseconds(10));
+            }
+            else
+            {
+                co_await ctx.waitForFd(child.epollFd, TaskContext::Readable);
+            }
+            drain(child.out, false);
+            drain(child.err, true);
+
+            const pid_t r = ::waitpid(child.pid, &status, WNOHANG);
+            if (r == child.pid)
+                child.reaped = true;
+            else if (r < 0 && errno != EINTR)
+            {
+                // ECHILD: SIGCHLD is ignored, the child was reaped by the kernel.
+                child.reaped = true;
+                lost = true;
+            }
+        }
+        // Output written right before the exit; grandchildren holding the pipes are not waited for.
+        drain(child.out, false);
+        drain(child.err, true);
+        emitLines(outLine, false, true);
+        emitLines(errLine, true, true);
+
+        if (m_captureStdout)
+            ctx.setResult(captured);
+        if (lost)
+            throw std::runtime_error("ProcessTask: exit status of \"" + m_program + "\" is unavailable (SIGCHLD ignored?)");
+        if (WIFSIGNALED(status))
+            throw std::runtime_error("\"" + m_program + "\" killed by signal " + std::to_string(WTERMSIG(status)));
+        const int code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        m_exitCode.store(code, std::memory_order_release);
+        if (code != 0)
+            throw std::runtime_error("\"" + m_program + "\" exited with code " + std::to_string(code));
+#else
+        (void)ctx;
+        throw std::runtime_error("ProcessTask is only supported on Linux");
+#endif
+        co_return;
+    }
+}
@@ -5,6 +5,7 @@
 #include "LogObject.h"
 #include <unordered_set>
 #include <exception>
+#include <cmath>
 
 namespace TaskGraph
 {
@@ -13,13 +14,19 @@ namespace TaskGraph
         , m_name("Task")
         , m_status(Status::Pending)
         , m_affinity(TaskAffinity::Any)
+        , m_priority(0)
         , m_cancelRequested(false)
         , m_timeoutHit(false)
         , m_timeoutGen(0)
+        , m_topologyVersion(0)
         , m_weight(1.0f)
         , m_timeoutMs(0)
         , m_maxRetries(0)
         , m_backoffMs(0)
+        , m_backoffMultiplier(1.0)
+        , m_backoffCapMs(0)
+        , m_retryJitter(0.0)
+        , m_lastDurationUs(0)
         , m_workFunction(nullptr)
         , m_workFunctionCtx(nullptr)
     {
@@ -30,13 +37,19 @@ namespace TaskGraph
         , m_name(name)
         , m_status(Status::Pending)
         , m_affinity(TaskAffinity::Any)
+        , m_priority(0)
         , m_cancelRequested(false)
         , m_timeoutHit(false)
         , m_timeoutGen(0)
+        , m_topologyVersion(0)
         , m_weight(1.0f)
         , m_timeoutMs(0)
         , m_maxRetries(0)
         , m_backoffMs(0)
+        , m_backoffMultiplier(1.0)
+        , m_backoffCapMs(0)
+        , m_retryJitter(0.0)
+        , m_lastDurationUs(0)
         , m_workFunction(nullptr)
         , m_workFunctionCtx(nullptr)
     {
@@ -124,10 +137,54 @@ namespace TaskGraph
     }
 
     bool Task::runTask(TaskContext* ctx)
+    {
+        if (!beginBody())
+            return false;
+        std::exception_ptr error = invokeBody(ctx);
+        if (ctx && ctx->hasContinuation())
+        {
+            // Only a scheduler worker can pick the task up again with the answer.
+            ctx->dropContinuation();
+            if (!error)
+                error = std::make_exception_ptr(std::runtime_error("askGuiThen / waitForFdThen / fileIoThen need a TaskScheduler to resume the task"));
+        }
+        return endBody(error);
+    }
+
+    std::exception_ptr Task::invokeBody(TaskContext* ctx)
     {
         TG_TASK_PROFILING_BLOCK(m_name.c_str(), TG_COLOR_STAGE_1);
         STACK_WATCHER_FUNC;
 
+        try
+        {
+            if (m_coroutineFunction)
+            {
+                // Outside the scheduler the body cannot be resumed later: it must not suspend.
+                TaskContext local(this, nullptr);
+                CoTask co = m_coroutineFunction(ctx ? *ctx : local);
+                if (co.resume())
+                    return co.error();
+                throw std::runtime_error("Coroutine body suspended outside a TaskScheduler");
+            }
+            else if (m_workFunctionCtx && ctx)
+                m_workFunctionCtx(*ctx);
+            else if (m_workFunction)
+                m_workFunction();
+            else if (ctx)
+                work(*ctx);
+            else
+                work();
+        }
+        catch (...)
+        {
+            return std::current_exception();
+        }
+        return nullptr;
+    }
+
+    bool Task::beginBody()
+    {
         if (m_cancelRequested.load(std::memory_order_acquire))
         {
             Status expected = Status::Pending;
@@ -137,32 +194,37 @@ namespace TaskGraph
             return false;
         }
 
-        std::vector<std::shared_ptr<Task>> deps;
+        // Checked in place (no copy of the dependency list): this runs for every task execution.
+        bool expired = false;
+        bool depsDone = true;
         {
             std::lock_guard<std::mutex> lock(m_depMutex);
-            deps.reserve(m_dependencies.size());
             for (const auto& w : m_dependencies)
             {
                 auto sp = w.lock();
                 if (!sp)
                 {
-                    Internal::TaskGraphLogger::logError("Task \"" + m_name + "\" has an expired dependency");
-                    setLastError(QStringLiteral("Expired dependency"));
-                    m_status.store(Status::Failed, std::memory_order_release);
-                    emit failed(getLastError());
-                    return false;
+                    expired = true;
+                    break;
                 }
-                deps.push_back(std::move(sp));
+                if (!sp->isDone())
+                    depsDone = false;
             }
         }
 
-        for (const auto& dep : deps)
+        if (expired)
         {
-            if (!dep->isDone())
-            {
-                Internal::TaskGraphLogger::logError("Task: \"" + m_name + "\" can't run because some dependencies aren't processed");
-                return false;
-            }
+            Internal::TaskGraphLogger::logError("Task \"" + m_name + "\" has an expired dependency");
+            setLastError(QStringLiteral("Expired dependency"));
+            m_status.store(Status::Failed, std::memory_order_release);
+            emit failed(getLastError());
+            return false;
+        }
+
+        if (!depsDone)
+        {
+            Internal::TaskGraphLogger::logError("Task: \"" + m_name + "\" can't run because some dependencies aren't processed");
+            return false;
         }
 
         Status expected = Status::Pending;
@@ -179,34 +241,40 @@ namespace TaskGraph
 
         if (auto* lg = effectiveLoggerOrNull()) lg->logInfo("Task started");
         emit started();
-        try
-        {
-            if (m_workFunctionCtx && ctx)
-                m_workFunctionCtx(*ctx);
-            else if (m_workFunction)
-                m_workFunction();
-            else if (ctx)
-                work(*ctx);
-            else
-                work();
-        }
-        catch (const std::exception& e)
-        {
-            const QString msg = QString::fromUtf8(e.what());
-            if (auto* lg = effectiveLoggerOrNull()) lg->logError(std::string("Task threw: ") + e.what());
-            setLastError(msg);
-            m_status.store(Status::Failed, std::memory_order_release);
-            emit failed(msg);
-            return false;
-        }
-        catch (...)
+        m_bodyStart = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    bool Task::endBody(std::exception_ptr error)
+    {
+        if (error)
         {
-            const QString msg = QStringLiteral("Unknown exception");
-            if (auto* lg = effectiveLoggerOrNull()) lg->logError("Task threw an unknown exception");
-            setLastError(msg);
-            m_status.store(Status::Failed, std::memory_order_release);
-            emit failed(msg);
-            return false;
+            try
+            {
+                std::rethrow_exception(error);
+            }
+            catch (const CancelledError&)
+            {
+                // An awaitable gave up on cancel or timeout: settled below.
+            }
+            catch (const std::exception& e)
+            {
+                const QString msg = QString::fromUtf8(e.what());
+                if (auto* lg = effectiveLoggerOrNull()) lg->logError(std::string("Task threw: ") + e.what());
+                setLastError(msg);
+                m_status.store(Status::Failed, std::memory_order_release);
+                emit failed(msg);
+                return false;
+            }
+            catch (...)
+            {
+                const QString msg = QStringLiteral("Unknown exception");
+                if (auto* lg = effectiveLoggerOrNull()) lg->logError("Task threw an unknown exception");
+                setLastError(msg);
+                m_status.store(Status::Failed, std::memory_order_release);
+                emit failed(msg);
+                return false;
+            }
         }
 
         // Timeout takes precedence over cooperative cancel: watchdog set cancel + timeout flag.
@@ -220,7 +288,7 @@ namespace TaskGraph
             return false;
         }
 
-        if (m_cancelRequested.load(std::memory_order_acquire))
+        if (m_cancelRequested.load(std::memory_order_acquire) || error)
         {
             m_status.store(Status::Cancelled, std::memory_order_release);
             if (auto* lg = effectiveLoggerOrNull()) lg->logWarning("Task cancelled");
@@ -228,6 +296,10 @@ namespace TaskGraph
         }
 
         if (auto* lg = effectiveLoggerOrNull()) lg->logInfo("Task completed");
+        // At least 1 us so that "measured" is distinguishable from "never ran".
+        const int64_t tookUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_bodyStart).count();
+        m_lastDurationUs.store(tookUs > 0 ? tookUs : 1, std::memory_order_release);
         m_status.store(Status::Done, std::memory_order_release);
         emit completed();
         return true;
@@ -246,6 +318,21 @@ namespace TaskGraph
         emit wasReset();
     }
 
+    std::chrono::milliseconds Task::getRetryDelay(int attempt) const
+    {
+        const double base = static_cast<double>(getRetryBackoff().count());
+        if (base <= 0.0 || attempt < 1)
+            return std::chrono::milliseconds(0);
+        double delay = base * std::pow(getRetryBackoffMultiplier(), attempt - 1);
+        const int64_t cap = m_backoffCapMs.load(std::memory_order_acquire);
+        if (cap > 0 && delay > static_cast<double>(cap))
+            delay = static_cast<double>(cap);
+        // Large exponents overflow to inf; clamp before converting.
+        if (!(delay < 1e15))
+            delay = 1e15;
+        return std::chrono::milliseconds(static_cast<int64_t>(delay));
+    }
+
     void Task::prepareRetry()
     {
         m_cancelRequested.store(false, std::memory_order_release);
@@ -320,6 +407,25 @@ namespace TaskGraph
         m_result = std::move(value);
     }
 
+    void Task::setResourceRequirement(const std::string& resource, size_t units)
+    {
+        if (isRunning())
+        {
+            Internal::TaskGraphLogger::logError("Can't change the resource requirements of a running task");
+            return;
+        }
+        if (units == 0)
+            m_resourceRequirements.erase(resource);
+        else
+            m_resourceRequirements[resource] = units;
+    }
+
+    size_t Task::getResourceRequirement(const std::string& resource) const
+    {
+        auto it = m_resourceRequirements.find(resource);
+        return it != m_resourceRequirements.end() ? it->second : 0;
+    }
+
     bool Task::checkDependencies()
     {
         std::lock_guard<std::mutex> lock(m_depMutex);
@@ -397,6 +503,7 @@ namespace TaskGraph
                 return true;
         }
         m_dependencies.push_back(task);
+        m_topologyVersion.fetch_add(1, std::memory_order_acq_rel);
         return true;
     }
 
@@ -420,6 +527,7 @@ namespace TaskGraph
         }
         std::lock_guard<std::mutex> lock(m_depMutex);
         m_dependencies.clear();
+        m_topologyVersion.fetch_add(1, std::memory_order_acq_rel);
         return true;
     }
 
@@ -459,4 +567,99 @@ namespace TaskGraph
         const int id = m_scheduler->allocateGuiRequestId();
         return m_scheduler->waitForGuiResponse(id, m_task, payload);
     }
+
+    bool TaskContext::askGuiThen(const QVariant& payload, std::function<void(TaskContext&, const QVariant&)> continuation)
+    {
+        if (!continuation)
+            return false;
+        Continuation next;
+        next.payload = payload;
+        next.onAnswer = std::move(continuation);
+        return setContinuation("askGuiThen", std::move(next));
+    }
+
+    bool TaskContext::waitForFdThen(int fd, int events, std::function<void(TaskContext&, int)> continuation)
+    {
+        if (!continuation || fd < 0)
+            return false;
+        Continuation next;
+        next.fd = fd;
+        next.events = events;
+        next.onReady = std::move(continuation);
+        return setContinuation("waitForFdThen", std::move(next));
+    }
+
+    bool TaskContext::fileIoThen(const FileIoRequest& request, std::function<void(TaskContext&, long)> continuation)
+    {
+        if (!continuation)
+            return false;
+        Continuation next;
+        next.fileIo = request;
+        next.onFileIo = std::move(continuation);
+        return setContinuation("fileIoThen", std::move(next));
+    }
+
+    bool TaskContext::yieldThen(std::function<void(TaskContext&)> continuation)
+    {
+        if (!continuation)
+            return false;
+        Continuation next;
+        next.onResume = std::move(continuation);
+        return setContinuation("yieldThen", std::move(next));
+    }
+
+    bool TaskContext::setContinuation(const char* caller, Continuation continuation)
+    {
+        if (!m_scheduler || !m_task)
+            return false;
+        if (m_task->getAffinity() == Task::TaskAffinity::Gui || m_task->isCoroutine())
+        {
+            Internal::TaskGraphLogger::logError(std::string(caller) + ": not allowed from a coroutine body or a task with TaskAffinity::Gui");
+            return false;
+        }
+        if (m_continuation)
+        {
+            Internal::TaskGraphLogger::logError(std::string(caller) + ": a continuation is already pending");
+            return false;
+        }
+        m_continuation = std::move(continuation);
+        return true;
+    }
+
+    CoTask TaskContext::runContinuations(bool runBody)
+    {
+        if (runBody)
+        {
+            m_continuation.reset();
+            if (std::exception_ptr error = m_task->invokeBody(this))
+                std::rethrow_exception(error);
+        }
+        while (m_continuation)
+        {
+            Continuation next = std::move(*m_continuation);
+            m_continuation.reset();
+            if (next.onResume)
+            {
+                co_await YieldAwaiter(*this, true);
+                next.onResume(*this);
+            }
+            else if (next.onFileIo)
+            {
+                // Errors go to the continuation as -errno.
+                const long result = co_await FileIoAwaiter(*this, next.fileIo, false);
+                next.onFileIo(*this, result);
+            }
+            else if (next.onReady)
+            {
+                // Cancel and timeout end the task here (CancelledError).
+                const int ready = co_await waitForFd(next.fd, next.events);
+                next.onReady(*this, ready);
+            }
+            else
+            {
+                const QVariant response = co_await askGuiAsync(next.payload);
+                next.onAnswer(*this, response);
+            }
+        }
+    }
 }
@@ -94,6 +94,8 @@ namespace TaskGraph
 			<< "Version: " << version.toString() << "\n"
 			<< "Compilation Date: " << compilationDate << "\n"
 			<< "Compilation Time: " << compilationTime << "\n";
+		const DefaultThreadCount threads = getDefaultThreadCount();
+		ss << "Default Threads: " << threads.count << " (" << threads.sourceName() << ")\n";
 
 		stream << ss.str();
 	}
@@ -142,6 +144,7 @@ namespace TaskGraph
 			std::string label;
 			std::string value;
 		};
+		const DefaultThreadCount threads = getDefaultThreadCount();
 		std::vector< Pair> pairs = {
 			{"Library Name:", name},
 			{"Author:", author},
@@ -152,6 +155,7 @@ namespace TaskGraph
 			{"Compilation Date:", compilationDate},
 			{"Compilation Time:", compilationTime},
 			{"Build Type:", buildTypeStr},
+			{"Default Threads:", std::to_string(threads.count) + " (" + threads.sourceName() + ")"},
 		};
 		int rowCount = 0;
 		for (const auto& pair : pairs) {
@@ -179,7 +183,10 @@ namespace TaskGraph
 
 
 /// USER_SECTION_START 4
-
+	DefaultThreadCount LibraryInfo::getDefaultThreadCount()
+	{
+		return Internal::CpuQuota::detect();
+	}
 /// USER_SECTION_END
 }
 
@@ -4,11 +4,20 @@
 #include "LogObject.h"
 #include <QMetaObject>
 #include <QMetaType>
+#include <QThread>
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 #include <cmath>
+#include <cstring>
 #include <thread>
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
+
 namespace TaskGraph
 {
     namespace
@@ -25,6 +34,50 @@ namespace TaskGraph
                     flag.store(false, std::memory_order_release);
             }
         };
+
+        // Counts a thread for as long as it may hold a StealTargets snapshot.
+        struct StealReaderScope
+        {
+            std::atomic<unsigned int>& count;
+            explicit StealReaderScope(std::atomic<unsigned int>& c) : count(c) { count.fetch_add(1); }
+            ~StealReaderScope() { count.fetch_sub(1); }
+        };
+
+        // Identifies the worker thread (if any) executing on the current thread so
+        // that successors can be pushed onto the completing worker's own deque.
+        thread_local TaskScheduler* t_workerScheduler = nullptr;
+        thread_local int t_workerIndex = -1;
+        // t_workerIndex of a compensating worker: counted busy like a pool worker, but
+        // without a deque. -1 is a participating caller.
+        constexpr int compensatorIndex = -2;
+        // Open TaskContext::BlockingScope guards on this thread; only the outermost counts.
+        thread_local int t_blockingDepth = 0;
+
+        // Mode of schedulers constructed from now on; see setDefaultExecutionMode.
+        std::atomic<TaskScheduler::ExecutionMode> s_defaultExecutionMode{TaskScheduler::ExecutionMode::SharedQueue};
+
+        uint32_t nextRandom(uint32_t& state)
+        {
+            // xorshift32 — cheap per-worker victim selection
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        // Spin-wait hint: lets the sibling hyperthread run and saves power while polling.
+        inline void cpuRelax()
+        {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#elif defined(_M_ARM64)
+            __yield();
+#elif defined(__aarch64__) || defined(__arm__)
+            __asm__ __volatile__("yield");
+#else
+            std::this_thread::yield();
+#endif
+        }
     }
 
     TaskScheduler::TaskScheduler(size_t threadCount, Log::LogObject* logger)
@@ -46,6 +99,20 @@ namespace TaskGraph
         , m_failurePolicy(FailurePolicy::FailFast)
     {
         m_logger = logger;
+        m_executionMode.store(s_defaultExecutionMode.load(std::memory_order_acquire), std::memory_order_release);
+        if (threadCount == autoThreadCount)
+        {
+            const DefaultThreadCount detected = detectDefaultThreadCount();
+            m_autoThreadCount = true;
+            m_desiredThreadCount = detected.count;
+            m_threadCountSource.store(detected.source, std::memory_order_release);
+            m_threadCountCheckedAt = std::chrono::steady_clock::now();
+        }
+    }
+
+    DefaultThreadCount TaskScheduler::detectDefaultThreadCount()
+    {
+        return Internal::CpuQuota::detect();
     }
 
     Log::LogObject& TaskScheduler::logger()
@@ -73,6 +140,10 @@ namespace TaskGraph
         const QString taskName = task ? QString::fromStdString(task->getName()) : QString();
         emit guiEventRequested(requestId, taskName, payload);
 
+        // A pool worker waiting for the user is not busy (getBusyThreadCount).
+        const bool pooled = t_workerScheduler == this && (t_workerIndex >= 0 || t_workerIndex == compensatorIndex);
+        if (pooled)
+            m_busyThreads.fetch_sub(1, std::memory_order_acq_rel);
         std::unique_lock<std::mutex> lk(req->m);
         // Cooperative poll: if the task/graph is cancelled we exit without a value.
         while (!req->ready && !req->cancelled)
@@ -88,6 +159,8 @@ namespace TaskGraph
         const bool wasCancelled = req->cancelled;
         QVariant out = req->ready ? req->response : QVariant();
         lk.unlock();
+        if (pooled)
+            m_busyThreads.fetch_add(1, std::memory_order_acq_rel);
 
         {
             std::lock_guard<std::mutex> lock(m_pendingGuiMutex);
@@ -111,678 +184,2594 @@ namespace TaskGraph
             }
             req = it->second;
         }
+        std::function<void()> onDone;
         {
             std::lock_guard<std::mutex> lk(req->m);
             req->response = response;
             req->ready = true;
+            onDone = std::move(req->onDone);
         }
         req->cv.notify_one();
+        if (onDone)
+            onDone();
     }
 
     void TaskScheduler::cancelAllPendingGuiRequests()
     {
-        std::lock_guard<std::mutex> lock(m_pendingGuiMutex);
-        for (auto& kv : m_pendingGuiRequests)
+        std::vector<std::function<void()>> wakes;
         {
-            auto& req = kv.second;
+            std::lock_guard<std::mutex> lock(m_pendingGuiMutex);
+            for (auto& kv : m_pendingGuiRequests)
             {
-                std::lock_guard<std::mutex> lk(req->m);
-                req->cancelled = true;
+                auto& req = kv.second;
+                {
+                    std::lock_guard<std::mutex> lk(req->m);
+                    req->cancelled = true;
+                    if (req->onDone)
+                        wakes.push_back(std::move(req->onDone));
+                }
+                req->cv.notify_all();
             }
-            req->cv.notify_all();
         }
+        // Wakes take the scheduler mutex: fired after the request locks are released.
+        for (const auto& wake : wakes)
+            wake();
     }
 
-    TaskScheduler::~TaskScheduler()
+    int TaskScheduler::suspendForGui(Task* task, const QVariant& payload)
     {
-        // Cancel any in-progress run so workers drain promptly
-        if (m_isRunning.load(std::memory_order_acquire))
-            cancel();
+        // Same request as waitForGuiResponse, but answered through the coroutine wake.
+        const int requestId = allocateGuiRequestId();
+        auto req = std::make_shared<PendingGuiRequest>();
+        req->onDone = beginSuspend(task);
+        {
+            std::lock_guard<std::mutex> lock(m_pendingGuiMutex);
+            m_pendingGuiRequests[requestId] = req;
+        }
+        emit guiEventRequested(requestId, QString::fromStdString(task->getName()), payload);
+        return requestId;
+    }
 
-        // Disconnect all signals before joining — prevents emitting into
-        // already-destroyed receivers (widgets) during teardown
-        disconnect();
+    QVariant TaskScheduler::takeGuiResponse(int requestId)
+    {
+        std::shared_ptr<PendingGuiRequest> req;
+        {
+            std::lock_guard<std::mutex> lock(m_pendingGuiMutex);
+            auto it = m_pendingGuiRequests.find(requestId);
+            if (it == m_pendingGuiRequests.end())
+                return QVariant();
+            req = std::move(it->second);
+            m_pendingGuiRequests.erase(it);
+        }
+        std::lock_guard<std::mutex> lk(req->m);
+        return req->ready ? req->response : QVariant();
+    }
 
-        std::shared_ptr<std::thread> async;
+    uint64_t TaskScheduler::suspendForFd(Task* task, int fd, int events, std::shared_ptr<std::atomic<int>>& ready)
+    {
+        ready = std::make_shared<std::atomic<int>>(0);
+        std::function<void()> wake = beginSuspend(task);
+        const Internal::IoReactor::WatchId watch = m_reactor.watch(fd, events,
+            [ready, wake](int readyEvents) {
+                ready->store(readyEvents, std::memory_order_release);
+                wake();
+            });
+        if (watch == Internal::IoReactor::invalidWatch)
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            async = m_asyncThread;
-            m_asyncThread.reset();
+            ready->store(-1, std::memory_order_release);
+            wake();
         }
-        if (async && async->joinable())
-            async->join();
+        return watch;
+    }
+
+    void TaskScheduler::endFdWait(uint64_t watch)
+    {
+        m_reactor.unwatch(watch);
+    }
+
+    bool TaskScheduler::beginBlocking()
+    {
+        if (t_workerScheduler != this || !m_isRunning.load(std::memory_order_acquire))
+            return false;
+        if (t_blockingDepth++ > 0)
+            return true;
+        if (t_workerIndex >= 0 || t_workerIndex == compensatorIndex)
+            m_busyThreads.fetch_sub(1, std::memory_order_acq_rel);
+        const size_t blocked = m_blockedThreads.fetch_add(1, std::memory_order_acq_rel) + 1;
 
+        std::lock_guard<std::mutex> lock(m_compensatorMutex);
+        const size_t wanted = std::min(blocked, m_maxCompensatingThreads.load(std::memory_order_acquire));
+        if (m_stopCompensators || m_activeCompensators >= wanted)
+            return true;
+        // A spare (possibly still finishing the task it retired after) before a new thread.
+        Compensator* compensator = nullptr;
+        for (const auto& c : m_compensators)
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_stopThreads = true;
+            if (!c->active)
+            {
+                compensator = c.get();
+                break;
+            }
         }
-        m_cvTask.notify_all();
-        for (auto& t : m_threads)
+        if (!compensator)
         {
-            if (t && t->joinable())
-                t->join();
+            m_compensators.push_back(std::make_unique<Compensator>());
+            compensator = m_compensators.back().get();
+            compensator->exit = std::make_shared<std::atomic<bool>>(false);
+            compensator->thread = std::make_shared<std::thread>(compensatorThreadFunction, this, compensator);
         }
-        m_threads.clear();
-        m_threadExit.clear();
+        compensator->exit->store(false, std::memory_order_release);
+        compensator->active = true;
+        ++m_activeCompensators;
+        m_stats.compensations.fetch_add(1, std::memory_order_relaxed);
+        m_cvCompensator.notify_all();
+        return true;
     }
 
-    void TaskScheduler::ensureThreadsSpawned()
+    void TaskScheduler::endBlocking()
     {
-        if (m_desiredThreadCount == 0)
-            return;
-        if (!m_threads.empty())
+        if (--t_blockingDepth > 0)
             return;
+        const size_t blocked = m_blockedThreads.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        if (t_workerIndex >= 0 || t_workerIndex == compensatorIndex)
+            m_busyThreads.fetch_add(1, std::memory_order_acq_rel);
+
+        bool retired = false;
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_stopThreads = false;
+            std::lock_guard<std::mutex> lock(m_compensatorMutex);
+            if (m_activeCompensators > blocked)
+            {
+                for (auto it = m_compensators.rbegin(); it != m_compensators.rend(); ++it)
+                {
+                    if ((*it)->active)
+                    {
+                        (*it)->active = false;
+                        (*it)->exit->store(true, std::memory_order_release);
+                        --m_activeCompensators;
+                        retired = true;
+                        break;
+                    }
+                }
+            }
         }
-        for (size_t i = 0; i < m_desiredThreadCount; ++i)
+        if (retired)
         {
-            auto exitFlag = std::make_shared<std::atomic<bool>>(false);
-            m_threadExit.push_back(exitFlag);
-            m_threads.push_back(std::make_shared<std::thread>(taskThreadFunction, this, static_cast<int>(i), exitFlag));
+            // A parked compensator sees its exit flag in the wait predicate.
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+            }
+            m_cvTask.notify_all();
         }
     }
 
-    bool TaskScheduler::enableThreads(size_t threadCount)
+    void TaskScheduler::compensatorThreadFunction(TaskScheduler* obj, Compensator* compensator)
     {
-        m_lastError.store(Error::noError, std::memory_order_release);
-        if (m_isRunning.load(std::memory_order_acquire))
+        std::unique_lock<std::mutex> lock(obj->m_compensatorMutex);
+        while (true)
         {
-            Internal::TaskGraphLogger::logError("Cannot enable threads while the TaskScheduler is running");
-            m_lastError.store(Error::busy, std::memory_order_release);
-            return false;
+            obj->m_cvCompensator.wait(lock, [obj, compensator] { return compensator->active || obj->m_stopCompensators; });
+            if (obj->m_stopCompensators)
+                break;
+            lock.unlock();
+            taskThreadFunction(obj, compensatorIndex, nullptr, compensator->exit);
+            lock.lock();
         }
+    }
 
-        m_desiredThreadCount = threadCount;
-        const size_t current = m_threads.size();
-        if (threadCount == current)
-            return true;
-
-        if (threadCount > current)
+    void TaskScheduler::stopCompensators()
+    {
+        std::vector<std::unique_ptr<Compensator>> stopping;
         {
+            std::lock_guard<std::mutex> lock(m_compensatorMutex);
+            m_stopCompensators = true;
+            for (const auto& c : m_compensators)
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
-                m_stopThreads = false;
-            }
-            for (size_t i = current; i < threadCount; ++i)
-            {
-                auto exitFlag = std::make_shared<std::atomic<bool>>(false);
-                m_threadExit.push_back(exitFlag);
-                m_threads.push_back(std::make_shared<std::thread>(taskThreadFunction, this, static_cast<int>(i), exitFlag));
+                c->active = false;
+                c->exit->store(true, std::memory_order_release);
             }
-            return true;
+            m_activeCompensators = 0;
+            stopping.swap(m_compensators);
         }
-
-        // Shrink: signal only the surplus threads (from the back) to exit.
-        const size_t toStop = current - threadCount;
-        std::vector<std::shared_ptr<std::thread>> stopping;
-        stopping.reserve(toStop);
-        for (size_t i = 0; i < toStop; ++i)
+        m_cvCompensator.notify_all();
         {
-            m_threadExit.back()->store(true, std::memory_order_release);
-            stopping.push_back(m_threads.back());
-            m_threadExit.pop_back();
-            m_threads.pop_back();
+            std::lock_guard<std::mutex> lock(m_mutex);
         }
         m_cvTask.notify_all();
-        for (auto& t : stopping)
+        for (const auto& c : stopping)
         {
-            if (t && t->joinable())
-                t->join();
+            if (c->thread && c->thread->joinable())
+                c->thread->join();
         }
-        return true;
+        std::lock_guard<std::mutex> lock(m_compensatorMutex);
+        m_stopCompensators = false;
     }
 
-    bool TaskScheduler::disableThreads()
+    bool TaskScheduler::setResourceCapacity(const std::string& resource, size_t capacity)
     {
         m_lastError.store(Error::noError, std::memory_order_release);
         if (m_isRunning.load(std::memory_order_acquire))
         {
-            Internal::TaskGraphLogger::logError("Cannot disable threads while the TaskScheduler is running");
+            Internal::TaskGraphLogger::logError("Cannot change resource pools while the TaskScheduler is running");
             m_lastError.store(Error::busy, std::memory_order_release);
             return false;
         }
-        if (m_threads.empty())
-        {
-            m_desiredThreadCount = 0;
-            return true;
-        }
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_stopThreads = true;
-        }
-        m_cvTask.notify_all();
-        for (auto& thread : m_threads)
-        {
-            if (thread && thread->joinable())
-                thread->join();
-        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (capacity == 0)
+            m_resources.erase(resource);
+        else
+            m_resources[resource].capacity = capacity;
+        // Nodes point into m_resources; the next run resolves them again.
+        for (RunNode& node : m_nodes)
+            node.resourceNeeds.clear();
+        return true;
+    }
+
+    size_t TaskScheduler::getResourceCapacity(const std::string& resource) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_resources.find(resource);
+        return it != m_resources.end() ? it->second.capacity : 0;
+    }
+
+    bool TaskScheduler::setMemoryBudget(uint64_t bytes)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_stopThreads = false;
+            Internal::TaskGraphLogger::logError("Cannot change the memory budget while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
         }
-        m_threads.clear();
-        m_threadExit.clear();
-        m_desiredThreadCount = 0;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_memory.capacity = bytes > 0 ? static_cast<size_t>(std::min<uint64_t>(bytes, SIZE_MAX)) : SIZE_MAX;
         return true;
     }
 
-    void TaskScheduler::pause()
+    uint64_t TaskScheduler::getMemoryBudget() const
     {
-        bool expected = false;
-        if (!m_paused.compare_exchange_strong(expected, true,
-                                              std::memory_order_acq_rel,
-                                              std::memory_order_acquire))
-            return;
-        if (m_logger) m_logger->logInfo("Graph paused");
-        emit paused();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_memory.capacity == SIZE_MAX ? 0 : m_memory.capacity;
     }
 
-    void TaskScheduler::resume()
+    uint64_t TaskScheduler::getMemoryInUse() const
     {
-        bool expected = true;
-        if (!m_paused.compare_exchange_strong(expected, false,
-                                              std::memory_order_acq_rel,
-                                              std::memory_order_acquire))
-            return;
-        m_cvTask.notify_all();
-        if (m_logger) m_logger->logInfo("Graph resumed");
-        emit resumed();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_memory.inUse;
     }
 
-    bool TaskScheduler::addTask(const std::shared_ptr<Task>& task)
+    bool TaskScheduler::setAdaptiveConcurrency(const AdaptiveConcurrency& settings)
     {
         m_lastError.store(Error::noError, std::memory_order_release);
         if (m_isRunning.load(std::memory_order_acquire))
         {
-            Internal::TaskGraphLogger::logError("Cannot add task while the TaskScheduler is running");
+            Internal::TaskGraphLogger::logError("Cannot change adaptive concurrency while the TaskScheduler is running");
             m_lastError.store(Error::busy, std::memory_order_release);
             return false;
         }
+        AdaptiveConcurrency adaptive = settings;
+        adaptive.interval = std::max(adaptive.interval, std::chrono::milliseconds(1));
+        adaptive.samples = std::max(adaptive.samples, 1u);
+        adaptive.minThreads = std::max(adaptive.minThreads, 1u);
+        adaptive.raiseBelow = std::min(adaptive.raiseBelow, adaptive.lowerAbove);
         std::lock_guard<std::mutex> lock(m_mutex);
-        for (const auto& t : m_allTasks)
-        {
-            if (t == task)
-            {
-                Internal::TaskGraphLogger::logError("Task already added to the TaskScheduler");
-                m_lastError.store(Error::taskAlreadyAdded, std::memory_order_release);
-                return false;
-            }
-        }
-        m_allTasks.push_back(task);
-        m_taskGraph.clear();
+        m_adaptive = adaptive;
+        // A (re)configured controller starts with all workers.
+        m_adaptiveLimit = 0;
+        m_highPressureStreak = 0;
+        m_lowPressureStreak = 0;
+        m_concurrencyLimit.store(SIZE_MAX, std::memory_order_release);
         return true;
     }
 
-    bool TaskScheduler::removeTask(const std::shared_ptr<Task>& task)
+    TaskScheduler::AdaptiveConcurrency TaskScheduler::getAdaptiveConcurrency() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_adaptive;
+    }
+
+    bool TaskScheduler::setPressureProbe(PressureProbe probe)
     {
         m_lastError.store(Error::noError, std::memory_order_release);
         if (m_isRunning.load(std::memory_order_acquire))
         {
-            Internal::TaskGraphLogger::logError("Cannot remove task while the TaskScheduler is running");
+            Internal::TaskGraphLogger::logError("Cannot change the pressure probe while the TaskScheduler is running");
             m_lastError.store(Error::busy, std::memory_order_release);
             return false;
         }
         std::lock_guard<std::mutex> lock(m_mutex);
-        auto it = std::find(m_allTasks.begin(), m_allTasks.end(), task);
-        if (it == m_allTasks.end())
-            return false;
+        m_pressureProbe = std::move(probe);
+        return true;
+    }
 
-        // detach from other tasks' dependency lists
-        for (const auto& other : m_allTasks)
-        {
-            if (other == task)
-                continue;
-            auto deps = other->getDependencies();
-            bool hadDep = false;
-            for (const auto& d : deps)
-            {
-                if (d == task)
-                {
-                    hadDep = true;
-                    break;
-                }
-            }
-            if (hadDep)
-            {
-                other->clearDependencies();
-                for (const auto& d : deps)
-                {
-                    if (d != task)
-                        other->addDependency(d);
-                }
-            }
-        }
+    unsigned int TaskScheduler::getConcurrencyLimit() const
+    {
+        const size_t limit = m_concurrencyLimit.load(std::memory_order_acquire);
+        return static_cast<unsigned int>(std::min(limit, m_threads.size()));
+    }
 
-        m_allTasks.erase(it);
-        m_taskGraph.clear();
-        return true;
+    PressureSample TaskScheduler::getLastPressure() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lastPressure;
     }
 
-    TaskScheduler::Error TaskScheduler::buildTaskGraph(std::vector<TaskList> &taskGraph) const
+    void TaskScheduler::armPressureSample(uint64_t run, bool prime)
     {
-        TG_SCHEDULER_PROFILING_FUNCTION(TG_COLOR_STAGE_2);
-        struct Node
+        const auto delay = prime ? std::chrono::milliseconds(0) : m_adaptive.interval;
+        m_timers.arm(delay, [this, run, prime] { samplePressure(run, prime); });
+    }
+
+    void TaskScheduler::samplePressure(uint64_t run, bool prime)
+    {
+        PressureProbe probe;
         {
-            std::shared_ptr<Task> task = nullptr;
-            bool isVisited = false;
-        };
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // A timer of an earlier run ends the sampling chain.
+            if (run != m_runGeneration || !m_isRunning.load(std::memory_order_acquire))
+                return;
+            probe = m_pressureProbe;
+        }
 
-        m_lastError.store(Error::noError, std::memory_order_release);
-        std::unordered_map<Task*, Node> nodes;
-        nodes.reserve(m_allTasks.size());
-        for (const auto& task : m_allTasks)
-            nodes[task.get()].task = task;
+        // The proc files are read outside the scheduler mutex. Samples run one at a
+        // time on the timer thread, so the monitor needs no lock of its own.
+        PressureSample sample;
+        if (!probe)
+        {
+            if (prime)
+                m_pressureMonitor.reset();
+            sample = m_pressureMonitor.sample();
+        }
+        else if (!prime)
+        {
+            sample = probe();
+        }
 
-        for (const auto& task : m_allTasks)
+        size_t limit = 0;
+        size_t threads = 0;
+        bool raised = false;
         {
-            for (const auto& dependency : task->getDependencies())
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (run != m_runGeneration || !m_isRunning.load(std::memory_order_acquire))
+                return;
+            if (!prime)
+                m_lastPressure = sample;
+            if (sample.valid)
             {
-                if (!dependency || nodes.find(dependency.get()) == nodes.end())
+                const double pressure = sample.pressure();
+                if (pressure > m_adaptive.lowerAbove)
                 {
-                    Internal::TaskGraphLogger::logError("A dependency of \"" + task->getName() + "\" not found in the list of tasks");
-                    m_lastError.store(Error::missingDependency, std::memory_order_release);
-                    return Error::missingDependency;
+                    ++m_highPressureStreak;
+                    m_lowPressureStreak = 0;
                 }
-            }
+                else if (pressure < m_adaptive.raiseBelow)
+                {
+                    ++m_lowPressureStreak;
+                    m_highPressureStreak = 0;
+                }
+                else
+                {
+                    m_highPressureStreak = 0;
+                    m_lowPressureStreak = 0;
+                }
+
+                // Shed load quickly, add it back one worker at a time.
+                threads = m_threads.size();
+                const size_t floor = std::min<size_t>(m_adaptive.minThreads, threads);
+                size_t next = m_adaptiveLimit;
+                if (m_highPressureStreak >= m_adaptive.samples && m_adaptiveLimit > floor)
+                    next = std::max(floor, m_adaptiveLimit - std::max<size_t>(1, m_adaptiveLimit / 4));
+                else if (m_lowPressureStreak >= m_adaptive.samples && m_adaptiveLimit < threads)
+                    next = m_adaptiveLimit + 1;
+                if (next != m_adaptiveLimit)
+                {
+                    raised = next > m_adaptiveLimit;
+                    m_adaptiveLimit = next;
+                    m_highPressureStreak = 0;
+                    m_lowPressureStreak = 0;
+                    m_concurrencyLimit.store(next < threads ? next : SIZE_MAX, std::memory_order_release);
+                    limit = next;
+                }
+            }
+            armPressureSample(run, false);
+        }
+        if (limit == 0)
+            return;
+
+        // Name the dominant pressure in the report.
+        const char* source = "cpu";
+        double value = sample.cpu;
+        if (sample.memory > value) { source = "memory"; value = sample.memory; }
+        if (sample.io > value) { source = "io"; value = sample.io; }
+        if (sample.runQueue > value) { source = "run queue"; value = sample.runQueue; }
+        const std::string reason = std::string(source) + " pressure " + std::to_string(static_cast<int>(value * 100.0 + 0.5)) + "%";
+        m_stats.concurrencyChanges.fetch_add(1, std::memory_order_relaxed);
+        if (m_logger)
+            m_logger->logInfo(std::string(raised ? "Concurrency limit raised to " : "Concurrency limit lowered to ")
+                              + std::to_string(limit) + " of " + std::to_string(threads) + " workers (" + reason + ")");
+        emit concurrencyLimitChanged(static_cast<unsigned int>(limit), QString::fromStdString(reason));
+        if (raised)
+        {
+            // Parked workers re-check their predicate against the new limit.
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+            }
+            m_cvTask.notify_all();
+        }
+    }
+
+    size_t TaskScheduler::getResourceInUse(const std::string& resource) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_resources.find(resource);
+        return it != m_resources.end() ? it->second.inUse : 0;
+    }
+
+    void TaskScheduler::resolveResourcesLocked(RunNode& node)
+    {
+        node.resourceNeeds.clear();
+        node.holdsResources = false;
+        for (const auto& [name, units] : node.task->getResourceRequirements())
+        {
+            auto it = m_resources.find(name);
+            if (it != m_resources.end())
+                node.resourceNeeds.emplace_back(&it->second, std::min(units, it->second.capacity));
+        }
+        if (const uint64_t estimate = node.task->getMemoryEstimate())
+            node.resourceNeeds.emplace_back(&m_memory, static_cast<size_t>(std::min<uint64_t>(estimate, m_memory.capacity)));
+    }
+
+    bool TaskScheduler::resourcesFreeLocked(const RunNode* node) const
+    {
+        for (const auto& [pool, units] : node->resourceNeeds)
+        {
+            if (pool->capacity - pool->inUse < units)
+                return false;
+        }
+        return true;
+    }
+
+    void TaskScheduler::takeResourcesLocked(RunNode* node)
+    {
+        for (const auto& [pool, units] : node->resourceNeeds)
+            pool->inUse += units;
+        node->holdsResources = true;
+        if (m_memory.inUse > m_stats.peakMemoryInUse.load(std::memory_order_relaxed))
+            m_stats.peakMemoryInUse.store(m_memory.inUse, std::memory_order_relaxed);
+    }
+
+    void TaskScheduler::returnResourcesLocked(RunNode* node)
+    {
+        if (!node->holdsResources)
+            return;
+        for (const auto& [pool, units] : node->resourceNeeds)
+            pool->inUse -= units;
+        node->holdsResources = false;
+    }
+
+    bool TaskScheduler::acquireResources(RunNode* node)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // Waiting tasks come first on the pools they wait for.
+            bool queuedBehind = false;
+            for (const RunNode* waiter : m_resourceWaiters)
+            {
+                for (const auto& need : waiter->resourceNeeds)
+                {
+                    for (const auto& own : node->resourceNeeds)
+                        queuedBehind = queuedBehind || need.first == own.first;
+                }
+            }
+            if (!queuedBehind && resourcesFreeLocked(node))
+            {
+                takeResourcesLocked(node);
+                return true;
+            }
+            m_resourceWaiters.push_back(node);
+        }
+        m_stats.resourceWaits.fetch_add(1, std::memory_order_relaxed);
+        // The node is still counted in m_remaining, so the run goes on without it.
+        finishInFlight();
+        return false;
+    }
+
+    void TaskScheduler::releaseResources(RunNode* node)
+    {
+        size_t admitted = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            returnResourcesLocked(node);
+            // Oldest first. A waiter that still does not fit keeps the units of its
+            // pools for itself, so the ones behind it cannot overtake it.
+            std::vector<const ResourcePool*> reserved;
+            for (auto it = m_resourceWaiters.begin(); it != m_resourceWaiters.end();)
+            {
+                RunNode* waiter = *it;
+                const bool behind = std::any_of(waiter->resourceNeeds.begin(), waiter->resourceNeeds.end(),
+                    [&reserved](const std::pair<ResourcePool*, size_t>& need) {
+                        return std::find(reserved.begin(), reserved.end(), need.first) != reserved.end();
+                    });
+                if (!behind && resourcesFreeLocked(waiter))
+                {
+                    takeResourcesLocked(waiter);
+                    enqueueReadyLocked(waiter);
+                    it = m_resourceWaiters.erase(it);
+                    ++admitted;
+                    continue;
+                }
+                for (const auto& need : waiter->resourceNeeds)
+                    reserved.push_back(need.first);
+                ++it;
+            }
+        }
+        wakeWorkers(admitted);
+    }
+
+    bool TaskScheduler::setMaxCompensatingThreads(size_t count)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change the compensating thread limit while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_maxCompensatingThreads.store(count, std::memory_order_release);
+        return true;
+    }
+
+    unsigned int TaskScheduler::getCompensatingThreadCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_compensatorMutex);
+        return static_cast<unsigned int>(m_activeCompensators);
+    }
+
+    bool TaskScheduler::shouldYield(Task* task, std::chrono::steady_clock::time_point sliceStart)
+    {
+        if (!m_isRunning.load(std::memory_order_acquire) || m_queuedTasks.load(std::memory_order_acquire) == 0)
+            return false;
+        if (std::chrono::steady_clock::now() - sliceStart < getTimeSlice())
+            return false;
+        // FIFO: everything queued is older. An ordered queue may only hold tasks the
+        // yielding one outranks.
+        if (!m_readyQueue.isOrdered())
+            return true;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_nodeOf.find(task);
+        return it != m_nodeOf.end() && !m_readyQueue.outranksQueued(it->second);
+    }
+
+    void TaskScheduler::suspendForYield(Task* task)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_nodeOf.find(task);
+        if (it == m_nodeOf.end())
+            throw std::runtime_error("Coroutine task is not tracked by the scheduler");
+        it->second->coYielded = true;
+    }
+
+    void TaskScheduler::suspendForFileIo(Task* task, const FileIoRequest& request, std::shared_ptr<std::atomic<long>>& result)
+    {
+        result = std::make_shared<std::atomic<long>>(0);
+        std::function<void()> wake = beginSuspend(task, false);
+        Internal::FileIoService::Op op = Internal::FileIoService::Op::Read;
+        if (request.kind == FileIoRequest::Kind::Write)
+            op = Internal::FileIoService::Op::Write;
+        else if (request.kind == FileIoRequest::Kind::Sync)
+            op = Internal::FileIoService::Op::Sync;
+        m_fileIo.submit(op, request.fd, request.buffer, request.size, request.offset,
+            [result, wake](long bytes) {
+                result->store(bytes, std::memory_order_release);
+                wake();
+            });
+    }
+
+    TaskScheduler::~TaskScheduler()
+    {
+        // Cancel any in-progress run so workers drain promptly
+        const bool wasRunning = m_isRunning.load(std::memory_order_acquire);
+        if (wasRunning)
+            cancel();
+
+        // Disconnect all signals before joining — prevents emitting into
+        // already-destroyed receivers (widgets) during teardown
+        disconnect();
+
+        // An asynchronous run is finished by whichever thread retires its last task.
+        if (wasRunning)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvComplete.wait(lock, [this] { return !m_isRunning.load(std::memory_order_acquire); });
+        }
+
+        std::shared_ptr<std::thread> async;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            async = m_asyncThread;
+            m_asyncThread.reset();
+        }
+        if (async && async->joinable())
+            async->join();
+
+        stopCompensators();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopThreads = true;
+        }
+        m_cvTask.notify_all();
+        for (auto& t : m_threads)
+        {
+            if (t && t->joinable())
+                t->join();
+        }
+        m_threads.clear();
+        m_threadExit.clear();
+    }
+
+    void TaskScheduler::refreshDefaultThreadCount()
+    {
+        if (!m_autoThreadCount)
+            return;
+        // Reading the cgroup files costs a few file opens: not on every short run.
+        const auto now = std::chrono::steady_clock::now();
+        if (now - m_threadCountCheckedAt < std::chrono::seconds(1))
+            return;
+        m_threadCountCheckedAt = now;
+        const DefaultThreadCount detected = detectDefaultThreadCount();
+        m_threadCountSource.store(detected.source, std::memory_order_release);
+        if (detected.count == m_desiredThreadCount)
+            return;
+        if (m_logger)
+            m_logger->logInfo("Default thread count changed from " + std::to_string(m_desiredThreadCount) + " to "
+                              + std::to_string(detected.count) + " (" + detected.sourceName() + ")");
+        // Not spawned yet: ensureThreadsSpawned starts the new count.
+        if (m_threads.empty())
+            m_desiredThreadCount = detected.count;
+        else
+            resizeWorkers(detected.count);
+    }
+
+    void TaskScheduler::ensureThreadsSpawned()
+    {
+        refreshDefaultThreadCount();
+        if (m_desiredThreadCount == 0)
+            return;
+        if (!m_threads.empty())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopThreads = false;
+        }
+        publishStealTargets(m_desiredThreadCount);
+        for (size_t i = 0; i < m_desiredThreadCount; ++i)
+            spawnWorker(i);
+    }
+
+    void TaskScheduler::spawnWorker(size_t index)
+    {
+        auto exitFlag = std::make_shared<std::atomic<bool>>(false);
+        m_threadExit.push_back(exitFlag);
+        m_threads.push_back(std::make_shared<std::thread>(taskThreadFunction, this, static_cast<int>(index),
+                                                          m_workerQueues[index].get(), exitFlag));
+    }
+
+    void TaskScheduler::publishStealTargets(size_t count)
+    {
+        while (m_workerQueues.size() < count)
+            m_workerQueues.push_back(std::make_unique<WorkerQueue>());
+
+        auto targets = std::make_unique<StealTargets>();
+        targets->queues.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            targets->queues.push_back(m_workerQueues[i].get());
+        m_stealTargets.store(targets.get());
+        m_stealTargetHistory.push_back(std::move(targets));
+        releaseStealTargets();
+    }
+
+    void TaskScheduler::releaseStealTargets()
+    {
+        // Thieves register before they load m_stealTargets, both seq_cst: with none
+        // registered now, later ones can only see the current snapshot.
+        if (m_stealTargetHistory.size() <= 1 || m_stealReaders.load() != 0)
+            return;
+        m_stealTargetHistory.erase(m_stealTargetHistory.begin(), m_stealTargetHistory.end() - 1);
+    }
+
+    bool TaskScheduler::setExecutionMode(ExecutionMode mode)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change the execution mode while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_executionMode.store(mode, std::memory_order_release);
+        return true;
+    }
+
+    void TaskScheduler::setDefaultExecutionMode(ExecutionMode mode)
+    {
+        s_defaultExecutionMode.store(mode, std::memory_order_release);
+    }
+
+    TaskScheduler::ExecutionMode TaskScheduler::getDefaultExecutionMode()
+    {
+        return s_defaultExecutionMode.load(std::memory_order_acquire);
+    }
+
+    bool TaskScheduler::setSchedulingPolicy(SchedulingPolicy policy)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change the scheduling policy while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_schedulingPolicy.store(policy, std::memory_order_release);
+        return true;
+    }
+
+    bool TaskScheduler::setPriorityAging(std::chrono::milliseconds interval)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change the priority aging while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_priorityAgingMs.store(interval.count() > 0 ? interval.count() : 0, std::memory_order_release);
+        return true;
+    }
+
+    bool TaskScheduler::setIdlePolicy(IdlePolicy policy)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change the idle policy while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_idlePolicy.store(policy, std::memory_order_release);
+        return true;
+    }
+
+    bool TaskScheduler::setTimeSlice(std::chrono::microseconds slice)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change the time slice while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_timeSliceUs.store(slice.count() > 0 ? slice.count() : 0, std::memory_order_release);
+        return true;
+    }
+
+    bool TaskScheduler::setFileIoBackend(FileIoBackend backend)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change the file I/O backend while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_fileIo.setUseIoUring(backend == FileIoBackend::Auto);
+        return true;
+    }
+
+    TaskScheduler::FileIoBackend TaskScheduler::getFileIoBackend() const
+    {
+        return m_fileIo.getUseIoUring() ? FileIoBackend::Auto : FileIoBackend::ThreadPool;
+    }
+
+    std::string TaskScheduler::getActiveFileIoBackend() const
+    {
+        switch (m_fileIo.getBackend())
+        {
+            case Internal::FileIoService::Backend::IoUring:
+                return "io_uring";
+            case Internal::FileIoService::Backend::ThreadPool:
+                return "thread pool";
+            default:
+                return "none";
+        }
+    }
+
+    bool TaskScheduler::setIdleSpinDuration(std::chrono::microseconds duration)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change the idle spin duration while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_idleSpinUs.store(duration.count() > 0 ? duration.count() : 0, std::memory_order_release);
+        return true;
+    }
+
+    bool TaskScheduler::setSuccessorHandoff(bool enabled)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change the successor handoff while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_successorHandoff.store(enabled, std::memory_order_release);
+        return true;
+    }
+
+    bool TaskScheduler::setCallerParticipates(bool enabled)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot change caller participation while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        m_callerParticipates.store(enabled, std::memory_order_release);
+        return true;
+    }
+
+    bool TaskScheduler::enableThreads(size_t threadCount)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot enable threads while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+
+        if (threadCount == autoThreadCount)
+        {
+            const DefaultThreadCount detected = detectDefaultThreadCount();
+            m_autoThreadCount = true;
+            m_threadCountSource.store(detected.source, std::memory_order_release);
+            m_threadCountCheckedAt = std::chrono::steady_clock::now();
+            threadCount = detected.count;
+        }
+        else
+        {
+            m_autoThreadCount = false;
+            m_threadCountSource.store(ThreadCountSource::Explicit, std::memory_order_release);
+        }
+        resizeWorkers(threadCount);
+        return true;
+    }
+
+    void TaskScheduler::resizeWorkers(size_t threadCount)
+    {
+        m_desiredThreadCount = threadCount;
+        const size_t current = m_threads.size();
+        if (threadCount == current)
+            return;
+
+        if (threadCount > current)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopThreads = false;
+            }
+            publishStealTargets(threadCount);
+            for (size_t i = current; i < threadCount; ++i)
+                spawnWorker(i);
+            return;
+        }
+
+        // Shrink: signal only the surplus threads (from the back) to exit.
+        const size_t toStop = current - threadCount;
+        std::vector<std::shared_ptr<std::thread>> stopping;
+        stopping.reserve(toStop);
+        for (size_t i = 0; i < toStop; ++i)
+        {
+            m_threadExit.back()->store(true, std::memory_order_release);
+            stopping.push_back(m_threads.back());
+            m_threadExit.pop_back();
+            m_threads.pop_back();
+        }
+        publishStealTargets(threadCount);
+        m_cvTask.notify_all();
+        for (auto& t : stopping)
+        {
+            if (t && t->joinable())
+                t->join();
+        }
+        return;
+    }
+
+    bool TaskScheduler::disableThreads()
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot disable threads while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        stopCompensators();
+        if (m_threads.empty())
+        {
+            m_desiredThreadCount = 0;
+            m_autoThreadCount = false;
+            m_threadCountSource.store(ThreadCountSource::Explicit, std::memory_order_release);
+            return true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopThreads = true;
+        }
+        m_cvTask.notify_all();
+        for (auto& thread : m_threads)
+        {
+            if (thread && thread->joinable())
+                thread->join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopThreads = false;
+        }
+        m_threads.clear();
+        m_threadExit.clear();
+        m_desiredThreadCount = 0;
+        m_autoThreadCount = false;
+        m_threadCountSource.store(ThreadCountSource::Explicit, std::memory_order_release);
+        return true;
+    }
+
+    void TaskScheduler::pause()
+    {
+        bool expected = false;
+        if (!m_paused.compare_exchange_strong(expected, true,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire))
+            return;
+        if (m_logger) m_logger->logInfo("Graph paused");
+        emit paused();
+    }
+
+    void TaskScheduler::resume()
+    {
+        bool expected = true;
+        if (!m_paused.compare_exchange_strong(expected, false,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire))
+            return;
+        m_cvTask.notify_all();
+        m_cvComplete.notify_all();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_cvJoin.notify_all();
+        if (m_logger) m_logger->logInfo("Graph resumed");
+        emit resumed();
+    }
+
+    bool TaskScheduler::addTask(const std::shared_ptr<Task>& task)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot add task while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& t : m_allTasks)
+        {
+            if (t == task)
+            {
+                Internal::TaskGraphLogger::logError("Task already added to the TaskScheduler");
+                m_lastError.store(Error::taskAlreadyAdded, std::memory_order_release);
+                return false;
+            }
+        }
+        m_allTasks.push_back(task);
+        m_taskGraph.clear();
+        m_plan.valid = false;
+        return true;
+    }
+
+    bool TaskScheduler::removeTask(const std::shared_ptr<Task>& task)
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot remove task while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find(m_allTasks.begin(), m_allTasks.end(), task);
+        if (it == m_allTasks.end())
+            return false;
+
+        // detach from other tasks' dependency lists
+        for (const auto& other : m_allTasks)
+        {
+            if (other == task)
+                continue;
+            auto deps = other->getDependencies();
+            bool hadDep = false;
+            for (const auto& d : deps)
+            {
+                if (d == task)
+                {
+                    hadDep = true;
+                    break;
+                }
+            }
+            if (hadDep)
+            {
+                other->clearDependencies();
+                for (const auto& d : deps)
+                {
+                    if (d != task)
+                        other->addDependency(d);
+                }
+            }
+        }
+
+        m_allTasks.erase(it);
+        m_taskGraph.clear();
+        m_plan.valid = false;
+        return true;
+    }
+
+    TaskScheduler::Error TaskScheduler::buildTaskGraph(std::vector<TaskList> &taskGraph) const
+    {
+        TG_SCHEDULER_PROFILING_FUNCTION(TG_COLOR_STAGE_2);
+        m_lastError.store(Error::noError, std::memory_order_release);
+
+        // Kahn's algorithm, one frontier per layer: O(V + E). A task lands in the
+        // layer after its deepest dependency, same as the classic level scan.
+        const size_t count = m_allTasks.size();
+        std::unordered_map<Task*, size_t> indexOf;
+        indexOf.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            indexOf[m_allTasks[i].get()] = i;
+
+        std::vector<size_t> inDegree(count, 0);
+        std::vector<size_t> successorOffsets(count + 1, 0);
+        std::vector<size_t> depIndices;
+        std::vector<size_t> depOffsets(count + 1, 0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (const auto& dependency : m_allTasks[i]->getDependencies())
+            {
+                auto it = dependency ? indexOf.find(dependency.get()) : indexOf.end();
+                if (it == indexOf.end())
+                {
+                    Internal::TaskGraphLogger::logError("A dependency of \"" + m_allTasks[i]->getName() + "\" not found in the list of tasks");
+                    m_lastError.store(Error::missingDependency, std::memory_order_release);
+                    return Error::missingDependency;
+                }
+                depIndices.push_back(it->second);
+                ++successorOffsets[it->second + 1];
+            }
+            depOffsets[i + 1] = depIndices.size();
+            inDegree[i] = depOffsets[i + 1] - depOffsets[i];
+        }
+
+        for (size_t i = 0; i < count; ++i)
+            successorOffsets[i + 1] += successorOffsets[i];
+        std::vector<size_t> successors(depIndices.size());
+        std::vector<size_t> fill(successorOffsets.begin(), successorOffsets.end() - 1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (size_t k = depOffsets[i]; k < depOffsets[i + 1]; ++k)
+                successors[fill[depIndices[k]]++] = i;
+        }
+
+        taskGraph.clear();
+        std::vector<size_t> frontier;
+        std::vector<size_t> next;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (inDegree[i] == 0)
+                frontier.push_back(i);
+        }
+
+        size_t placed = 0;
+        while (!frontier.empty())
+        {
+            TaskList layer;
+            layer.reserve(frontier.size());
+            for (size_t i : frontier)
+            {
+                layer.push_back(m_allTasks[i]);
+                for (size_t k = successorOffsets[i]; k < successorOffsets[i + 1]; ++k)
+                {
+                    if (--inDegree[successors[k]] == 0)
+                        next.push_back(successors[k]);
+                }
+            }
+            placed += layer.size();
+            taskGraph.push_back(std::move(layer));
+            frontier.swap(next);
+            next.clear();
+        }
+
+        if (placed != count)
+        {
+            taskGraph.clear();
+            Internal::TaskGraphLogger::logError("Dependency graph is not directed acyclic. (Circular dependency)");
+            m_lastError.store(Error::dependencyGraphNotDAG, std::memory_order_release);
+            return Error::dependencyGraphNotDAG;
+        }
+        return Error::noError;
+    }
+
+    bool TaskScheduler::compile()
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+        if (m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Cannot compile while the TaskScheduler is running");
+            m_lastError.store(Error::busy, std::memory_order_release);
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return compileLocked() == Error::noError;
+    }
+
+    bool TaskScheduler::isCompiled() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_plan.valid && m_plan.topologyVersion == topologyVersion();
+    }
+
+    uint64_t TaskScheduler::topologyVersion() const
+    {
+        uint64_t version = 0;
+        for (const auto& t : m_allTasks)
+            version += t->getTopologyVersion();
+        return version;
+    }
+
+    TaskScheduler::Error TaskScheduler::compileLocked()
+    {
+        TG_SCHEDULER_PROFILING_FUNCTION(TG_COLOR_STAGE_2);
+        m_plan.valid = false;
+
+        std::vector<TaskList> layered;
+        Error err = buildTaskGraph(layered);
+        if (err != Error::noError)
+            return err;
+
+        const size_t count = m_allTasks.size();
+        m_nodes.clear();
+        m_nodeOf.clear();
+        m_nodeOf.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            RunNode& node = m_nodes.emplace_back();
+            node.task = m_allTasks[i];
+            node.index = i;
+            m_nodeOf[node.task.get()] = &node;
+        }
+
+        // Count the successors of every node, then scatter them into one
+        // contiguous array (CSR).
+        std::vector<TaskList> deps(count);
+        m_plan.successorOffsets.assign(count + 1, 0);
+        m_plan.initialPending.assign(count, 0);
+        m_plan.roots.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            deps[i] = m_allTasks[i]->getDependencies();
+            m_plan.initialPending[i] = static_cast<int>(deps[i].size());
+            for (const auto& d : deps[i])
+                ++m_plan.successorOffsets[m_nodeOf[d.get()]->index + 1];
+            if (deps[i].empty())
+                m_plan.roots.push_back(&m_nodes[i]);
+        }
+        for (size_t i = 0; i < count; ++i)
+            m_plan.successorOffsets[i + 1] += m_plan.successorOffsets[i];
+
+        m_plan.successors.assign(m_plan.successorOffsets[count], nullptr);
+        std::vector<size_t> fill(m_plan.successorOffsets.begin(), m_plan.successorOffsets.end() - 1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (const auto& d : deps[i])
+                m_plan.successors[fill[m_nodeOf[d.get()]->index]++] = &m_nodes[i];
+        }
+
+        m_plan.order.clear();
+        m_plan.order.reserve(count);
+        for (const auto& layer : layered)
+        {
+            for (const auto& t : layer)
+                m_plan.order.push_back(m_nodeOf[t.get()]);
+        }
+
+        m_plan.topologyVersion = topologyVersion();
+        m_taskGraph = std::move(layered);
+        m_plan.valid = true;
+        return Error::noError;
+    }
+
+    template <typename Fn>
+    void TaskScheduler::forEachDependent(RunNode* node, Fn&& fn)
+    {
+        if (node->index < m_plan.initialPending.size())
+        {
+            const size_t end = m_plan.successorOffsets[node->index + 1];
+            for (size_t i = m_plan.successorOffsets[node->index]; i < end; ++i)
+                fn(m_plan.successors[i]);
+        }
+        for (RunNode* d : node->dependents)
+            fn(d);
+    }
+
+    void TaskScheduler::ReadyQueue::configure(bool ordered, std::chrono::microseconds aging)
+    {
+        m_ordered.store(ordered, std::memory_order_release);
+        m_aging = aging;
+        m_epoch = std::chrono::steady_clock::now();
+        m_sequence = 0;
+    }
+
+    void TaskScheduler::ReadyQueue::assignKey(RunNode* node)
+    {
+        node->readySeq = m_sequence++;
+        node->priorityKey = node->task->getPriority();
+        if (m_aging.count() > 0)
+        {
+            const auto waitedFromEpoch = std::chrono::steady_clock::now() - m_epoch;
+            node->priorityKey -= std::chrono::duration<double>(waitedFromEpoch)
+                               / std::chrono::duration<double>(m_aging);
+        }
+    }
+
+    void TaskScheduler::ReadyQueue::push(RunNode* node)
+    {
+        assignKey(node);
+        if (!m_ordered.load(std::memory_order_relaxed))
+        {
+            if (node->task->getPriority() == 0)
+            {
+                m_fifo.push_back(node);
+                return;
+            }
+            // First prioritized task: keys of the FIFO part are already set.
+            m_heap.assign(m_fifo.begin(), m_fifo.end());
+            m_fifo.clear();
+            std::make_heap(m_heap.begin(), m_heap.end(), &ReadyQueue::lowerPriority);
+            m_ordered.store(true, std::memory_order_release);
+        }
+        m_heap.push_back(node);
+        std::push_heap(m_heap.begin(), m_heap.end(), &ReadyQueue::lowerPriority);
+    }
+
+    bool TaskScheduler::ReadyQueue::outranksQueued(RunNode* node)
+    {
+        assignKey(node);
+        // An ordered queue keeps everything in the heap (see push).
+        return m_heap.empty() || lowerPriority(m_heap.front(), node);
+    }
+
+    TaskScheduler::RunNode* TaskScheduler::ReadyQueue::pop()
+    {
+        if (!m_fifo.empty())
+        {
+            RunNode* node = m_fifo.front();
+            m_fifo.pop_front();
+            return node;
+        }
+        if (m_heap.empty())
+            return nullptr;
+        std::pop_heap(m_heap.begin(), m_heap.end(), &ReadyQueue::lowerPriority);
+        RunNode* node = m_heap.back();
+        m_heap.pop_back();
+        return node;
+    }
+
+    void TaskScheduler::ReadyQueue::clear()
+    {
+        m_fifo.clear();
+        m_heap.clear();
+        m_sequence = 0;
+    }
+
+    void TaskScheduler::ReadyQueue::drainTo(NodeDeque& out)
+    {
+        for (RunNode* n : m_fifo)
+            out.push_back(n);
+        for (RunNode* n : m_heap)
+            out.push_back(n);
+        m_fifo.clear();
+        m_heap.clear();
+    }
+
+    bool TaskScheduler::ReadyQueue::lowerPriority(const RunNode* a, const RunNode* b)
+    {
+        if (a->priorityKey != b->priorityKey)
+            return a->priorityKey < b->priorityKey;
+        if (a->rank != b->rank)
+            return a->rank < b->rank;
+        return a->readySeq > b->readySeq;
+    }
+
+    double TaskScheduler::taskCost(const Task& task) const
+    {
+        const auto measured = task.getLastDuration().count();
+        if (measured > 0)
+            return static_cast<double>(measured);
+        return task.getWeight() * m_costPerWeight;
+    }
+
+    void TaskScheduler::computeRanks()
+    {
+        // Tasks that never ran are costed by weight, scaled to the mean duration per
+        // unit of weight of the measured ones so both kinds of cost are comparable.
+        double measuredUs = 0.0;
+        double measuredWeight = 0.0;
+        for (RunNode& node : m_nodes)
+        {
+            const auto us = node.task->getLastDuration().count();
+            if (us > 0)
+            {
+                measuredUs += static_cast<double>(us);
+                measuredWeight += node.task->getWeight();
+            }
+        }
+        m_costPerWeight = measuredWeight > 0.0 ? measuredUs / measuredWeight : 1.0;
+
+        // Upward rank: own cost plus the largest rank among the successors.
+        for (auto it = m_plan.order.rbegin(); it != m_plan.order.rend(); ++it)
+        {
+            RunNode* node = *it;
+            double longest = 0.0;
+            forEachDependent(node, [&longest](RunNode* d) { longest = std::max(longest, d->rank); });
+            node->rank = taskCost(*node->task) + longest;
+        }
+    }
+
+    void TaskScheduler::runTasks()
+    {
+        TG_SCHEDULER_PROFILING_FUNCTION(TG_COLOR_STAGE_1);
+        m_lastError.store(Error::noError, std::memory_order_release);
+
+        bool expected = false;
+        if (!m_isRunning.compare_exchange_strong(expected, true,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("Task scheduler is already running");
+            m_lastError.store(Error::alreadyRunning, std::memory_order_release);
+            return;
+        }
+        runTasksBody();
+    }
+
+    void TaskScheduler::runTasksBody()
+    {
+        if (!beginRun(false))
+            return;
+
+        if (m_threads.empty())
+        {
+            while (true)
+            {
+                RunNode* next = nullptr;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    next = popReadyLocked();
+                }
+                if (!next)
+                {
+                    // Parked retries come back through the timer thread.
+                    if (!waitForWorkOrDrain())
+                        break;
+                    continue;
+                }
+                m_stats.tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+                executeNode(next);
+            }
+        }
+        else if (m_callerParticipates.load(std::memory_order_acquire))
+        {
+            participateUntilDrained();
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvComplete.wait(lock, [this] { return m_remaining.load() == 0 && m_inFlight.load() == 0; });
+        }
+        finishRun();
+    }
+
+    bool TaskScheduler::beginRun(bool finishOnDrain)
+    {
+        RunningGuard guard(m_isRunning);
+
+        ensureThreadsSpawned();
+        // Snapshots a thief still held when the pool was last resized.
+        releaseStealTargets();
+
+        // Auto-reset all tasks so a graph can be re-run without manual resetTasks()
+        uint64_t version = 0;
+        for (const auto& t : m_allTasks)
+        {
+            t->reset();
+            version += t->getTopologyVersion();
+        }
+
+        if (m_allTasks.empty())
+        {
+            Internal::TaskGraphLogger::logWarning("No tasks to run");
+            m_lastError.store(Error::noTasks, std::memory_order_release);
+            return false;
+        }
+
+        size_t rootCount = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_plan.valid || m_plan.topologyVersion != version)
+            {
+                Error err = compileLocked();
+                if (err != Error::noError)
+                {
+                    lock.unlock();
+                    Internal::TaskGraphLogger::logError("Error building task graph: " + std::to_string(err));
+                    m_lastError.store(err, std::memory_order_release);
+                    return false;
+                }
+            }
+
+            clearReadyQueuesLocked();
+            m_aborting.store(false, std::memory_order_release);
+            m_cancelRequested.store(false, std::memory_order_release);
+            m_stealingRun.store(m_executionMode.load(std::memory_order_acquire) == ExecutionMode::WorkStealing
+                                && !m_threads.empty(), std::memory_order_release);
+            const bool criticalPath = m_schedulingPolicy.load(std::memory_order_acquire) == SchedulingPolicy::CriticalPath;
+            m_readyQueue.configure(criticalPath, std::chrono::milliseconds(m_priorityAgingMs.load(std::memory_order_acquire)));
+
+            // Steady state: the plan is reused, only the per-node counters are reset.
+            for (auto& entry : m_resources)
+                entry.second.inUse = 0;
+            m_memory.inUse = 0;
+            double weightSum = 0.0;
+            for (RunNode& node : m_nodes)
+            {
+                node.pending.store(m_plan.initialPending[node.index], std::memory_order_relaxed);
+                node.retired.store(false, std::memory_order_relaxed);
+                node.sealed = false;
+                node.dependents.clear();
+                node.rank = 0.0;
+                node.retryAttempt = 0;
+                node.coWaiting = false;
+                node.coReleased = false;
+                node.coWoken = false;
+                node.coPinned = false;
+                node.coYielded = false;
+                node.settleWaiters.clear();
+                resolveResourcesLocked(node);
+                weightSum += node.task->getWeight();
+            }
+
+            m_totalTasks.store(m_nodes.size());
+            m_remaining.store(m_nodes.size());
+            // The setup holds one in-flight token until its last signal is out, so
+            // the run cannot be finished (possibly on a worker) before it started.
+            m_inFlight.store(1);
+            m_finishOnDrain.store(finishOnDrain);
+            m_finishClaimed.store(false);
+            ++m_runGeneration;
+            if (m_adaptive.enabled && !m_threads.empty())
+            {
+                const size_t threads = m_threads.size();
+                if (m_adaptiveLimit == 0 || m_adaptiveLimit > threads)
+                    m_adaptiveLimit = threads;
+                m_adaptiveLimit = std::max(m_adaptiveLimit, std::min<size_t>(m_adaptive.minThreads, threads));
+                m_highPressureStreak = 0;
+                m_lowPressureStreak = 0;
+                m_concurrencyLimit.store(m_adaptiveLimit < threads ? m_adaptiveLimit : SIZE_MAX, std::memory_order_release);
+                armPressureSample(m_runGeneration, true);
+            }
+            else
+            {
+                m_concurrencyLimit.store(SIZE_MAX, std::memory_order_release);
+            }
+            m_parkedRetries.store(0);
+            m_weightSum.store(weightSum);
+            m_completedWeight.store(0.0);
+
+            if (criticalPath)
+            {
+                computeRanks();
+                std::sort(m_plan.roots.begin(), m_plan.roots.end(),
+                          [](const RunNode* a, const RunNode* b) { return a->rank > b->rank; });
+            }
+
+            // Roots are spread round-robin over the worker deques in WorkStealing mode
+            // so every worker starts with local work instead of stealing. Pushed at
+            // the front, they leave the owner's LIFO end in dispatch order.
+            const bool stealing = m_stealingRun.load(std::memory_order_acquire);
+            rootCount = m_plan.roots.size();
+            size_t next = 0;
+            for (RunNode* node : m_plan.roots)
+            {
+                if (stealing && node->task->getPriority() == 0)
+                {
+                    WorkerQueue* q = m_workerQueues[next++ % m_threads.size()].get();
+                    std::lock_guard<std::mutex> qLock(q->mutex);
+                    q->tasks.push_front(node);
+                    m_queuedTasks.fetch_add(1);
+                }
+                else
+                {
+                    enqueueReadyLocked(node);
+                }
+            }
+        }
+
+        emit started();
+        if (m_logger) m_logger->logInfo("Graph run started (" + std::to_string(m_totalTasks.load()) + " tasks)");
+        emit statusMessage(QStringLiteral("Executing tasks"));
+        m_progress = 0;
+        m_progressF.store(0.0f, std::memory_order_release);
+        emit progressUpdate(m_progress);
+        emit progressChangedF(0.0f);
+
+        wakeWorkers(rootCount);
+
+        guard.disarm();
+        finishInFlight();
+        return true;
+    }
+
+    void TaskScheduler::finishRun()
+    {
+        // A parked retry that was cancelled still holds its context; release it
+        // (outside the lock) before the run is reported as over.
+        if (m_parkedRetries.load() > 0)
+        {
+            std::vector<std::unique_ptr<TaskContext>> contexts;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (RunNode& node : m_nodes)
+                {
+                    if (node.context)
+                        contexts.push_back(std::move(node.context));
+                }
+            }
+        }
+        dropSpawnedNodes();
+
+        const bool wasCancelled = m_cancelRequested.load(std::memory_order_acquire);
+
+        // Force final progress to exactly 1.0 only on full success
+        if (!wasCancelled)
+        {
+            m_progress = 100;
+            m_progressF.store(1.0f, std::memory_order_release);
+            emit progressUpdate(100);
+            emit progressChangedF(1.0f);
+        }
+
+        {
+            // Under the mutex: a destructor waiting for the run to end cannot miss it.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isRunning.store(false, std::memory_order_release);
+        }
+        m_cvComplete.notify_all();
+        if (m_logger) m_logger->logInfo(wasCancelled ? "Graph run ended (cancelled)" : "Graph run completed");
+        if (wasCancelled)
+            emit cancelled();
+        emit completed();
+    }
+
+    void TaskScheduler::dropSpawnedNodes()
+    {
+        // Nodes past the plan were spawned during the run. Run-only ones (fork-join
+        // children) are no part of the graph; the others made the plan stale, so the
+        // next run recompiles anyway. The tasks are released outside the lock.
+        std::vector<std::shared_ptr<Task>> spawned;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            size_t runOnly = 0;
+            while (m_nodes.size() > m_plan.initialPending.size())
+            {
+                RunNode& node = m_nodes.back();
+                if (node.runOnly)
+                    ++runOnly;
+                m_nodeOf.erase(node.task.get());
+                spawned.push_back(std::move(node.task));
+                m_nodes.pop_back();
+            }
+            m_totalTasks.fetch_sub(runOnly);
+        }
+    }
+
+    void TaskScheduler::runTasksAsync()
+    {
+        m_lastError.store(Error::noError, std::memory_order_release);
+
+        // Flip m_isRunning to true *synchronously* so that any caller polling
+        // isRunning() immediately after runTasksAsync() observes the scheduler
+        // as running. Without this, the async thread had not yet executed
+        // runTasks()'s compare_exchange, so a fast poller could see false and
+        // proceed as if the scheduler had already finished.
+        bool expected = false;
+        if (!m_isRunning.compare_exchange_strong(expected, true,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_acquire))
+        {
+            m_lastError.store(Error::alreadyRunning, std::memory_order_release);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_asyncThread && m_asyncThread->joinable())
+                m_asyncThread->join();
+            m_asyncThread.reset();
+        }
+
+        ensureThreadsSpawned();
+        if (m_threads.empty())
+        {
+            // Without a pool somebody has to execute the tasks: a runner thread.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_asyncThread = std::make_shared<std::thread>([this]
+            {
+                TG_SCHEDULER_PROFILING_THREAD("AsyncThread");
+                runTasksBody();
+            });
+            return;
+        }
+
+        // With a pool no coordinator thread is needed: the run is set up here and
+        // finished by whichever thread retires its last task.
+        beginRun(true);
+    }
+
+    void TaskScheduler::cancel()
+    {
+        m_cancelRequested.store(true, std::memory_order_release);
+        if (m_logger) m_logger->logWarning("Graph cancel requested");
+        RetireBatch batch;
+        size_t woken = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& t : m_allTasks)
+                t->cancel();
+            // Run-only fork-join children are not in m_allTasks.
+            for (RunNode& node : m_nodes)
+            {
+                if (node.runOnly)
+                    node.task->cancel();
+            }
+            m_aborting.store(true, std::memory_order_release);
+            woken = cancelPendingLocked(batch);
+            // Suspended coroutine bodies resume to see the cancel (CancelledError).
+            for (RunNode& node : m_nodes)
+            {
+                if (node.coWaiting && !node.coPinned && wakeCoroutineLocked(&node))
+                    ++woken;
+            }
+        }
+        cancelAllPendingGuiRequests();
+        commitRetired(batch);
+        m_cvTask.notify_all();
+        wakeWorkers(woken);
+    }
+
+    size_t TaskScheduler::cancelPendingLocked(RetireBatch& batch)
+    {
+        NodeDeque drained;
+        m_readyQueue.drainTo(drained);
+        m_urgentQueued.store(0);
+        drained.insert(drained.end(), m_resourceWaiters.begin(), m_resourceWaiters.end());
+        m_resourceWaiters.clear();
+        for (const auto& q : m_workerQueues)
+        {
+            std::lock_guard<std::mutex> qLock(q->mutex);
+            for (RunNode* n : q->tasks)
+                drained.push_back(n);
+            q->tasks.clear();
+        }
+        m_queuedTasks.store(0);
+
+        size_t requeued = 0;
+        for (RunNode* node : drained)
+        {
+            if (node->task->getStatus() == Task::Status::Running)
+            {
+                // A woken coroutine body: only its own frame can finish the task.
+                enqueueReadyLocked(node);
+                ++requeued;
+                continue;
+            }
+            // Anything else leaving the queue here would otherwise never be retired.
+            const Task::Status status = node->task->getStatus();
+            if (status == Task::Status::Pending || status == Task::Status::Ready)
+                node->task->cancel();
+            // Units handed over while it waited in the queue.
+            returnResourcesLocked(node);
+            seal(node, batch);
+            if (retire(node, batch))
+                emit taskFinished(QString::fromStdString(node->task->getName()));
+        }
+        for (RunNode& node : m_nodes)
+        {
+            if (node.task->getStatus() == Task::Status::Cancelled)
+            {
+                seal(&node, batch);
+                retire(&node, batch);
+            }
+        }
+        return requeued;
+    }
+
+    bool TaskScheduler::retire(RunNode* node, RetireBatch& batch)
+    {
+        if (node->retired.exchange(true, std::memory_order_acq_rel))
+            return false;
+        ++batch.count;
+        batch.weight += node->task->getWeight();
+        return true;
+    }
+
+    void TaskScheduler::seal(RunNode* node, RetireBatch& batch)
+    {
+        std::lock_guard<std::mutex> lock(node->edgeMutex);
+        node->sealed = true;
+        for (auto& wake : node->settleWaiters)
+            batch.wakes.push_back(std::move(wake));
+        node->settleWaiters.clear();
+    }
+
+    void TaskScheduler::commitRetired(const RetireBatch& batch)
+    {
+        for (const auto& wake : batch.wakes)
+            wake();
+        if (batch.count == 0)
+            return;
+        m_completedWeight.fetch_add(batch.weight);
+        m_remaining.fetch_sub(batch.count);
+        wakeJoiners();
+        notifyIfRunDrained();
+    }
+
+    void TaskScheduler::finishInFlight()
+    {
+        m_inFlight.fetch_sub(1);
+        notifyIfRunDrained();
+    }
+
+    void TaskScheduler::notifyIfRunDrained()
+    {
+        // Both counters are sequentially consistent: whichever thread performs the
+        // last of the two decrements observes both at zero here (possibly together
+        // with another thread, hence the claim flag below).
+        if (m_remaining.load() != 0 || m_inFlight.load() != 0)
+            return;
+        if (m_finishOnDrain.load())
+        {
+            if (!m_finishClaimed.exchange(true))
+                finishRun();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_cvComplete.notify_all();
+    }
+
+    bool TaskScheduler::waitForWorkOrDrain()
+    {
+        // Pairs with wakeWorkers like m_idleWorkers does for the pool.
+        auto drained = [this] { return m_remaining.load() == 0 && m_inFlight.load() == 0; };
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_callerIdle.store(true);
+        m_cvComplete.wait(lock, [this, &drained] {
+            return drained()
+                || (!m_paused.load(std::memory_order_acquire) && m_queuedTasks.load() > 0);
+        });
+        m_callerIdle.store(false);
+        return !drained();
+    }
+
+    void TaskScheduler::participateUntilDrained()
+    {
+        // The caller acts as one more worker without a deque: it takes work from the
+        // ready queue, steals in WorkStealing mode and runs handed-off successors.
+        // The caller may itself be a worker of another scheduler.
+        TaskScheduler* const outerScheduler = t_workerScheduler;
+        const int outerIndex = t_workerIndex;
+        t_workerScheduler = this;
+        t_workerIndex = -1;
+        uint32_t rng = 0x2545F491u;
+        while (true)
+        {
+            RunNode* node = takeReadyNode(nullptr, rng);
+            if (!node)
+            {
+                if (!waitForWorkOrDrain())
+                    break;
+                continue;
+            }
+
+            while (node)
+            {
+                m_stats.tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+                node = executeNode(node);
+            }
+        }
+        t_workerScheduler = outerScheduler;
+        t_workerIndex = outerIndex;
+    }
+
+    TaskScheduler::RunNode* TaskScheduler::takeReadyNode(WorkerQueue* own, uint32_t& rng)
+    {
+        if (m_paused.load(std::memory_order_acquire))
+            return nullptr;
+        RunNode* node = nullptr;
+        if (m_stealingRun.load(std::memory_order_acquire))
+        {
+            if (m_urgentQueued.load() > 0)
+                node = popUrgent();
+            if (!node)
+                node = popLocalOrSteal(own, rng);
+        }
+        if (!node && m_queuedTasks.load(std::memory_order_acquire) > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            node = popReadyLocked();
+        }
+        return node;
+    }
+
+    bool TaskScheduler::joinTasks(const std::vector<std::shared_ptr<Task>>& tasks, Task* waiter, bool spawn)
+    {
+        if (!waiter)
+            return false;
+        // A GUI-affine body runs on the GUI thread. Waiting there would stall the
+        // event loop that GUI-affine children are posted to.
+        if (waiter->getAffinity() == Task::TaskAffinity::Gui)
+        {
+            Internal::TaskGraphLogger::logError("join: not allowed from a task with TaskAffinity::Gui");
+            return false;
+        }
+        if (!m_isRunning.load(std::memory_order_acquire))
+        {
+            Internal::TaskGraphLogger::logError("join: scheduler not running");
+            return false;
+        }
+
+        bool spawnedAll = true;
+        std::vector<std::shared_ptr<Task>> spawned;
+        if (spawn)
+        {
+            for (const auto& t : tasks)
+            {
+                if (insertDynamicTask(t, waiter, true))
+                    spawned.push_back(t);
+                else
+                    spawnedAll = false;
+            }
+        }
+        const std::vector<std::shared_ptr<Task>>& joined = spawn ? spawned : tasks;
+
+        std::vector<RunNode*> nodes;
+        nodes.reserve(joined.size());
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& t : joined)
+            {
+                auto it = t ? m_nodeOf.find(t.get()) : m_nodeOf.end();
+                if (it == m_nodeOf.end())
+                {
+                    Internal::TaskGraphLogger::logError("join: task not tracked");
+                    return false;
+                }
+                // The waiter stays in flight until the join returns: anything that
+                // (transitively) depends on it would never run.
+                if (waitsForLocked(it->second, waiter))
+                {
+                    Internal::TaskGraphLogger::logError("join: \"" + t->getName() + "\" waits for the joining task");
+                    return false;
+                }
+                nodes.push_back(it->second);
+            }
         }
 
-        taskGraph.clear();
+        // Retirement is final for the run, unlike the status: a failed attempt
+        // turns Pending again when it is retried.
+        auto finished = [&nodes] {
+            return std::all_of(nodes.begin(), nodes.end(),
+                               [](const RunNode* n) { return n->retired.load(std::memory_order_acquire); });
+        };
 
-        while (true)
+        // The waiter's own node stays in flight, so the run cannot end meanwhile.
+        // Nodes executed here may join in turn; the nesting follows the recursion.
+        WorkerQueue* own = (t_workerScheduler == this && t_workerIndex >= 0)
+            ? m_workerQueues[t_workerIndex].get() : nullptr;
+        uint32_t rng = 0x68E31DA4u ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(waiter));
+        while (!finished())
         {
-            bool allVisited = true;
-            for (auto& node : nodes)
+            RunNode* node = takeReadyNode(own, rng);
+            if (!node)
             {
-                if (!node.second.isVisited) { allVisited = false; break; }
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_joinWaiters.fetch_add(1);
+                // Pairs with the fence in wakeJoiners.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_cvJoin.wait(lock, [this, &finished] {
+                    return finished()
+                        || (!m_paused.load(std::memory_order_acquire) && m_queuedTasks.load() > 0);
+                });
+                m_joinWaiters.fetch_sub(1);
+                continue;
             }
-            if (allVisited)
-                break;
-
-            TaskList layer;
-            for (auto& node : nodes)
+            while (node)
             {
-                if (node.second.isVisited)
-                    continue;
-                auto deps = node.second.task->getDependencies();
-                bool allDepsVisited = std::all_of(deps.begin(), deps.end(),
-                    [&nodes](const std::shared_ptr<Task>& dep)
-                    {
-                        auto it = nodes.find(dep.get());
-                        return it != nodes.end() && it->second.isVisited;
-                    });
-                if (allDepsVisited)
-                    layer.push_back(node.second.task);
+                m_stats.tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+                m_stats.joinHelps.fetch_add(1, std::memory_order_relaxed);
+                node = executeNode(node);
             }
-            if (layer.empty())
+        }
+        return spawnedAll && std::all_of(joined.begin(), joined.end(),
+                                         [](const std::shared_ptr<Task>& t) { return t->isDone(); });
+    }
+
+    bool TaskScheduler::waitsForLocked(RunNode* node, const Task* waiter)
+    {
+        // Walks up the declared dependencies only. A retired node ends its path:
+        // it is final for the run, so whatever lies behind it holds nothing back.
+        std::vector<RunNode*> stack{ node };
+        std::unordered_set<RunNode*> seen;
+        while (!stack.empty())
+        {
+            RunNode* cur = stack.back();
+            stack.pop_back();
+            if (cur->task.get() == waiter)
+                return true;
+            if (cur->retired.load(std::memory_order_acquire) || !seen.insert(cur).second)
+                continue;
+            for (const auto& dep : cur->task->getDependencies())
             {
-                Internal::TaskGraphLogger::logError("Dependency graph is not directed acyclic. (Circular dependency)");
-                m_lastError.store(Error::dependencyGraphNotDAG, std::memory_order_release);
-                return Error::dependencyGraphNotDAG;
+                auto it = m_nodeOf.find(dep.get());
+                if (it != m_nodeOf.end())
+                    stack.push_back(it->second);
             }
-            for (auto& t : layer)
-                nodes[t.get()].isVisited = true;
-            taskGraph.push_back(std::move(layer));
         }
-        return Error::noError;
+        return false;
     }
 
-    void TaskScheduler::runTasks()
+    void TaskScheduler::wakeJoiners()
     {
-        TG_SCHEDULER_PROFILING_FUNCTION(TG_COLOR_STAGE_1);
-        m_lastError.store(Error::noError, std::memory_order_release);
-
-        bool expected = false;
-        if (!m_isRunning.compare_exchange_strong(expected, true,
-                                                 std::memory_order_acq_rel,
-                                                 std::memory_order_acquire))
-        {
-            Internal::TaskGraphLogger::logError("Task scheduler is already running");
-            m_lastError.store(Error::alreadyRunning, std::memory_order_release);
+        // Either the waiter sees the retired node in its predicate, or the fence
+        // orders its registration before our load and it is notified.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_joinWaiters.load() == 0)
             return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
         }
-        runTasksBody();
+        m_cvJoin.notify_all();
     }
 
-    void TaskScheduler::runTasksBody()
+    size_t TaskScheduler::parallelGrain(size_t count, size_t grain) const
     {
-        RunningGuard guard(m_isRunning);
-
-        ensureThreadsSpawned();
-
-        // Auto-reset all tasks so a graph can be re-run without manual resetTasks()
-        for (const auto& t : m_allTasks)
-            t->reset();
+        if (grain > 0)
+            return grain;
+        // About eight chunks per thread even out uneven chunks while the per-chunk
+        // overhead stays small. The pool does not change while running.
+        const size_t target = (m_threads.size() + 1) * 8;
+        return std::max<size_t>(1, (count + target - 1) / target);
+    }
 
+    bool TaskScheduler::runParallelLoop(const TaskContext& ctx, size_t begin, size_t end, size_t grain,
+                                        const std::function<void(size_t, size_t, size_t)>& body)
+    {
+        if (end <= begin)
+            return true;
+        auto loop = std::make_shared<ParallelLoop>();
+        loop->ctx = &ctx;
+        loop->body = &body;
+        loop->begin = begin;
+        loop->end = end;
+        loop->grain = std::max<size_t>(1, grain);
+        loop->chunkCount = (end - begin - 1) / loop->grain + 1;
+
+        // A single chunk, or no workers: nothing to share.
+        const bool shared = loop->chunkCount > 1 && !m_threads.empty()
+            && m_isRunning.load(std::memory_order_acquire);
+        if (shared)
         {
-            std::vector<TaskList> layered;
-            Error err = buildTaskGraph(layered);
-            if (err != Error::noError)
             {
-                Internal::TaskGraphLogger::logError("Error building task graph: " + std::to_string(err));
-                m_lastError.store(err, std::memory_order_release);
-                return;
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_loops.push_back(loop);
+                m_openLoops.fetch_add(1);
             }
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_taskGraph = std::move(layered);
+            wakeWorkers(std::min(loop->chunkCount - 1, m_threads.size()));
         }
-
-        if (m_allTasks.empty())
+        runLoopChunks(*loop, false);
+        if (shared)
         {
-            Internal::TaskGraphLogger::logWarning("No tasks to run");
-            m_lastError.store(Error::noTasks, std::memory_order_release);
-            return;
+            delistLoop(loop);
+            // The body and the context live on this stack; no helper may still use them.
+            std::unique_lock<std::mutex> lock(loop->mutex);
+            loop->cv.wait(lock, [&loop] { return loop->helpers == 0; });
         }
+        if (loop->error)
+            std::rethrow_exception(loop->error);
+        return loop->finished.load() == loop->chunkCount;
+    }
 
+    void TaskScheduler::runLoopChunks(ParallelLoop& loop, bool helping)
+    {
+        while (!loop.stopped.load(std::memory_order_acquire))
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_inDegree.clear();
-            m_dependents.clear();
-            m_aliveByPtr.clear();
-            m_readyQueue.clear();
-            m_aborting = false;
-            m_cancelRequested.store(false, std::memory_order_release);
-            m_totalTasks = m_allTasks.size();
-            m_remaining = m_totalTasks;
-            m_weightSum = 0.0;
-            m_completedWeight = 0.0;
-
-            for (const auto& t : m_allTasks)
+            const size_t chunk = loop.nextChunk.fetch_add(1);
+            if (chunk >= loop.chunkCount)
+                break;
+            if (loop.ctx->isCancelRequested())
             {
-                m_aliveByPtr[t.get()] = t;
-                m_weightSum += t->getWeight();
+                loop.stopped.store(true, std::memory_order_release);
+                break;
             }
-
-            for (const auto& t : m_allTasks)
+            const size_t b = loop.begin + chunk * loop.grain;
+            const size_t e = b + std::min(loop.grain, loop.end - b);
+            try
             {
-                auto deps = t->getDependencies();
-                m_inDegree[t.get()] = static_cast<int>(deps.size());
-                for (const auto& d : deps)
-                    m_dependents[d.get()].push_back(t.get());
+                (*loop.body)(chunk, b, e);
+                loop.finished.fetch_add(1);
             }
-
-            for (const auto& t : m_allTasks)
+            catch (...)
             {
-                if (m_inDegree[t.get()] == 0)
-                    m_readyQueue.push_back(t);
+                std::lock_guard<std::mutex> lock(loop.mutex);
+                if (!loop.error)
+                    loop.error = std::current_exception();
+                loop.stopped.store(true, std::memory_order_release);
             }
+            if (helping)
+                m_stats.loopHelps.fetch_add(1, std::memory_order_relaxed);
         }
+    }
 
-        emit started();
-        if (m_logger) m_logger->logInfo("Graph run started (" + std::to_string(m_totalTasks) + " tasks)");
-        emit statusMessage(QStringLiteral("Executing tasks"));
-        m_progress = 0;
-        m_progressF.store(0.0f, std::memory_order_release);
-        emit progressUpdate(m_progress);
-        emit progressChangedF(0.0f);
+    void TaskScheduler::delistLoop(const std::shared_ptr<ParallelLoop>& loop)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find(m_loops.begin(), m_loops.end(), loop);
+        if (it == m_loops.end())
+            return;
+        m_loops.erase(it);
+        m_openLoops.fetch_sub(1);
+    }
 
-        m_cvTask.notify_all();
+    bool TaskScheduler::helpParallelLoop()
+    {
+        std::shared_ptr<ParallelLoop> loop;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_loops.empty())
+                return false;
+            // The newest loop first: with nested loops it is the one being waited on.
+            loop = m_loops.back();
+            std::lock_guard<std::mutex> loopLock(loop->mutex);
+            ++loop->helpers;
+        }
+        m_busyThreads.fetch_add(1, std::memory_order_acq_rel);
+        runLoopChunks(*loop, true);
+        m_busyThreads.fetch_sub(1, std::memory_order_acq_rel);
+        // All chunks are claimed (or the loop stopped): stop attracting workers.
+        delistLoop(loop);
+        {
+            std::lock_guard<std::mutex> lock(loop->mutex);
+            if (--loop->helpers != 0)
+                return true;
+        }
+        loop->cv.notify_all();
+        return true;
+    }
 
-        if (m_threads.empty())
+    void TaskScheduler::skipDescendants(RunNode* root, RetireBatch& batch)
+    {
+        std::unordered_set<RunNode*> visited;
+        std::vector<RunNode*> stack;
+        forEachDependent(root, [&stack](RunNode* d) { stack.push_back(d); });
+
+        while (!stack.empty())
+        {
+            RunNode* cur = stack.back();
+            stack.pop_back();
+            if (!visited.insert(cur).second)
+                continue;
+            // Seal first so a dynamic spawn cannot attach to a node being skipped.
+            seal(cur, batch);
+            const auto& sp = cur->task;
+            if (sp->getStatus() == Task::Status::Pending
+                || sp->getStatus() == Task::Status::Ready)
+            {
+                sp->skip();
+                if (retire(cur, batch))
+                    emit taskFinished(QString::fromStdString(sp->getName()));
+            }
+            forEachDependent(cur, [&stack](RunNode* d) { stack.push_back(d); });
+        }
+    }
+
+    TaskScheduler::RunNode* TaskScheduler::executeNode(RunNode* node)
+    {
+        const std::shared_ptr<Task>& task = node->task;
+        // Read without the lock: only the thread holding the node changes either.
+        if (!node->resourceNeeds.empty() && !node->holdsResources && !acquireResources(node))
+            return nullptr;
+        // Only workers (and a participating caller) marshal GUI tasks; the thread-less
+        // (sync) mode, or a caller that is the GUI thread itself, runs them inline.
+        if (task->getAffinity() == Task::TaskAffinity::Gui && t_workerScheduler == this
+            && task->thread() != QThread::currentThread())
+        {
+            std::shared_ptr<Task> t = task;
+            TaskScheduler* self = this;
+            QMetaObject::invokeMethod(t.get(), [t, node, self]() {
+                // A coroutine is resumed here too each time it is woken.
+                if (t->isCoroutine() || node->coroutine)
+                {
+                    self->executeCoroutine(node);
+                    return;
+                }
+                {
+                    std::unique_ptr<TaskContext> ctx = self->makeContext(t.get());
+                    const Internal::TimerService::TimerId watchdog = self->armWatchdog(t);
+                    t->runTask(ctx.get());
+                    self->m_timers.disarm(watchdog);
+                }
+                self->onTaskCompleted(node);
+            }, Qt::QueuedConnection);
+            return nullptr;
+        }
+
+        // Also a plain body that went on waiting for an askGuiThen answer.
+        if (task->isCoroutine() || node->coroutine)
+            return executeCoroutine(node);
+        if (node->retryAttempt == 0)
+            emit taskStarted(QString::fromStdString(task->getName()));
+        bool parked = false;
+        bool continued = false;
+        TG_GENERAL_PROFILING_NONSCOPED_BLOCK("Process task", TG_COLOR_STAGE_2);
         {
+            // One context per task-run, reused across all retry attempts (kept in the
+            // node while a retry is parked). Destroyed before completion is reported
+            // so the run cannot end while it lives.
+            std::unique_ptr<TaskContext> ctx = std::move(node->context);
+            if (!ctx)
+                ctx = makeContext(task.get());
             while (true)
             {
-                std::shared_ptr<Task> next;
+                const Internal::TimerService::TimerId watchdog = armWatchdog(task, node);
+                if (task->beginBody())
                 {
-                    std::lock_guard<std::mutex> lock(m_mutex);
-                    if (m_readyQueue.empty())
-                        break;
-                    next = m_readyQueue.front();
-                    m_readyQueue.pop_front();
+                    ctx->beginSlice();
+                    const std::exception_ptr error = task->invokeBody(ctx.get());
+                    if (ctx->hasContinuation())
+                    {
+                        if (!error)
+                        {
+                            // The attempt goes on as a coroutine that waits for the answer or fd,
+                            // under the same watchdog.
+                            node->coWatchdog = watchdog;
+                            node->coroutine = ctx->runContinuations(false);
+                            node->context = std::move(ctx);
+                            continued = true;
+                            break;
+                        }
+                        ctx->dropContinuation();
+                    }
+                    task->endBody(error);
                 }
-                // Sync mode: no watchdog thread arming; run inline with retries.
-                int attempts = 0;
-                // One context per task-run, reused across all retry attempts.
-                std::unique_ptr<TaskContext> ctx = m_contextFactory
-                    ? m_contextFactory(next.get(), this)
-                    : std::make_unique<TaskContext>(next.get(), this);
-                while (true)
+                m_timers.disarm(watchdog);
+                if (task->getStatus() == Task::Status::Failed
+                    && node->retryAttempt < task->getMaxRetries()
+                    && !m_cancelRequested.load(std::memory_order_acquire))
                 {
-                    armWatchdog(next);
-                    next->runTask(ctx.get());
-                    if (next->getStatus() == Task::Status::Failed
-                        && attempts < next->getMaxRetries()
-                        && !m_cancelRequested.load(std::memory_order_acquire))
+                    const int attempt = ++node->retryAttempt;
+                    task->logger().logWarning("Task retry attempt " + std::to_string(attempt));
+                    const auto delay = retryDelay(*task, attempt);
+                    if (delay.count() > 0)
                     {
-                        ++attempts;
-                        next->logger().logWarning("Task retry attempt " + std::to_string(attempts));
-                        auto backoff = next->getRetryBackoff();
-                        if (backoff.count() > 0)
-                            std::this_thread::sleep_for(backoff);
-                        next->prepareRetry();
-                        continue;
+                        parkForRetry(node, std::move(ctx), delay);
+                        parked = true;
+                        break;
                     }
-                    break;
+                    task->prepareRetry();
+                    continue;
                 }
-                onTaskCompleted(next);
+                break;
             }
         }
-        else
-        {
-            std::unique_lock<std::mutex> lock(m_mutex);
-            m_cvComplete.wait(lock, [this] { return m_remaining == 0; });
-        }
+        TG_GENERAL_PROFILING_END_BLOCK;
+        if (parked)
+            return nullptr;
+        if (continued)
+            return executeCoroutine(node);
+        return onTaskCompleted(node);
+    }
 
-        const bool wasCancelled = m_cancelRequested.load(std::memory_order_acquire);
+    std::unique_ptr<TaskContext> TaskScheduler::makeContext(Task* task)
+    {
+        return m_contextFactory
+            ? m_contextFactory(task, this)
+            : std::make_unique<TaskContext>(task, this);
+    }
 
-        // Force final progress to exactly 1.0 only on full success
-        if (!wasCancelled)
+    TaskScheduler::RunNode* TaskScheduler::executeCoroutine(RunNode* node)
+    {
+        const std::shared_ptr<Task>& task = node->task;
+        if (!node->coroutine && node->retryAttempt == 0)
+            emit taskStarted(QString::fromStdString(task->getName()));
+
+        // The context and frame stay in the node across suspensions. An attempt that
+        // suspends returns here with the node released; its wake queues it again.
+        while (true)
         {
-            m_progress = 100;
-            m_progressF.store(1.0f, std::memory_order_release);
-            emit progressUpdate(100);
-            emit progressChangedF(1.0f);
-        }
+            std::exception_ptr error;
+            if (!node->coroutine)
+            {
+                if (!node->context)
+                    node->context = makeContext(task.get());
+                if (!task->beginBody())
+                    break;
+                node->coWatchdog = armWatchdog(task, node);
+                try
+                {
+                    node->coroutine = task->startCoroutine(*node->context);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+            }
+            if (node->coroutine)
+            {
+                node->context->beginSlice();
+                if (!node->coroutine.resume())
+                {
+                    bool yielded = false;
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (node->coYielded)
+                        {
+                            node->coYielded = false;
+                            enqueueReadyLocked(node);
+                            yielded = true;
+                        }
+                        // Woken before the frame got back here: keep going on this thread.
+                        else if (node->coWoken)
+                        {
+                            node->coWoken = false;
+                            continue;
+                        }
+                        else
+                            node->coReleased = true;
+                    }
+                    if (yielded)
+                    {
+                        m_stats.yields.fetch_add(1, std::memory_order_relaxed);
+                        finishInFlight();
+                        wakeWorkers(1);
+                        return nullptr;
+                    }
+                    m_stats.suspensions.fetch_add(1, std::memory_order_relaxed);
+                    finishInFlight();
+                    return nullptr;
+                }
+                error = node->coroutine.error();
+                node->coroutine.reset();
+            }
+            m_timers.disarm(node->coWatchdog);
+            node->coWatchdog = Internal::TimerService::invalidTimer;
+            task->endBody(error);
 
-        guard.disarm();
-        m_isRunning.store(false, std::memory_order_release);
-        if (m_logger) m_logger->logInfo(wasCancelled ? "Graph run ended (cancelled)" : "Graph run completed");
-        if (wasCancelled)
-            emit cancelled();
-        emit completed();
+            if (task->getStatus() == Task::Status::Failed
+                && node->retryAttempt < task->getMaxRetries()
+                && !m_cancelRequested.load(std::memory_order_acquire))
+            {
+                const int attempt = ++node->retryAttempt;
+                task->logger().logWarning("Task retry attempt " + std::to_string(attempt));
+                const auto delay = retryDelay(*task, attempt);
+                if (delay.count() > 0)
+                {
+                    parkForRetry(node, std::move(node->context), delay);
+                    return nullptr;
+                }
+                task->prepareRetry();
+                continue;
+            }
+            break;
+        }
+        node->context.reset();
+        return onTaskCompleted(node);
     }
 
-    void TaskScheduler::runTasksAsync()
+    std::function<void()> TaskScheduler::beginSuspend(Task* task, bool interruptible)
     {
-        m_lastError.store(Error::noError, std::memory_order_release);
-
-        // Flip m_isRunning to true *synchronously* so that any caller polling
-        // isRunning() immediately after runTasksAsync() observes the scheduler
-        // as running. Without this, the async thread had not yet executed
-        // runTasks()'s compare_exchange, so a fast poller could see false and
-        // proceed as if the scheduler had already finished.
-        bool expected = false;
-        if (!m_isRunning.compare_exchange_strong(expected, true,
-                                                 std::memory_order_acq_rel,
-                                                 std::memory_order_acquire))
+        RunNode* node;
+        uint64_t seq;
+        uint64_t run;
         {
-            m_lastError.store(Error::alreadyRunning, std::memory_order_release);
-            return;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_nodeOf.find(task);
+            if (it == m_nodeOf.end())
+                throw std::runtime_error("Coroutine task is not tracked by the scheduler");
+            node = it->second;
+            node->coWaiting = true;
+            node->coPinned = !interruptible;
+            seq = ++node->coSeq;
+            run = m_runGeneration;
         }
+        return [this, node, seq, run] { wakeCoroutine(node, seq, run); };
+    }
 
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_asyncThread && m_asyncThread->joinable())
-            m_asyncThread->join();
+    void TaskScheduler::wakeCoroutine(RunNode* node, uint64_t seq, uint64_t run)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // A wake of an earlier run must not touch the node: it may be gone.
+            if (run != m_runGeneration || !m_isRunning.load(std::memory_order_acquire))
+                return;
+            if (!node->coWaiting || (seq != 0 && node->coSeq != seq) || (seq == 0 && node->coPinned))
+                return;
+            if (!wakeCoroutineLocked(node))
+                return;
+        }
+        wakeWorkers(1);
+    }
 
-        m_asyncThread = std::make_shared<std::thread>([this]
+    bool TaskScheduler::wakeCoroutineLocked(RunNode* node)
+    {
+        node->coWaiting = false;
+        ++node->coSeq;
+        if (!node->coReleased)
         {
-            TG_SCHEDULER_PROFILING_THREAD("AsyncThread");
-            runTasksBody();
-        });
+            node->coWoken = true;
+            return false;
+        }
+        node->coReleased = false;
+        enqueueReadyLocked(node);
+        return true;
     }
 
-    void TaskScheduler::cancel()
+    bool TaskScheduler::isTaskSettled(Task* waiter, const Task& awaited)
     {
-        m_cancelRequested.store(true, std::memory_order_release);
-        if (m_logger) m_logger->logWarning("Graph cancel requested");
+        RunNode* node;
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            for (const auto& t : m_allTasks)
-                t->cancel();
-            m_aborting = true;
-            cancelPendingLocked();
+            auto it = m_nodeOf.find(const_cast<Task*>(&awaited));
+            if (it == m_nodeOf.end())
+                return true;
+            // The suspended waiter is not retired: a dependent of it never settles.
+            if (waitsForLocked(it->second, waiter))
+                throw std::runtime_error("\"" + awaited.getName() + "\" waits for the awaiting task");
+            node = it->second;
         }
-        cancelAllPendingGuiRequests();
-        m_cvTask.notify_all();
-        m_cvComplete.notify_all();
+        std::lock_guard<std::mutex> edgeLock(node->edgeMutex);
+        return node->sealed;
     }
 
-    void TaskScheduler::cancelPendingLocked()
+    void TaskScheduler::suspendUntilSettled(Task* waiter, const Task& awaited)
     {
-        while (!m_readyQueue.empty())
+        RunNode* node = nullptr;
         {
-            auto t = m_readyQueue.front();
-            m_readyQueue.pop_front();
-            if (t->getStatus() == Task::Status::Cancelled)
-            {
-                if (m_remaining > 0) --m_remaining;
-                m_completedWeight += t->getWeight();
-                emit taskFinished(QString::fromStdString(t->getName()));
-            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_nodeOf.find(const_cast<Task*>(&awaited));
+            if (it != m_nodeOf.end())
+                node = it->second;
         }
-        for (const auto& t : m_allTasks)
+        std::function<void()> wake = beginSuspend(waiter);
+        if (node)
         {
-            if (t->getStatus() == Task::Status::Cancelled)
+            std::lock_guard<std::mutex> edgeLock(node->edgeMutex);
+            if (!node->sealed)
             {
-                auto it = m_inDegree.find(t.get());
-                if (it != m_inDegree.end() && it->second >= 0)
-                {
-                    it->second = -1;
-                    if (m_remaining > 0) --m_remaining;
-                    m_completedWeight += t->getWeight();
-                }
+                node->settleWaiters.push_back(std::move(wake));
+                return;
             }
         }
+        // Settled since await_ready(): resume right away.
+        wake();
     }
 
-    void TaskScheduler::skipDescendantsLocked(Task* root)
+    void TaskScheduler::suspendFor(Task* task, std::chrono::milliseconds delay)
     {
-        std::unordered_set<Task*> visited;
-        std::vector<Task*> stack;
-        auto it = m_dependents.find(root);
-        if (it == m_dependents.end())
-            return;
-        for (Task* d : it->second)
-            stack.push_back(d);
+        std::function<void()> wake = beginSuspend(task);
+        if (m_timers.arm(delay, wake) == Internal::TimerService::invalidTimer)
+            wake();
+    }
 
-        while (!stack.empty())
+    std::chrono::milliseconds TaskScheduler::retryDelay(const Task& task, int attempt) const
+    {
+        auto delay = task.getRetryDelay(attempt);
+        const double jitter = task.getRetryJitter();
+        if (jitter > 0.0 && delay.count() > 0)
         {
-            Task* cur = stack.back();
-            stack.pop_back();
-            if (!visited.insert(cur).second)
-                continue;
-            auto alive = m_aliveByPtr.find(cur);
-            if (alive == m_aliveByPtr.end())
-                continue;
-            const auto& sp = alive->second;
-            if (sp->getStatus() == Task::Status::Pending
-                || sp->getStatus() == Task::Status::Ready)
+            thread_local uint32_t state = 0x6C8E9CF5u
+                ^ static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+            const double unit = (nextRandom(state) >> 8) / static_cast<double>(1u << 24);
+            delay = std::chrono::milliseconds(static_cast<int64_t>(delay.count() * (1.0 - jitter * unit)));
+        }
+        return delay;
+    }
+
+    void TaskScheduler::parkForRetry(RunNode* node, std::unique_ptr<TaskContext> ctx, std::chrono::milliseconds delay)
+    {
+        // The node stays counted in m_remaining, so the run cannot end while it is
+        // parked, but it leaves m_inFlight: the worker is free right away. Pending
+        // again, a cancel or FailFast abort retires it like any other waiting task.
+        node->context = std::move(ctx);
+        // The backoff does not hold resource units; the retry acquires them again.
+        if (node->holdsResources)
+            releaseResources(node);
+        uint64_t run;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            run = m_runGeneration;
+            m_parkedRetries.fetch_add(1);
+        }
+        node->task->prepareRetry();
+        m_stats.retriesParked.fetch_add(1, std::memory_order_relaxed);
+        m_timers.arm(delay, [this, node, run] { requeueRetry(node, run); });
+        finishInFlight();
+    }
+
+    void TaskScheduler::requeueRetry(RunNode* node, uint64_t run)
+    {
+        RetireBatch batch;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // A timer of an earlier run must not touch the node: it may be gone.
+            if (run != m_runGeneration || !m_isRunning.load(std::memory_order_acquire))
+                return;
+            if (node->retired.load(std::memory_order_acquire)
+                || node->task->getStatus() != Task::Status::Pending)
+                return;
+            if (!m_aborting.load(std::memory_order_acquire))
             {
-                sp->skip();
-                auto idIt = m_inDegree.find(cur);
-                if (idIt != m_inDegree.end() && idIt->second >= 0)
-                {
-                    idIt->second = -1;
-                    if (m_remaining > 0) --m_remaining;
-                    m_completedWeight += sp->getWeight();
-                }
-                emit taskFinished(QString::fromStdString(sp->getName()));
+                enqueueReadyLocked(node);
+                node = nullptr;
             }
-            auto depIt = m_dependents.find(cur);
-            if (depIt != m_dependents.end())
+            else
             {
-                for (Task* d : depIt->second)
-                    stack.push_back(d);
+                // Parked while the run was aborted but before the task was Pending
+                // again, so the abort did not see it.
+                node->task->cancel();
+                seal(node, batch);
+                retire(node, batch);
             }
         }
+        if (node)
+        {
+            emit taskFinished(QString::fromStdString(node->task->getName()));
+            commitRetired(batch);
+            return;
+        }
+        wakeWorkers(1);
     }
 
-    void TaskScheduler::onTaskCompleted(const std::shared_ptr<Task>& task)
+    bool TaskScheduler::canHandOff(RunNode* successor)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_successorHandoff.load(std::memory_order_acquire)
+            || t_workerScheduler != this
+            || m_paused.load(std::memory_order_acquire)
+            || isThrottled(t_workerIndex)
+            || successor->task->getAffinity() == Task::TaskAffinity::Gui)
+            return false;
+        // A plain FIFO run needs no lock; an ordered queue may hold a task that
+        // outranks the successor.
+        if (!m_readyQueue.isOrdered())
+            return true;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_readyQueue.outranksQueued(successor);
+    }
 
+    TaskScheduler::RunNode* TaskScheduler::onTaskCompleted(RunNode* node)
+    {
+        if (node->holdsResources)
+            releaseResources(node);
+        const std::shared_ptr<Task>& task = node->task;
         const Task::Status status = task->getStatus();
         const QString name = QString::fromStdString(task->getName());
 
-        auto idIt = m_inDegree.find(task.get());
-        const bool alreadyAccounted = (idIt != m_inDegree.end() && idIt->second < 0);
-        if (idIt != m_inDegree.end())
-            idIt->second = -1;
-
-        auto accountWeight = [&]()
-        {
-            if (!alreadyAccounted)
-                m_completedWeight += task->getWeight();
-        };
+        RetireBatch batch;
+        retire(node, batch);
+        // After sealing, `dependents` can no longer grow and is walked without a lock.
+        seal(node, batch);
 
+        RunNode* handoff = nullptr;
         if (status == Task::Status::Done)
         {
-            auto depIt = m_dependents.find(task.get());
-            if (depIt != m_dependents.end())
+            size_t unblocked = 0;
+            forEachDependent(node, [this, &unblocked, &handoff](RunNode* dep)
             {
-                for (Task* dep : depIt->second)
+                if (dep->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    return;
+                if (dep->retired.load(std::memory_order_acquire)
+                    || dep->task->getStatus() != Task::Status::Pending)
+                    return;
+                if (!handoff && canHandOff(dep))
                 {
-                    auto degIt = m_inDegree.find(dep);
-                    if (degIt == m_inDegree.end() || degIt->second < 0)
-                        continue;
-                    if (--degIt->second == 0)
-                    {
-                        auto alive = m_aliveByPtr.find(dep);
-                        if (alive != m_aliveByPtr.end()
-                            && alive->second->getStatus() == Task::Status::Pending)
-                        {
-                            m_readyQueue.push_back(alive->second);
-                        }
-                    }
+                    handoff = dep;
+                    return;
                 }
+                enqueueReady(dep);
+                ++unblocked;
+            });
+            if (handoff)
+            {
+                // Counted before this node leaves m_inFlight, so the run cannot
+                // look drained in between.
+                m_inFlight.fetch_add(1);
+                m_stats.handoffs.fetch_add(1, std::memory_order_relaxed);
             }
-            if (!alreadyAccounted && m_remaining > 0) --m_remaining;
-            accountWeight();
+            else if (unblocked > 0 && t_workerScheduler == this && !isThrottled(t_workerIndex))
+            {
+                // A worker of this pool (or the participating caller) returns to its
+                // loop right after this and takes one of the unblocked tasks itself.
+                --unblocked;
+            }
+            wakeWorkers(unblocked);
             emit taskFinished(name);
         }
         else if (status == Task::Status::Failed)
         {
-            if (!alreadyAccounted && m_remaining > 0) --m_remaining;
-            accountWeight();
             const QString err = task->getLastError();
             emit taskFailed(name, err);
             emit errorRaised(QStringLiteral("Task \"") + name + QStringLiteral("\" failed: ") + err);
 
             if (m_failurePolicy.load(std::memory_order_acquire) == FailurePolicy::FailFast)
             {
-                m_aborting = true;
-                for (const auto& t : m_allTasks)
+                size_t requeued;
                 {
-                    if (t->getStatus() == Task::Status::Pending)
-                        t->cancel();
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_aborting.store(true, std::memory_order_release);
+                    // m_nodes also holds the run-only fork-join children.
+                    for (RunNode& n : m_nodes)
+                    {
+                        if (n.task->getStatus() == Task::Status::Pending)
+                            n.task->cancel();
+                    }
+                    requeued = cancelPendingLocked(batch);
                 }
-                cancelPendingLocked();
+                wakeWorkers(requeued);
             }
             else
             {
-                skipDescendantsLocked(task.get());
+                skipDescendants(node, batch);
             }
         }
-        else if (status == Task::Status::Cancelled)
-        {
-            if (!alreadyAccounted && m_remaining > 0) --m_remaining;
-            accountWeight();
-            emit taskFinished(name);
-        }
-        else if (status == Task::Status::Skipped)
+        else if (status == Task::Status::Cancelled || status == Task::Status::Skipped)
         {
-            if (!alreadyAccounted && m_remaining > 0) --m_remaining;
-            accountWeight();
             emit taskFinished(name);
         }
+        for (const auto& wake : batch.wakes)
+            wake();
+
+        // Progress is derived from the atomics; no node is touched past this point.
+        const double completed = m_completedWeight.fetch_add(batch.weight) + batch.weight;
+        const size_t remaining = m_remaining.fetch_sub(batch.count) - batch.count;
+        const double weightSum = m_weightSum.load();
 
         // Clamp to exactly 1.0 when all tasks are done (not cancelled/aborted)
         // to avoid float-precision near-miss on the final emission
         float progF = 0.0f;
-        if (m_weightSum > 0.0)
-            progF = static_cast<float>(m_completedWeight / m_weightSum);
-        if (m_remaining == 0 && !m_aborting
+        if (weightSum > 0.0)
+            progF = static_cast<float>(completed / weightSum);
+        if (remaining == 0 && !m_aborting.load(std::memory_order_acquire)
             && !m_cancelRequested.load(std::memory_order_acquire))
             progF = 1.0f;
         if (progF > 1.0f) progF = 1.0f;
@@ -791,14 +2780,19 @@ namespace TaskGraph
         const int progInt = static_cast<int>(std::round(progF * 100.0f));
         m_progress.store(progInt, std::memory_order_release);
 
-        lock.unlock();
         emit progressUpdate(progInt);
         emit progressChangedF(progF);
-        m_cvTask.notify_all();
-        m_cvComplete.notify_all();
+        wakeJoiners();
+        finishInFlight();
+        return handoff;
     }
 
     bool TaskScheduler::addDynamicTask(const std::shared_ptr<Task>& child, Task* parent)
+    {
+        return insertDynamicTask(child, parent, false);
+    }
+
+    bool TaskScheduler::insertDynamicTask(const std::shared_ptr<Task>& child, Task* parent, bool runOnly)
     {
         if (!child || !parent)
             return false;
@@ -809,12 +2803,15 @@ namespace TaskGraph
         }
 
         std::unique_lock<std::mutex> lock(m_mutex);
-        if (m_aliveByPtr.find(parent) == m_aliveByPtr.end())
+        auto parentIt = m_nodeOf.find(parent);
+        if (parentIt == m_nodeOf.end())
         {
             Internal::TaskGraphLogger::logError("addDynamicTask: parent task not tracked");
             return false;
         }
-        if (m_aliveByPtr.find(child.get()) != m_aliveByPtr.end())
+        // Whatever a run-only task spawns ends with the run as well.
+        runOnly = runOnly || parentIt->second->runOnly;
+        if (m_nodeOf.find(child.get()) != m_nodeOf.end())
         {
             Internal::TaskGraphLogger::logError("addDynamicTask: child task already tracked");
             return false;
@@ -823,65 +2820,113 @@ namespace TaskGraph
         auto declaredDeps = child->getDependencies();
         for (const auto& d : declaredDeps)
         {
-            if (!d || m_aliveByPtr.find(d.get()) == m_aliveByPtr.end())
+            if (!d || m_nodeOf.find(d.get()) == m_nodeOf.end())
             {
                 Internal::TaskGraphLogger::logError("addDynamicTask: child has unresolved dependency");
                 return false;
             }
         }
 
-        m_allTasks.push_back(child);
-        m_aliveByPtr[child.get()] = child;
-
-        int pendingDeps = 0;
+        if (!runOnly)
+        {
+            m_allTasks.push_back(child);
+            // The child becomes part of the graph for later runs, which recompile.
+            m_plan.valid = false;
+        }
+        RunNode& node = m_nodes.emplace_back();
+        node.task = child;
+        node.index = m_nodes.size() - 1;
+        node.runOnly = runOnly;
+        if (m_schedulingPolicy.load(std::memory_order_acquire) == SchedulingPolicy::CriticalPath)
+            node.rank = taskCost(*child);
+        resolveResourcesLocked(node);
+        m_nodeOf[child.get()] = &node;
+
+        // The extra count keeps the child from becoming ready while edges are
+        // still being attached; it is released below.
+        node.pending.store(1);
+        bool blocked = false;
         for (const auto& d : declaredDeps)
         {
-            if (d->getStatus() != Task::Status::Done)
+            RunNode* depNode = m_nodeOf[d.get()];
+            std::lock_guard<std::mutex> edgeLock(depNode->edgeMutex);
+            if (!depNode->sealed)
+            {
+                node.pending.fetch_add(1);
+                depNode->dependents.push_back(&node);
+            }
+            else if (d->getStatus() != Task::Status::Done)
             {
-                ++pendingDeps;
-                m_dependents[d.get()].push_back(child.get());
+                blocked = true;
             }
         }
-        m_inDegree[child.get()] = pendingDeps;
 
-        ++m_totalTasks;
-        ++m_remaining;
-        m_weightSum += child->getWeight();
-
-        if (pendingDeps == 0)
-            m_readyQueue.push_back(child);
+        m_totalTasks.fetch_add(1);
+        m_weightSum.fetch_add(child->getWeight());
 
         const QString msg = QStringLiteral("Spawned dynamic task \"")
                           + QString::fromStdString(child->getName())
                           + QStringLiteral("\"");
+
+        if (blocked || m_aborting.load(std::memory_order_acquire))
+        {
+            // A dependency already failed or was skipped/cancelled: the child can
+            // never run. Account for it immediately instead of leaving it pending.
+            if (m_aborting.load(std::memory_order_acquire))
+                child->cancel();
+            else
+                child->skip();
+            RetireBatch batch;
+            seal(&node, batch);
+            node.retired.store(true);
+            m_completedWeight.fetch_add(child->getWeight());
+            lock.unlock();
+            for (const auto& wake : batch.wakes)
+                wake();
+            emit statusMessage(msg);
+            emit taskFinished(QString::fromStdString(child->getName()));
+            return true;
+        }
+
+        m_remaining.fetch_add(1);
+        const bool ready = node.pending.fetch_sub(1) == 1;
+        if (ready)
+            enqueueReadyLocked(&node);
         lock.unlock();
 
         emit statusMessage(msg);
-        m_cvTask.notify_all();
+        wakeWorkers(ready ? 1 : 0);
         return true;
     }
 
-    void TaskScheduler::armWatchdog(const std::shared_ptr<Task>& task)
+    Internal::TimerService::TimerId TaskScheduler::armWatchdog(const std::shared_ptr<Task>& task, RunNode* coroutine)
     {
         auto to = task->getTimeout();
         if (to.count() <= 0)
-            return;
-        // Detached per-task watchdog. Uses weak_ptr + timeout generation to
-        // no-op if the task completed early or was reset before firing.
+            return Internal::TimerService::invalidTimer;
+        // Disarmed as soon as the attempt returns. The weak_ptr + timeout generation
+        // check still covers a timer that fires while the attempt is finishing.
         std::weak_ptr<Task> weak = task;
         uint64_t gen = task->beginTimeoutWindow();
-        std::thread([weak, to, gen]()
+        uint64_t run = 0;
+        if (coroutine)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            run = m_runGeneration;
+        }
+        return m_timers.arm(to, [this, weak, gen, coroutine, run]()
         {
-            std::this_thread::sleep_for(to);
             if (auto sp = weak.lock())
             {
                 if (sp->currentTimeoutWindow() == gen
                     && sp->getStatus() == Task::Status::Running)
                 {
                     sp->signalTimeout();
+                    if (coroutine)
+                        wakeCoroutine(coroutine, 0, run);
                 }
             }
-        }).detach();
+        });
     }
 
     void TaskScheduler::resetTasks()
@@ -913,22 +2958,277 @@ namespace TaskGraph
         std::lock_guard<std::mutex> lock(m_mutex);
         m_allTasks.clear();
         m_taskGraph.clear();
-        m_inDegree.clear();
-        m_dependents.clear();
-        m_aliveByPtr.clear();
+        clearReadyQueuesLocked();
+        m_nodeOf.clear();
+        m_nodes.clear();
+        m_plan = ExecutionPlan();
+    }
+
+    void TaskScheduler::clearReadyQueuesLocked()
+    {
         m_readyQueue.clear();
+        m_resourceWaiters.clear();
+        for (const auto& q : m_workerQueues)
+        {
+            std::lock_guard<std::mutex> qLock(q->mutex);
+            q->tasks.clear();
+        }
+        m_queuedTasks.store(0);
+        m_urgentQueued.store(0);
     }
 
-    unsigned int TaskScheduler::getBusyThreadCount() const
+    void TaskScheduler::enqueueReady(RunNode* node)
     {
+        // On a worker of this scheduler the successor stays local (cache-hot);
+        // everything else (GUI thread, external spawns) goes to the injection queue.
+        // Prioritized tasks always go through the (ordered) injection queue.
+        if (m_stealingRun.load(std::memory_order_acquire)
+            && t_workerScheduler == this && t_workerIndex >= 0
+            && node->task->getPriority() == 0)
+        {
+            WorkerQueue* q = m_workerQueues[t_workerIndex].get();
+            std::lock_guard<std::mutex> qLock(q->mutex);
+            q->tasks.push_back(node);
+            m_queuedTasks.fetch_add(1);
+            return;
+        }
         std::lock_guard<std::mutex> lock(m_mutex);
-        return m_busyThreads;
+        enqueueReadyLocked(node);
     }
 
-    size_t TaskScheduler::getTotalTasks() const
+    void TaskScheduler::enqueueReadyLocked(RunNode* node)
+    {
+        m_readyQueue.push(node);
+        node->urgent = false;
+        if (m_stealingRun.load(std::memory_order_acquire) && node->task->getPriority() > 0)
+        {
+            node->urgent = true;
+            m_urgentQueued.fetch_add(1);
+        }
+        m_queuedTasks.fetch_add(1);
+    }
+
+    TaskScheduler::RunNode* TaskScheduler::popReadyLocked()
+    {
+        RunNode* node = m_readyQueue.pop();
+        if (!node)
+            return nullptr;
+        m_queuedTasks.fetch_sub(1);
+        if (node->urgent)
+            m_urgentQueued.fetch_sub(1);
+        m_inFlight.fetch_add(1);
+        return node;
+    }
+
+    TaskScheduler::RunNode* TaskScheduler::popUrgent()
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        return m_totalTasks;
+        if (m_urgentQueued.load() == 0)
+            return nullptr;
+        return popReadyLocked();
+    }
+
+    void TaskScheduler::wakeWorkers(size_t newTasks)
+    {
+        // Pairs with the increment of m_idleWorkers in taskThreadFunction: either
+        // the sleeping worker sees the new work in its predicate, or we see it idle.
+        // Taking the mutex orders the notify after the worker started waiting.
+        if (newTasks == 0)
+            return;
+        const bool callerIdle = m_callerIdle.load();
+        const unsigned int idle = m_idleWorkers.load();
+        const bool joiners = m_joinWaiters.load() > 0;
+        if (idle == 0 && !callerIdle && !joiners)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        // Joining tasks help out but are not counted against newTasks: they return
+        // to their own body as soon as their children are done.
+        if (joiners)
+            m_cvJoin.notify_all();
+        if (callerIdle)
+        {
+            m_cvComplete.notify_all();
+            m_stats.notifications.fetch_add(1, std::memory_order_relaxed);
+            if (--newTasks == 0 || idle == 0)
+                return;
+        }
+        // Every woken worker takes at most one task before it checks for more, so
+        // waking more workers than there are new tasks only causes spurious wakeups.
+        // A throttled worker would swallow a single notification: wake them all then.
+        if (newTasks >= idle || m_concurrencyLimit.load(std::memory_order_acquire) != SIZE_MAX)
+        {
+            m_cvTask.notify_all();
+            m_stats.notifications.fetch_add(idle, std::memory_order_relaxed);
+            return;
+        }
+        for (size_t i = 0; i < newTasks; ++i)
+            m_cvTask.notify_one();
+        m_stats.notifications.fetch_add(newTasks, std::memory_order_relaxed);
+    }
+
+    TaskScheduler::Stats TaskScheduler::getStats() const
+    {
+        Stats stats;
+        stats.tasksExecuted = m_stats.tasksExecuted.load(std::memory_order_relaxed);
+        stats.notifications = m_stats.notifications.load(std::memory_order_relaxed);
+        stats.parks = m_stats.parks.load(std::memory_order_relaxed);
+        stats.wakeups = m_stats.wakeups.load(std::memory_order_relaxed);
+        stats.spuriousWakeups = m_stats.spuriousWakeups.load(std::memory_order_relaxed);
+        stats.steals = m_stats.steals.load(std::memory_order_relaxed);
+        stats.spinHits = m_stats.spinHits.load(std::memory_order_relaxed);
+        stats.handoffs = m_stats.handoffs.load(std::memory_order_relaxed);
+        stats.retriesParked = m_stats.retriesParked.load(std::memory_order_relaxed);
+        stats.joinHelps = m_stats.joinHelps.load(std::memory_order_relaxed);
+        stats.loopHelps = m_stats.loopHelps.load(std::memory_order_relaxed);
+        stats.suspensions = m_stats.suspensions.load(std::memory_order_relaxed);
+        stats.yields = m_stats.yields.load(std::memory_order_relaxed);
+        stats.compensations = m_stats.compensations.load(std::memory_order_relaxed);
+        stats.resourceWaits = m_stats.resourceWaits.load(std::memory_order_relaxed);
+        stats.peakMemoryInUse = m_stats.peakMemoryInUse.load(std::memory_order_relaxed);
+        stats.concurrencyChanges = m_stats.concurrencyChanges.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void TaskScheduler::resetStats()
+    {
+        m_stats.tasksExecuted.store(0, std::memory_order_relaxed);
+        m_stats.notifications.store(0, std::memory_order_relaxed);
+        m_stats.parks.store(0, std::memory_order_relaxed);
+        m_stats.wakeups.store(0, std::memory_order_relaxed);
+        m_stats.spuriousWakeups.store(0, std::memory_order_relaxed);
+        m_stats.steals.store(0, std::memory_order_relaxed);
+        m_stats.spinHits.store(0, std::memory_order_relaxed);
+        m_stats.handoffs.store(0, std::memory_order_relaxed);
+        m_stats.retriesParked.store(0, std::memory_order_relaxed);
+        m_stats.joinHelps.store(0, std::memory_order_relaxed);
+        m_stats.loopHelps.store(0, std::memory_order_relaxed);
+        m_stats.suspensions.store(0, std::memory_order_relaxed);
+        m_stats.yields.store(0, std::memory_order_relaxed);
+        m_stats.compensations.store(0, std::memory_order_relaxed);
+        m_stats.resourceWaits.store(0, std::memory_order_relaxed);
+        m_stats.peakMemoryInUse.store(0, std::memory_order_relaxed);
+        m_stats.concurrencyChanges.store(0, std::memory_order_relaxed);
+    }
+
+    bool TaskScheduler::spinForWork(const std::atomic<bool>& localExit)
+    {
+        const IdlePolicy policy = m_idlePolicy.load(std::memory_order_acquire);
+        if (policy == IdlePolicy::Blocking)
+            return false;
+        // Typically the successor the worker just unblocked itself: no spinning involved.
+        if (m_queuedTasks.load(std::memory_order_acquire) > 0 || m_openLoops.load(std::memory_order_acquire) > 0)
+            return true;
+
+        // Polling is pointless (and would burn a core) without an active run; a
+        // paused run or a shrinking pool parks right away as well.
+        auto mustPark = [this, &localExit] {
+            return !m_isRunning.load(std::memory_order_acquire)
+                || m_paused.load(std::memory_order_acquire)
+                || localExit.load(std::memory_order_acquire);
+        };
+        auto workQueued = [this] {
+            if (m_queuedTasks.load(std::memory_order_acquire) == 0
+                && m_openLoops.load(std::memory_order_acquire) == 0)
+                return false;
+            m_stats.spinHits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        };
+
+        if (policy == IdlePolicy::BusyPoll)
+        {
+            for (uint32_t i = 1; ; ++i)
+            {
+                if (workQueued())
+                    return true;
+                if (mustPark())
+                    return false;
+                cpuRelax();
+                // Give way now and then in case the core is shared after all.
+                if ((i & 1023) == 0)
+                    std::this_thread::yield();
+            }
+        }
+
+        // SpinThenPark: pause-spin for the configured duration (the clock is read
+        // every 64 rounds only), then a few yields, then park.
+        const auto spinLimit = std::chrono::microseconds(m_idleSpinUs.load(std::memory_order_acquire));
+        const auto spinStart = std::chrono::steady_clock::now();
+        for (uint32_t i = 1; ; ++i)
+        {
+            if (workQueued())
+                return true;
+            if (mustPark())
+                return false;
+            if ((i & 63) == 0 && std::chrono::steady_clock::now() - spinStart >= spinLimit)
+                break;
+            cpuRelax();
+        }
+        for (int i = 0; i < 8; ++i)
+        {
+            std::this_thread::yield();
+            if (workQueued())
+                return true;
+            if (mustPark())
+                return false;
+        }
+        return false;
+    }
+
+    TaskScheduler::RunNode* TaskScheduler::popLocalOrSteal(WorkerQueue* own, uint32_t& rng)
+    {
+        if (m_queuedTasks.load(std::memory_order_acquire) == 0)
+            return nullptr;
+
+        // Own work first, newest first (LIFO keeps the producer's data hot).
+        if (own)
+        {
+            std::lock_guard<std::mutex> qLock(own->mutex);
+            if (!own->tasks.empty())
+            {
+                RunNode* n = own->tasks.back();
+                own->tasks.pop_back();
+                m_queuedTasks.fetch_sub(1);
+                m_inFlight.fetch_add(1);
+                return n;
+            }
+        }
+
+        // Steal the oldest task of a random victim, probing every victim once.
+        StealReaderScope reading(m_stealReaders);
+        const StealTargets* targets = m_stealTargets.load();
+        if (!targets || targets->queues.empty())
+            return nullptr;
+        const size_t count = targets->queues.size();
+        const size_t start = nextRandom(rng) % count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            WorkerQueue* victim = targets->queues[(start + i) % count];
+            if (victim == own)
+                continue;
+            std::lock_guard<std::mutex> qLock(victim->mutex);
+            if (!victim->tasks.empty())
+            {
+                RunNode* n = victim->tasks.front();
+                victim->tasks.pop_front();
+                m_queuedTasks.fetch_sub(1);
+                m_inFlight.fetch_add(1);
+                m_stats.steals.fetch_add(1, std::memory_order_relaxed);
+                return n;
+            }
+        }
+        return nullptr;
+    }
+
+    unsigned int TaskScheduler::getBusyThreadCount() const
+    {
+        return m_busyThreads.load(std::memory_order_acquire);
+    }
+
+    size_t TaskScheduler::getTotalTasks() const
+    {
+        return m_totalTasks.load(std::memory_order_acquire);
     }
 
     std::vector<TaskList> TaskScheduler::getTaskGraph() const
@@ -950,87 +3250,298 @@ namespace TaskGraph
         return m_scheduler->addDynamicTask(child, m_task);
     }
 
-    void TaskScheduler::taskThreadFunction(TaskScheduler* obj, int threadIndex, std::shared_ptr<std::atomic<bool>> localExit)
+    bool TaskContext::spawnAndWait(const std::shared_ptr<Task>& child)
+    {
+        return spawnAndWait(std::vector<std::shared_ptr<Task>>{ child });
+    }
+
+    bool TaskContext::spawnAndWait(const std::vector<std::shared_ptr<Task>>& children)
+    {
+        if (!m_scheduler || !m_task)
+            return false;
+        return m_scheduler->joinTasks(children, m_task, true);
+    }
+
+    bool TaskContext::join(const std::vector<std::shared_ptr<Task>>& tasks)
+    {
+        if (!m_scheduler || !m_task)
+            return false;
+        return m_scheduler->joinTasks(tasks, m_task, false);
+    }
+
+    bool TaskContext::parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn)
+    {
+        if (end <= begin)
+            return true;
+        return forEachChunk(begin, end, resolveGrain(end - begin, grain),
+                            [&fn](size_t, size_t b, size_t e) { fn(b, e); });
+    }
+
+    size_t TaskContext::resolveGrain(size_t count, size_t grain) const
+    {
+        if (m_scheduler)
+            return m_scheduler->parallelGrain(count, grain);
+        return grain > 0 ? grain : std::max<size_t>(1, count);
+    }
+
+    bool TaskContext::forEachChunk(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t, size_t)>& fn)
+    {
+        if (m_scheduler)
+            return m_scheduler->runParallelLoop(*this, begin, end, grain, fn);
+        // A context without scheduler runs the chunks in place.
+        grain = std::max<size_t>(1, grain);
+        size_t chunk = 0;
+        for (size_t b = begin; b < end; b += std::min(grain, end - b), ++chunk)
+        {
+            if (isCancelRequested())
+                return false;
+            fn(chunk, b, b + std::min(grain, end - b));
+        }
+        return true;
+    }
+
+    bool TaskContext::isSettled(const Task& task) const
+    {
+        if (!m_scheduler || !m_task)
+            return true;
+        return m_scheduler->isTaskSettled(m_task, task);
+    }
+
+    void TaskContext::suspendUntilSettled(const Task& task)
+    {
+        if (!m_scheduler || !m_task)
+            throw std::runtime_error("Coroutine body suspended outside a TaskScheduler");
+        m_scheduler->suspendUntilSettled(m_task, task);
+    }
+
+    void TaskContext::checkAwaited(const Task& task) const
+    {
+        // Woken by a cancel, the awaited task may still be running.
+        throwIfCancelled();
+        if (task.getStatus() != Task::Status::Done)
+            throw std::runtime_error("Awaited task \"" + task.getName() + "\" did not complete");
+    }
+
+    TaskContext::SleepAwaiter TaskContext::sleepFor(std::chrono::milliseconds delay)
+    {
+        return SleepAwaiter(*this, delay);
+    }
+
+    void TaskContext::suspendFor(std::chrono::milliseconds delay)
+    {
+        if (!m_scheduler || !m_task)
+            throw std::runtime_error("Coroutine body suspended outside a TaskScheduler");
+        m_scheduler->suspendFor(m_task, delay);
+    }
+
+    void TaskContext::throwIfCancelled() const
+    {
+        if (isCancelRequested())
+            throw CancelledError();
+    }
+
+    TaskContext::GuiAwaiter TaskContext::askGuiAsync(const QVariant& payload)
+    {
+        return GuiAwaiter(*this, payload);
+    }
+
+    int TaskContext::suspendForGui(const QVariant& payload)
+    {
+        if (!m_scheduler || !m_task)
+            throw std::runtime_error("Coroutine body suspended outside a TaskScheduler");
+        return m_scheduler->suspendForGui(m_task, payload);
+    }
+
+    QVariant TaskContext::takeGuiResponse(int requestId)
+    {
+        return m_scheduler ? m_scheduler->takeGuiResponse(requestId) : QVariant();
+    }
+
+    TaskContext::FileIoAwaiter TaskContext::fileIo(const FileIoRequest& request)
+    {
+        return FileIoAwaiter(*this, request, true);
+    }
+
+    TaskContext::FileIoAwaiter TaskContext::readAt(int fd, void* buffer, size_t size, uint64_t offset)
+    {
+        return fileIo(FileIoRequest::read(fd, buffer, size, offset));
+    }
+
+    TaskContext::FileIoAwaiter TaskContext::writeAt(int fd, const void* buffer, size_t size, uint64_t offset)
+    {
+        return fileIo(FileIoRequest::write(fd, buffer, size, offset));
+    }
+
+    TaskContext::FileIoAwaiter TaskContext::syncFile(int fd)
     {
-        TG_SCHEDULER_PROFILING_THREAD(std::string("TaskThread[" + std::to_string(threadIndex) + "]").c_str());
+        return fileIo(FileIoRequest::sync(fd));
+    }
+
+    void TaskContext::suspendForFileIo(const FileIoRequest& request, std::shared_ptr<std::atomic<long>>& result)
+    {
+        if (!m_scheduler || !m_task)
+            throw std::runtime_error("Coroutine body suspended outside a TaskScheduler");
+        m_scheduler->suspendForFileIo(m_task, request, result);
+    }
+
+    long TaskContext::endFileIo(const std::shared_ptr<std::atomic<long>>& result, bool throwOnError)
+    {
+        // The operation has completed: the buffer is free again.
+        throwIfCancelled();
+        const long bytes = result->load(std::memory_order_acquire);
+        if (bytes < 0 && throwOnError)
+            throw std::runtime_error("File I/O failed: " + std::string(std::strerror(static_cast<int>(-bytes))));
+        return bytes;
+    }
+
+    TaskContext::BlockingScope::BlockingScope(TaskScheduler* scheduler)
+        : m_scheduler(scheduler && scheduler->beginBlocking() ? scheduler : nullptr)
+    {}
+
+    TaskContext::BlockingScope::~BlockingScope()
+    {
+        if (m_scheduler)
+            m_scheduler->endBlocking();
+    }
+
+    TaskContext::BlockingScope TaskContext::blockingScope()
+    {
+        return BlockingScope(m_scheduler);
+    }
+
+    bool TaskContext::shouldYield() const
+    {
+        if (!m_scheduler || !m_task)
+            return false;
+        return m_scheduler->shouldYield(m_task, m_sliceStart);
+    }
+
+    TaskContext::YieldAwaiter TaskContext::yield()
+    {
+        return YieldAwaiter(*this, false);
+    }
+
+    void TaskContext::suspendForYield()
+    {
+        if (!m_scheduler || !m_task)
+            throw std::runtime_error("Coroutine body suspended outside a TaskScheduler");
+        m_scheduler->suspendForYield(m_task);
+    }
+
+    TaskContext::FdAwaiter TaskContext::waitForFd(int fd, int events)
+    {
+        return FdAwaiter(*this, fd, events);
+    }
+
+    uint64_t TaskContext::suspendForFd(int fd, int events, std::shared_ptr<std::atomic<int>>& ready)
+    {
+        if (!m_scheduler || !m_task)
+            throw std::runtime_error("Coroutine body suspended outside a TaskScheduler");
+        return m_scheduler->suspendForFd(m_task, fd, events, ready);
+    }
+
+    int TaskContext::endFdWait(uint64_t watch, const std::shared_ptr<std::atomic<int>>& ready)
+    {
+        // Woken by cancel or timeout: the watch may still be registered.
+        if (m_scheduler)
+            m_scheduler->endFdWait(watch);
+        throwIfCancelled();
+        const int events = ready ? ready->load(std::memory_order_acquire) : -1;
+        if (events < 0)
+            throw std::runtime_error("waitForFd: the fd cannot be watched (regular file, closed, or no reactor on this platform)");
+        return events;
+    }
+
+    void TaskScheduler::taskThreadFunction(TaskScheduler* obj, int threadIndex, WorkerQueue* ownQueue, std::shared_ptr<std::atomic<bool>> localExit)
+    {
+        TG_SCHEDULER_PROFILING_THREAD(threadIndex == compensatorIndex ? "CompensatingThread"
+                                      : std::string("TaskThread[" + std::to_string(threadIndex) + "]").c_str());
         STACK_WATCHER_FUNC;
-        (void)threadIndex;
+        t_workerScheduler = obj;
+        t_workerIndex = threadIndex;
+        uint32_t rng = 0x9E3779B9u ^ (static_cast<uint32_t>(threadIndex + 1) * 0x85EBCA6Bu);
+        // Set when woken; a worker that parks again while still set was woken in vain.
+        bool woken = false;
 
         while (true)
         {
-            std::shared_ptr<Task> currentTask;
+            RunNode* current = nullptr;
+            // Above the adaptive concurrency limit a worker only parks.
+            const bool throttled = obj->isThrottled(threadIndex);
+            if (obj->m_stealingRun.load(std::memory_order_acquire)
+                && !obj->m_paused.load(std::memory_order_acquire)
+                && !throttled
+                && !localExit->load(std::memory_order_acquire))
+            {
+                if (obj->m_urgentQueued.load() > 0)
+                    current = obj->popUrgent();
+                if (!current)
+                    current = obj->popLocalOrSteal(ownQueue, rng);
+            }
+
+            if (!current)
             {
+                // Chunks of a running parallelFor come after queued graph nodes.
+                if (!throttled
+                    && obj->m_openLoops.load(std::memory_order_acquire) > 0
+                    && obj->m_queuedTasks.load(std::memory_order_acquire) == 0
+                    && !obj->m_paused.load(std::memory_order_acquire)
+                    && obj->helpParallelLoop())
+                    continue;
+
+                // In WorkStealing mode spun-for work may sit in a deque: take the
+                // lock-free path again. Otherwise the mutex path below picks it up
+                // without parking.
+                if (!throttled && obj->spinForWork(*localExit) && obj->m_stealingRun.load(std::memory_order_acquire))
+                    continue;
+
                 TG_SCHEDULER_PROFILING_BLOCK("WaitForTask", TG_COLOR_STAGE_2);
                 std::unique_lock<std::mutex> lock(obj->m_mutex);
-                obj->m_cvTask.wait(lock, [obj, &localExit] {
+                obj->m_idleWorkers.fetch_add(1);
+                auto canProceed = [obj, &localExit, threadIndex] {
                     return obj->m_stopThreads
                         || localExit->load(std::memory_order_acquire)
                         || (!obj->m_paused.load(std::memory_order_acquire)
-                            && !obj->m_readyQueue.empty());
-                });
+                            && !obj->isThrottled(threadIndex)
+                            && (!obj->m_readyQueue.empty() || obj->m_queuedTasks.load() > 0
+                                || obj->m_openLoops.load() > 0));
+                };
+                while (!canProceed())
+                {
+                    if (woken)
+                        obj->m_stats.spuriousWakeups.fetch_add(1, std::memory_order_relaxed);
+                    obj->m_stats.parks.fetch_add(1, std::memory_order_relaxed);
+                    obj->m_cvTask.wait(lock);
+                    obj->m_stats.wakeups.fetch_add(1, std::memory_order_relaxed);
+                    woken = true;
+                }
+                obj->m_idleWorkers.fetch_sub(1);
                 if (localExit->load(std::memory_order_acquire))
                     break;
-                if (obj->m_stopThreads && obj->m_readyQueue.empty())
+                if (obj->m_stopThreads && obj->m_readyQueue.empty() && obj->m_queuedTasks.load() == 0)
                     break;
-                if (obj->m_paused.load(std::memory_order_acquire))
+                if (obj->m_paused.load(std::memory_order_acquire) || obj->isThrottled(threadIndex))
                     continue;
-                if (obj->m_readyQueue.empty())
+                // In WorkStealing mode m_readyQueue only holds injected work (run start
+                // from the GUI, external spawns); deque work is stolen next round.
+                current = obj->popReadyLocked();
+                if (!current)
                     continue;
-                currentTask = obj->m_readyQueue.front();
-                obj->m_readyQueue.pop_front();
-                ++obj->m_busyThreads;
-            }
-
-            if (currentTask->getAffinity() == Task::TaskAffinity::Gui)
-            {
-                std::shared_ptr<Task> t = currentTask;
-                TaskScheduler* self = obj;
-                QMetaObject::invokeMethod(t.get(), [t, self]() {
-                    std::unique_ptr<TaskContext> ctx = self->m_contextFactory
-                        ? self->m_contextFactory(t.get(), self)
-                        : std::make_unique<TaskContext>(t.get(), self);
-                    self->armWatchdog(t);
-                    t->runTask(ctx.get());
-                    self->onTaskCompleted(t);
-                }, Qt::QueuedConnection);
-            }
-            else
-            {
-                emit obj->taskStarted(QString::fromStdString(currentTask->getName()));
-                TG_GENERAL_PROFILING_NONSCOPED_BLOCK("Process task", TG_COLOR_STAGE_2);
-
-                int attempts = 0;
-                // One context per task-run, reused across all retry attempts.
-                std::unique_ptr<TaskContext> ctx = obj->m_contextFactory
-                    ? obj->m_contextFactory(currentTask.get(), obj)
-                    : std::make_unique<TaskContext>(currentTask.get(), obj);
-                while (true)
-                {
-                    obj->armWatchdog(currentTask);
-                    currentTask->runTask(ctx.get());
-                    if (currentTask->getStatus() == Task::Status::Failed
-                        && attempts < currentTask->getMaxRetries()
-                        && !obj->m_cancelRequested.load(std::memory_order_acquire))
-                    {
-                        ++attempts;
-                        currentTask->logger().logWarning("Task retry attempt " + std::to_string(attempts));
-                        auto backoff = currentTask->getRetryBackoff();
-                        if (backoff.count() > 0)
-                            std::this_thread::sleep_for(backoff);
-                        currentTask->prepareRetry();
-                        continue;
-                    }
-                    break;
-                }
-
-                TG_GENERAL_PROFILING_END_BLOCK;
-                obj->onTaskCompleted(currentTask);
             }
 
+            woken = false;
+            obj->m_stats.tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+            obj->m_busyThreads.fetch_add(1, std::memory_order_acq_rel);
+            // Successors handed off by a completing task run right here, cache-hot.
+            while (current)
             {
-                std::unique_lock<std::mutex> lock(obj->m_mutex);
-                --obj->m_busyThreads;
+                current = obj->executeNode(current);
+                if (current)
+                    obj->m_stats.tasksExecuted.fetch_add(1, std::memory_order_relaxed);
             }
+            obj->m_busyThreads.fetch_sub(1, std::memory_order_acq_rel);
         }
+        t_workerScheduler = nullptr;
+        t_workerIndex = -1;
     }
 }
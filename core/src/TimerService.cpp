@@ -0,0 +1,177 @@
+#include "TimerService.h"
+#include <algorithm>
+
+namespace TaskGraph
+{
+    namespace Internal
+    {
+        namespace
+        {
+            struct LaterDeadline
+            {
+                template <typename Entry>
+                bool operator()(const Entry& a, const Entry& b) const { return a.deadline > b.deadline; }
+            };
+        }
+
+        TimerService::TimerService()
+        {
+        }
+
+        TimerService::~TimerService()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_all();
+            if (m_thread && m_thread->joinable())
+                m_thread->join();
+        }
+
+        TimerService::TimerId TimerService::makeId(uint32_t slot, uint32_t generation)
+        {
+            // Generations start at 1, so no id equals invalidTimer.
+            return (static_cast<uint64_t>(slot) << 32) | generation;
+        }
+
+        bool TimerService::isLive(const HeapEntry& entry) const
+        {
+            const Slot& s = m_slots[entry.slot];
+            return s.armed && s.generation == entry.generation;
+        }
+
+        TimerService::TimerId TimerService::arm(Clock::duration delay, std::function<void()> callback)
+        {
+            if (!callback)
+                return invalidTimer;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop)
+                return invalidTimer;
+
+            uint32_t slot;
+            if (!m_freeSlots.empty())
+            {
+                slot = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+            else
+            {
+                slot = static_cast<uint32_t>(m_slots.size());
+                m_slots.emplace_back();
+            }
+
+            Slot& s = m_slots[slot];
+            s.callback = std::move(callback);
+            s.armed = true;
+            ++m_pending;
+
+            const Clock::time_point deadline = Clock::now() + delay;
+            const bool earliest = m_heap.empty() || deadline < m_heap.front().deadline;
+            m_heap.push_back({ deadline, slot, s.generation });
+            std::push_heap(m_heap.begin(), m_heap.end(), LaterDeadline());
+
+            if (!m_thread)
+                m_thread = std::make_unique<std::thread>(&TimerService::threadFunction, this);
+            else if (earliest)
+                m_cv.notify_one();
+            return makeId(slot, s.generation);
+        }
+
+        bool TimerService::disarm(TimerId id)
+        {
+            if (id == invalidTimer)
+                return false;
+            const uint32_t slot = static_cast<uint32_t>(id >> 32);
+            const uint32_t generation = static_cast<uint32_t>(id);
+
+            std::function<void()> released;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (slot >= m_slots.size())
+                    return false;
+                Slot& s = m_slots[slot];
+                if (!s.armed || s.generation != generation)
+                    return false;
+                // Move the callback out so whatever it captured is destroyed outside the lock.
+                released = std::move(s.callback);
+                releaseSlotLocked(slot);
+                --m_pending;
+                if (m_heap.size() > 64 && m_heap.size() > 2 * m_pending)
+                    compactLocked();
+            }
+            return true;
+        }
+
+        size_t TimerService::getPendingCount() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_pending;
+        }
+
+        bool TimerService::isThreadRunning() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_thread != nullptr;
+        }
+
+        void TimerService::releaseSlotLocked(uint32_t slot)
+        {
+            Slot& s = m_slots[slot];
+            s.callback = nullptr;
+            s.armed = false;
+            if (++s.generation == 0)
+                s.generation = 1;
+            m_freeSlots.push_back(slot);
+        }
+
+        void TimerService::compactLocked()
+        {
+            m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(),
+                                        [this](const HeapEntry& e) { return !isLive(e); }),
+                         m_heap.end());
+            std::make_heap(m_heap.begin(), m_heap.end(), LaterDeadline());
+        }
+
+        void TimerService::threadFunction()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_stop)
+            {
+                // Drop cancelled entries from the top before deciding how long to sleep.
+                while (!m_heap.empty() && !isLive(m_heap.front()))
+                {
+                    std::pop_heap(m_heap.begin(), m_heap.end(), LaterDeadline());
+                    m_heap.pop_back();
+                }
+
+                if (m_heap.empty())
+                {
+                    m_cv.wait(lock);
+                    continue;
+                }
+
+                const Clock::time_point deadline = m_heap.front().deadline;
+                if (Clock::now() < deadline)
+                {
+                    m_cv.wait_until(lock, deadline);
+                    continue;
+                }
+
+                const uint32_t slot = m_heap.front().slot;
+                std::pop_heap(m_heap.begin(), m_heap.end(), LaterDeadline());
+                m_heap.pop_back();
+
+                std::function<void()> callback = std::move(m_slots[slot].callback);
+                releaseSlotLocked(slot);
+                --m_pending;
+
+                lock.unlock();
+                callback();
+                callback = nullptr;
+                lock.lock();
+            }
+        }
+    }
+}
@@ -83,7 +83,19 @@ namespace Gui
     {
         unsigned int busy = m_scheduler->getBusyThreadCount();
         unsigned int total = m_scheduler->getThreadCount();
-        m_threadLabel->setText(QString("Threads: %1/%2").arg(busy).arg(total));
+        unsigned int blocked = m_scheduler->getBlockedThreadCount();
+        unsigned int limit = m_scheduler->getConcurrencyLimit();
+        QString text = QString("Threads: %1/%2").arg(busy).arg(total);
+        if (limit < total)
+            text += QString(", limit %1").arg(limit);
+        if (blocked > 0)
+            text += QString(", %1 blocked").arg(blocked);
+        m_threadLabel->setText(text);
+
+        DefaultThreadCount sizing;
+        sizing.count = total;
+        sizing.source = m_scheduler->getThreadCountSource();
+        m_threadLabel->setToolTip(QString("%1 worker threads, sized by: %2").arg(total).arg(sizing.sourceName()));
     }
 }
 }
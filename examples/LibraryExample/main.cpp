@@ -279,8 +279,8 @@ int main(int argc, char* argv[])
 
 	Log::UI::NativeConsoleView consoleView;
 
-	unsigned int hwThreads = std::thread::hardware_concurrency();
-	TaskGraph::TaskScheduler scheduler(hwThreads > 0 ? hwThreads : 8);
+	// Sized by the CPUs this process may use (affinity mask, container CPU quota).
+	TaskGraph::TaskScheduler scheduler;
 
 	// Large multi-layer graph (~36 tasks across 8 layers) to stress layout and
 	// skip-layer edge routing. Every non-root task takes one adjacent (previous
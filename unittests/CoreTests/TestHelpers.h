@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Helpers shared by the test classes in tests/.
+namespace TestHelpers
+{
+    // Polls `pred` until it holds or `limit` has passed; returns its final value.
+    template <class Pred>
+    bool waitFor(Pred pred, std::chrono::milliseconds limit)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + limit;
+        while (!pred() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return pred();
+    }
+
+    // Tracks how many bodies run at once.
+    struct Concurrency
+    {
+        std::atomic<int> now{0};
+        std::atomic<int> max{0};
+        void enter()
+        {
+            const int n = ++now;
+            int seen = max.load();
+            while (n > seen && !max.compare_exchange_weak(seen, n)) {}
+        }
+        void leave() { --now; }
+    };
+}
@@ -18,5 +18,13 @@ int main(int argc, char* argv[])
 	UnitTest::Test::runAllTests(results);
 	UnitTest::Test::printResults(results);
 
-	return results.getSuccess();
+	// Once more with work stealing as the default, so every test that does not
+	// pick a mode itself also covers the per-worker deques.
+	TaskGraph::TaskScheduler::setDefaultExecutionMode(TaskGraph::TaskScheduler::ExecutionMode::WorkStealing);
+	std::cout << "Running "<< UnitTest::Test::getTests().size() << " tests in WorkStealing mode...\n";
+	UnitTest::Test::TestResults stealingResults;
+	UnitTest::Test::runAllTests(stealingResults);
+	UnitTest::Test::printResults(stealingResults);
+
+	return results.getSuccess() && stealingResults.getSuccess();
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "test.h"
+#include "TestHelpers.h"
 #include "tests/TST_LinearChain.h"
 #include "tests/TST_Diamond.h"
 #include "tests/TST_CycleRejected.h"
@@ -29,3 +30,28 @@
 #include "tests/TST_ExternalLogger.h"
 #include "tests/TST_SchedulerLogger.h"
 #include "tests/TST_TaskDescription.h"
+#include "tests/TST_WorkStealing.h"
+#include "tests/TST_AtomicCompletion.h"
+#include "tests/TST_ExecutionPlan.h"
+#include "tests/TST_Layering.h"
+#include "tests/TST_TimerService.h"
+#include "tests/TST_CriticalPath.h"
+#include "tests/TST_Priority.h"
+#include "tests/TST_Wakeups.h"
+#include "tests/TST_IdlePolicy.h"
+#include "tests/TST_SuccessorHandoff.h"
+#include "tests/TST_CallerParticipation.h"
+#include "tests/TST_RetryBackoff.h"
+#include "tests/TST_ForkJoin.h"
+#include "tests/TST_ParallelFor.h"
+#include "tests/TST_Coroutines.h"
+#include "tests/TST_AskGuiThen.h"
+#include "tests/TST_IoReactor.h"
+#include "tests/TST_ProcessTask.h"
+#include "tests/TST_FileIo.h"
+#include "tests/TST_Yield.h"
+#include "tests/TST_BlockingScope.h"
+#include "tests/TST_ResourcePools.h"
+#include "tests/TST_MemoryBudget.h"
+#include "tests/TST_AdaptiveConcurrency.h"
+#include "tests/TST_DefaultThreadCount.h"
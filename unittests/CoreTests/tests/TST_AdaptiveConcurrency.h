@@ -0,0 +1,248 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include "PressureMonitor.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_AdaptiveConcurrency : public UnitTest::Test
+{
+    TEST_CLASS(TST_AdaptiveConcurrency)
+public:
+    TST_AdaptiveConcurrency()
+        : Test("TST_AdaptiveConcurrency")
+    {
+        ADD_TEST(TST_AdaptiveConcurrency::highPressureLowersLimit);
+        ADD_TEST(TST_AdaptiveConcurrency::lowPressureRaisesLimit);
+        ADD_TEST(TST_AdaptiveConcurrency::hysteresisKeepsLimit);
+        ADD_TEST(TST_AdaptiveConcurrency::minThreadsIsFloor);
+        ADD_TEST(TST_AdaptiveConcurrency::pressureMonitorSamples);
+        ADD_TEST(TST_AdaptiveConcurrency::settingsRejectedWhileRunning);
+    }
+
+private:
+    static TaskGraph::TaskScheduler::AdaptiveConcurrency fastSettings()
+    {
+        TaskGraph::TaskScheduler::AdaptiveConcurrency settings;
+        settings.enabled = true;
+        settings.interval = std::chrono::milliseconds(2);
+        return settings;
+    }
+
+    // A probe reporting `cpu` as the CPU pressure and counting its calls.
+    static TaskGraph::TaskScheduler::PressureProbe fixedProbe(std::atomic<double>& cpu, std::atomic<int>& calls)
+    {
+        return [&cpu, &calls] {
+            ++calls;
+            TaskGraph::PressureSample sample;
+            sample.valid = true;
+            sample.cpu = cpu.load();
+            return sample;
+        };
+    }
+
+    TEST_FUNCTION(highPressureLowersLimit)
+    {
+        TEST_START;
+        std::atomic<double> cpu{0.9};
+        std::atomic<int> calls{0};
+        std::atomic<bool> throttled{false};
+        TestHelpers::Concurrency after;
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.setAdaptiveConcurrency(fastSettings()));
+        TEST_ASSERT(scheduler.setPressureProbe(fixedProbe(cpu, calls)));
+        TEST_ASSERT(scheduler.getConcurrencyLimit() == scheduler.getThreadCount());
+
+        // 4 -> 3 -> 2 -> 1 while the gate runs; its dependents then run one at a time.
+        auto gate = std::make_shared<TaskGraph::Task>("Gate");
+        gate->setWorkFunction([&] {
+            throttled = TestHelpers::waitFor([&] { return scheduler.getConcurrencyLimit() == 1u; }, std::chrono::seconds(2));
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+        TEST_ASSERT(scheduler.addTask(gate));
+        std::vector<std::shared_ptr<TaskGraph::Task>> tasks;
+        for (int i = 0; i < 8; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("After" + std::to_string(i));
+            t->setWorkFunction([&after] {
+                after.enter();
+                std::this_thread::sleep_for(std::chrono::milliseconds(3));
+                after.leave();
+            });
+            t->addDependency(gate);
+            tasks.push_back(t);
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        scheduler.runTasks();
+
+        TEST_ASSERT(throttled.load());
+        for (const auto& t : tasks)
+            TEST_ASSERT(t->isDone());
+        TEST_ASSERT(after.max.load() == 1);
+        TEST_ASSERT(scheduler.getStats().concurrencyChanges == 3u);
+        TEST_ASSERT(scheduler.getLastPressure().valid);
+        TEST_ASSERT(scheduler.getLastPressure().cpu == 0.9);
+        // The limit carries over; reconfiguring starts with all workers again.
+        TEST_ASSERT(scheduler.getConcurrencyLimit() == 1u);
+        TEST_ASSERT(scheduler.setAdaptiveConcurrency(TaskGraph::TaskScheduler::AdaptiveConcurrency()));
+        TEST_ASSERT(scheduler.getConcurrencyLimit() == 4u);
+    }
+
+    TEST_FUNCTION(lowPressureRaisesLimit)
+    {
+        TEST_START;
+        constexpr int count = 4;
+        std::atomic<double> cpu{0.9};
+        std::atomic<int> calls{0};
+        std::atomic<bool> lowered{false};
+        std::atomic<bool> raised{false};
+        std::atomic<int> arrived{0};
+        std::atomic<int> met{0};
+        TaskGraph::TaskScheduler scheduler(count);
+        TEST_ASSERT(scheduler.setAdaptiveConcurrency(fastSettings()));
+        TEST_ASSERT(scheduler.setPressureProbe(fixedProbe(cpu, calls)));
+
+        auto gate = std::make_shared<TaskGraph::Task>("Gate");
+        gate->setWorkFunction([&] {
+            lowered = TestHelpers::waitFor([&] { return scheduler.getConcurrencyLimit() == 1u; }, std::chrono::seconds(2));
+            cpu = 0.0;
+            raised = TestHelpers::waitFor([&] { return scheduler.getConcurrencyLimit() == unsigned(count); }, std::chrono::seconds(2));
+        });
+        TEST_ASSERT(scheduler.addTask(gate));
+        // Only finish once all four run at the same time: every worker picks up work again.
+        for (int i = 0; i < count; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Barrier" + std::to_string(i));
+            t->setWorkFunction([&] {
+                ++arrived;
+                if (TestHelpers::waitFor([&] { return arrived.load() == count; }, std::chrono::seconds(2)))
+                    ++met;
+            });
+            t->addDependency(gate);
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        scheduler.runTasks();
+
+        TEST_ASSERT(lowered.load());
+        TEST_ASSERT(raised.load());
+        TEST_ASSERT(met.load() == count);
+        TEST_ASSERT(scheduler.getStats().concurrencyChanges == 6u);
+    }
+
+    TEST_FUNCTION(hysteresisKeepsLimit)
+    {
+        TEST_START;
+        // Alternating samples never build a streak; a sample inside the band resets it.
+        std::atomic<int> calls{0};
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.setAdaptiveConcurrency(fastSettings()));
+        TEST_ASSERT(scheduler.setPressureProbe([&calls] {
+            const int n = calls++;
+            TaskGraph::PressureSample sample;
+            sample.valid = true;
+            static const double pattern[] = { 0.9, 0.1, 0.0, 0.1 };
+            sample.io = pattern[n % 4];
+            return sample;
+        }));
+        auto t = std::make_shared<TaskGraph::Task>("Observe");
+        t->setWorkFunction([&] { TestHelpers::waitFor([&] { return calls.load() >= 20; }, std::chrono::seconds(2)); });
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(calls.load() >= 20);
+        TEST_ASSERT(scheduler.getStats().concurrencyChanges == 0u);
+        TEST_ASSERT(scheduler.getConcurrencyLimit() == 4u);
+    }
+
+    TEST_FUNCTION(minThreadsIsFloor)
+    {
+        TEST_START;
+        std::atomic<double> memory{1.0};
+        std::atomic<int> calls{0};
+        TaskGraph::TaskScheduler scheduler(8);
+        auto settings = fastSettings();
+        settings.minThreads = 3;
+        TEST_ASSERT(scheduler.setAdaptiveConcurrency(settings));
+        TEST_ASSERT(scheduler.setPressureProbe([&] {
+            ++calls;
+            TaskGraph::PressureSample sample;
+            sample.valid = true;
+            sample.memory = memory.load();
+            return sample;
+        }));
+        std::atomic<unsigned int> limitSeen{0};
+        auto t = std::make_shared<TaskGraph::Task>("Observe");
+        t->setWorkFunction([&] {
+            // 8 -> 6 -> 5 -> 4 -> 3, then many more samples at the floor.
+            TestHelpers::waitFor([&] { return calls.load() >= 30; }, std::chrono::seconds(2));
+            limitSeen = scheduler.getConcurrencyLimit();
+        });
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(limitSeen.load() == 3u);
+        TEST_ASSERT(scheduler.getStats().concurrencyChanges == 4u);
+        TEST_ASSERT(scheduler.getLastPressure().memory == 1.0);
+    }
+
+    TEST_FUNCTION(pressureMonitorSamples)
+    {
+        TEST_START;
+        TaskGraph::Internal::PressureMonitor monitor;
+        // The first sample only primes the totals.
+        TEST_ASSERT(!monitor.sample().valid);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const TaskGraph::PressureSample sample = monitor.sample();
+        TEST_ASSERT(sample.valid == TaskGraph::Internal::PressureMonitor::isSupported());
+        TEST_ASSERT(sample.cpu >= 0.0 && sample.cpu <= 1.0);
+        TEST_ASSERT(sample.memory >= 0.0 && sample.memory <= 1.0);
+        TEST_ASSERT(sample.io >= 0.0 && sample.io <= 1.0);
+        TEST_ASSERT(sample.runQueue >= 0.0);
+        monitor.reset();
+        TEST_ASSERT(!monitor.sample().valid);
+    }
+
+    TEST_FUNCTION(settingsRejectedWhileRunning)
+    {
+        TEST_START;
+        std::atomic<bool> release{false};
+        auto t = std::make_shared<TaskGraph::Task>("Hold");
+        t->setWorkFunction([&] {
+            while (!release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(!scheduler.getAdaptiveConcurrency().enabled);
+        // Out-of-range values are clamped.
+        TaskGraph::TaskScheduler::AdaptiveConcurrency settings;
+        settings.enabled = true;
+        settings.interval = std::chrono::milliseconds(0);
+        settings.samples = 0;
+        settings.minThreads = 0;
+        settings.raiseBelow = 0.5;
+        TEST_ASSERT(scheduler.setAdaptiveConcurrency(settings));
+        settings = scheduler.getAdaptiveConcurrency();
+        TEST_ASSERT(settings.interval == std::chrono::milliseconds(1));
+        TEST_ASSERT(settings.samples == 1u);
+        TEST_ASSERT(settings.minThreads == 1u);
+        TEST_ASSERT(settings.raiseBelow == settings.lowerAbove);
+
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(!scheduler.setAdaptiveConcurrency(TaskGraph::TaskScheduler::AdaptiveConcurrency()));
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+        TEST_ASSERT(!scheduler.setPressureProbe({}));
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+        release = true;
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+        TEST_ASSERT(scheduler.getAdaptiveConcurrency().enabled);
+    }
+};
+
+TEST_INSTANTIATE(TST_AdaptiveConcurrency);
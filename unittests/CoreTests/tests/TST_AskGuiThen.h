@@ -0,0 +1,225 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <QCoreApplication>
+#include <QObject>
+#include <QVariant>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+class TST_AskGuiThen : public UnitTest::Test
+{
+    TEST_CLASS(TST_AskGuiThen)
+public:
+    TST_AskGuiThen()
+        : Test("TST_AskGuiThen")
+    {
+        ADD_TEST(TST_AskGuiThen::workerFreeWhileWaiting);
+        ADD_TEST(TST_AskGuiThen::chainedQuestions);
+        ADD_TEST(TST_AskGuiThen::blockingAskGuiNotBusy);
+        ADD_TEST(TST_AskGuiThen::cancelWhileWaiting);
+        ADD_TEST(TST_AskGuiThen::retryRunsBodyAgain);
+        ADD_TEST(TST_AskGuiThen::rejectedCalls);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Processes queued signals until `done` holds or 3 s passed.
+    static bool pumpUntil(const std::function<bool()>& done)
+    {
+        const auto deadline = Clock::now() + std::chrono::seconds(3);
+        while (!done() && Clock::now() < deadline)
+        {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+        return done();
+    }
+
+    TEST_FUNCTION(workerFreeWhileWaiting)
+    {
+        TEST_START;
+        auto ask = std::make_shared<TaskGraph::Task>("Ask");
+        ask->setWorkFunction([](TaskGraph::TaskContext& ctx) {
+            ctx.askGuiThen(QVariant(QStringLiteral("size?")), [](TaskGraph::TaskContext& c, const QVariant& answer) {
+                c.setResult(answer.toInt() * 2);
+            });
+        });
+        std::atomic<bool> otherRan{false};
+        auto other = std::make_shared<TaskGraph::Task>("Other");
+        other->setWorkFunction([&otherRan] { otherRan = true; });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(ask));
+        TEST_ASSERT(scheduler.addTask(other));
+        // Without a context object the slot runs on the emitting worker.
+        std::atomic<int> request{-1};
+        QObject::connect(&scheduler, &TaskGraph::TaskScheduler::guiEventRequested,
+            [&request](int id, QString /*name*/, QVariant /*payload*/) { request = id; });
+
+        scheduler.runTasksAsync();
+        // The only worker runs the other task while the question is open.
+        TEST_ASSERT(pumpUntil([&] { return request.load() >= 0 && otherRan.load(); }));
+        TEST_ASSERT(pumpUntil([&] { return scheduler.getBusyThreadCount() == 0u; }));
+        TEST_ASSERT(scheduler.isRunning());
+        TEST_ASSERT(ask->getStatus() == TaskGraph::Task::Status::Running);
+
+        scheduler.respondToGuiEvent(request.load(), QVariant(21));
+        TEST_ASSERT(pumpUntil([&] { return !scheduler.isRunning(); }));
+        TEST_ASSERT(ask->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*ask) == 42);
+        TEST_ASSERT(scheduler.getStats().suspensions >= 1u);
+    }
+
+    TEST_FUNCTION(chainedQuestions)
+    {
+        TEST_START;
+        auto ask = std::make_shared<TaskGraph::Task>("AskTwice");
+        ask->setWorkFunction([](TaskGraph::TaskContext& ctx) {
+            ctx.askGuiThen(QVariant(1), [](TaskGraph::TaskContext& c, const QVariant& first) {
+                const int a = first.toInt();
+                c.askGuiThen(QVariant(2), [a](TaskGraph::TaskContext& c2, const QVariant& second) {
+                    c2.setResult(a + second.toInt());
+                });
+            });
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(ask));
+        std::atomic<int> answered{0};
+        QObject::connect(&scheduler, &TaskGraph::TaskScheduler::guiEventRequested,
+            [&scheduler, &answered](int id, QString /*name*/, QVariant payload) {
+                ++answered;
+                scheduler.respondToGuiEvent(id, QVariant(payload.toInt() * 10));
+            });
+
+        scheduler.runTasksAsync();
+        TEST_ASSERT(pumpUntil([&] { return !scheduler.isRunning(); }));
+        TEST_ASSERT(answered.load() == 2);
+        TEST_ASSERT(ask->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*ask) == 30);
+    }
+
+    TEST_FUNCTION(blockingAskGuiNotBusy)
+    {
+        TEST_START;
+        auto ask = std::make_shared<TaskGraph::Task>("AskBlocking");
+        ask->setWorkFunction([](TaskGraph::TaskContext& ctx) {
+            ctx.setResult(ctx.askGui(QVariant(QStringLiteral("ok?"))).toInt());
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(ask));
+        std::atomic<int> request{-1};
+        QObject::connect(&scheduler, &TaskGraph::TaskScheduler::guiEventRequested,
+            [&request](int id, QString /*name*/, QVariant /*payload*/) { request = id; });
+
+        scheduler.runTasksAsync();
+        TEST_ASSERT(pumpUntil([&] { return request.load() >= 0; }));
+        TEST_ASSERT(pumpUntil([&] { return scheduler.getBusyThreadCount() == 0u; }));
+        scheduler.respondToGuiEvent(request.load(), QVariant(7));
+        TEST_ASSERT(pumpUntil([&] { return !scheduler.isRunning(); }));
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*ask) == 7);
+        TEST_ASSERT(scheduler.getBusyThreadCount() == 0u);
+    }
+
+    TEST_FUNCTION(cancelWhileWaiting)
+    {
+        TEST_START;
+        std::atomic<bool> continued{false};
+        std::atomic<bool> answerValid{true};
+        auto ask = std::make_shared<TaskGraph::Task>("AskCancelled");
+        ask->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            ctx.askGuiThen(QVariant(0), [&](TaskGraph::TaskContext&, const QVariant& answer) {
+                answerValid = answer.isValid();
+                continued = true;
+            });
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(ask));
+        std::atomic<bool> asked{false};
+        QObject::connect(&scheduler, &TaskGraph::TaskScheduler::guiEventRequested,
+            [&asked](int, QString, QVariant) { asked = true; });
+
+        scheduler.runTasksAsync();
+        TEST_ASSERT(pumpUntil([&] { return asked.load(); }));
+        scheduler.cancel();
+        TEST_ASSERT(pumpUntil([&] { return !scheduler.isRunning(); }));
+        TEST_ASSERT(continued.load());
+        TEST_ASSERT(!answerValid.load());
+        TEST_ASSERT(ask->getStatus() == TaskGraph::Task::Status::Cancelled);
+    }
+
+    TEST_FUNCTION(retryRunsBodyAgain)
+    {
+        TEST_START;
+        std::atomic<int> bodies{0};
+        std::atomic<int> answers{0};
+        auto ask = std::make_shared<TaskGraph::Task>("AskFlaky");
+        ask->setMaxRetries(1);
+        ask->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            ++bodies;
+            ctx.askGuiThen(QVariant(0), [&](TaskGraph::TaskContext& c, const QVariant& answer) {
+                if (++answers == 1)
+                    throw std::runtime_error("rejected");
+                c.setResult(answer.toInt());
+            });
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(ask));
+        QObject::connect(&scheduler, &TaskGraph::TaskScheduler::guiEventRequested,
+            [&scheduler](int id, QString, QVariant) { scheduler.respondToGuiEvent(id, QVariant(5)); });
+
+        scheduler.runTasksAsync();
+        TEST_ASSERT(pumpUntil([&] { return !scheduler.isRunning(); }));
+        TEST_ASSERT(bodies.load() == 2);
+        TEST_ASSERT(answers.load() == 2);
+        TEST_ASSERT(ask->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*ask) == 5);
+    }
+
+    TEST_FUNCTION(rejectedCalls)
+    {
+        TEST_START;
+        auto noop = [](TaskGraph::TaskContext&, const QVariant&) {};
+
+        // Without a scheduler nobody could resume the task.
+        auto plain = std::make_shared<TaskGraph::Task>("Plain");
+        TaskGraph::TaskContext detached(plain.get(), nullptr);
+        TEST_ASSERT(!detached.askGuiThen(QVariant(), noop));
+
+        std::atomic<bool> second{true};
+        std::atomic<bool> fromCoroutine{true};
+        auto twice = std::make_shared<TaskGraph::Task>("Twice");
+        twice->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            ctx.askGuiThen(QVariant(), noop);
+            second = ctx.askGuiThen(QVariant(), noop);
+            ctx.dropContinuation();
+        });
+        auto co = std::make_shared<TaskGraph::Task>("Coroutine");
+        co->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            fromCoroutine = ctx.askGuiThen(QVariant(), noop);
+            co_return;
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(twice));
+        TEST_ASSERT(scheduler.addTask(co));
+        scheduler.runTasks();
+        TEST_ASSERT(!second.load());
+        TEST_ASSERT(!fromCoroutine.load());
+        TEST_ASSERT(twice->isDone());
+        TEST_ASSERT(co->isDone());
+    }
+};
+
+TEST_INSTANTIATE(TST_AskGuiThen);
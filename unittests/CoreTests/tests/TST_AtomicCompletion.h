@@ -0,0 +1,143 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+class TST_AtomicCompletion : public UnitTest::Test
+{
+    TEST_CLASS(TST_AtomicCompletion)
+public:
+    TST_AtomicCompletion()
+        : Test("TST_AtomicCompletion")
+    {
+        ADD_TEST(TST_AtomicCompletion::wideIndependentBothModes);
+        ADD_TEST(TST_AtomicCompletion::sharedDescendantSkippedOnce);
+        ADD_TEST(TST_AtomicCompletion::spawnOnFailedDependencySkips);
+    }
+
+private:
+    TEST_FUNCTION(wideIndependentBothModes)
+    {
+        TEST_START;
+        // 2000 independent tasks joined by one sink: the sink's counter is hit
+        // concurrently by every completion.
+        auto sink = std::make_shared<TaskGraph::Task>("Sink");
+        std::atomic<int> counter{0};
+        sink->setWorkFunction([&counter] { counter.fetch_add(1); });
+
+        TaskGraph::TaskScheduler scheduler(8);
+        TEST_ASSERT(scheduler.addTask(sink));
+        for (int i = 0; i < 2000; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("T" + std::to_string(i));
+            t->setWorkFunction([&counter] { counter.fetch_add(1); });
+            TEST_ASSERT(sink->addDependency(t));
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+
+        for (auto mode : { TaskGraph::TaskScheduler::ExecutionMode::SharedQueue,
+                           TaskGraph::TaskScheduler::ExecutionMode::WorkStealing })
+        {
+            TEST_ASSERT(scheduler.setExecutionMode(mode));
+            counter = 0;
+            scheduler.runTasks();
+            TEST_ASSERT(counter.load() == 2001);
+            TEST_ASSERT(sink->isDone());
+            TEST_ASSERT(scheduler.getTotalTasks() == 2001u);
+            TEST_ASSERT(scheduler.getProgressF() == 1.0f);
+        }
+    }
+
+    TEST_FUNCTION(sharedDescendantSkippedOnce)
+    {
+        TEST_START;
+        // A(fail) -> B, C -> D: D is reachable twice but must be skipped once,
+        // and the run must still account for every task.
+        auto a = std::make_shared<TaskGraph::Task>("A");
+        auto b = std::make_shared<TaskGraph::Task>("B");
+        auto c = std::make_shared<TaskGraph::Task>("C");
+        auto d = std::make_shared<TaskGraph::Task>("D");
+        auto e = std::make_shared<TaskGraph::Task>("E");
+        TEST_ASSERT(b->addDependency(a));
+        TEST_ASSERT(c->addDependency(a));
+        TEST_ASSERT(d->addDependency(b));
+        TEST_ASSERT(d->addDependency(c));
+
+        a->setWorkFunction([] { throw std::runtime_error("nope"); });
+        std::atomic<int> ran{0};
+        b->setWorkFunction([&] { ran.fetch_add(1); });
+        c->setWorkFunction([&] { ran.fetch_add(1); });
+        d->setWorkFunction([&] { ran.fetch_add(1); });
+        e->setWorkFunction([] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+
+        std::atomic<int> finished{0};
+        TaskGraph::TaskScheduler scheduler(4);
+        QObject::connect(&scheduler, &TaskGraph::TaskScheduler::taskFinished,
+                         [&finished](const QString&) { finished.fetch_add(1); });
+        scheduler.setFailurePolicy(TaskGraph::TaskScheduler::FailurePolicy::ContinueOthers);
+        TEST_ASSERT(scheduler.addTask(a));
+        TEST_ASSERT(scheduler.addTask(b));
+        TEST_ASSERT(scheduler.addTask(c));
+        TEST_ASSERT(scheduler.addTask(d));
+        TEST_ASSERT(scheduler.addTask(e));
+
+        scheduler.runTasks();
+
+        TEST_ASSERT(ran.load() == 0);
+        TEST_ASSERT(b->getStatus() == TaskGraph::Task::Status::Skipped);
+        TEST_ASSERT(c->getStatus() == TaskGraph::Task::Status::Skipped);
+        TEST_ASSERT(d->getStatus() == TaskGraph::Task::Status::Skipped);
+        TEST_ASSERT(e->isDone());
+        // B, C, D skipped + E done; the failed A reports through taskFailed.
+        TEST_ASSERT(finished.load() == 4);
+        TEST_ASSERT(scheduler.getProgressF() == 1.0f);
+    }
+
+    TEST_FUNCTION(spawnOnFailedDependencySkips)
+    {
+        TEST_START;
+        // S spawns a child that depends on the already failed A. The child can
+        // never become ready and must not keep the run alive.
+        auto a = std::make_shared<TaskGraph::Task>("A");
+        auto s = std::make_shared<TaskGraph::Task>("S");
+        auto child = std::make_shared<TaskGraph::Task>("Child");
+        TEST_ASSERT(child->addDependency(a));
+
+        a->setWorkFunction([] { throw std::runtime_error("nope"); });
+        std::atomic<bool> childRan{false};
+        child->setWorkFunction([&] { childRan = true; });
+        std::atomic<bool> spawned{false};
+        s->setWorkFunction([&, child](TaskGraph::TaskContext& ctx) {
+            while (a->getStatus() != TaskGraph::Task::Status::Failed)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            spawned = ctx.spawn(child);
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        scheduler.setFailurePolicy(TaskGraph::TaskScheduler::FailurePolicy::ContinueOthers);
+        TEST_ASSERT(scheduler.addTask(a));
+        TEST_ASSERT(scheduler.addTask(s));
+
+        scheduler.runTasksAsync();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+        while (!scheduler.isRunning() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        while (scheduler.isRunning() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        TEST_ASSERT(!scheduler.isRunning());
+        TEST_ASSERT(spawned.load());
+        TEST_ASSERT(!childRan.load());
+        TEST_ASSERT(child->getStatus() == TaskGraph::Task::Status::Skipped);
+        TEST_ASSERT(s->isDone());
+        TEST_ASSERT(scheduler.getTotalTasks() == 3u);
+    }
+};
+
+TEST_INSTANTIATE(TST_AtomicCompletion);
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_BlockingScope : public UnitTest::Test
+{
+    TEST_CLASS(TST_BlockingScope)
+public:
+    TST_BlockingScope()
+        : Test("TST_BlockingScope")
+    {
+        ADD_TEST(TST_BlockingScope::compensatesBlockedWorker);
+        ADD_TEST(TST_BlockingScope::manyBlockedWithinCap);
+        ADD_TEST(TST_BlockingScope::capZeroDisablesCompensation);
+        ADD_TEST(TST_BlockingScope::blockedNotCountedBusy);
+        ADD_TEST(TST_BlockingScope::nestedScopesCountOnce);
+        ADD_TEST(TST_BlockingScope::outsideSchedulerIsNoop);
+        ADD_TEST(TST_BlockingScope::capRejectedWhileRunning);
+    }
+
+private:
+    TEST_FUNCTION(compensatesBlockedWorker)
+    {
+        TEST_START;
+        // On one worker the waiter would block the only thread the setter could run on.
+        std::atomic<bool> flag{false};
+        std::atomic<bool> sawFlag{false};
+        auto waiter = std::make_shared<TaskGraph::Task>("Waiter");
+        waiter->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            auto scope = ctx.blockingScope();
+            sawFlag = TestHelpers::waitFor([&] { return flag.load(); }, std::chrono::seconds(2));
+        });
+        auto setter = std::make_shared<TaskGraph::Task>("Setter");
+        setter->setWorkFunction([&] { flag = true; });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(waiter));
+        TEST_ASSERT(scheduler.addTask(setter));
+        scheduler.runTasks();
+
+        TEST_ASSERT(waiter->isDone());
+        TEST_ASSERT(setter->isDone());
+        TEST_ASSERT(sawFlag.load());
+        TEST_ASSERT(scheduler.getStats().compensations == 1u);
+        TEST_ASSERT(scheduler.getBlockedThreadCount() == 0u);
+        TEST_ASSERT(scheduler.getCompensatingThreadCount() == 0u);
+        TEST_ASSERT(scheduler.getThreadCount() == 1u);
+
+        // The next run compensates again.
+        flag = false;
+        sawFlag = false;
+        scheduler.resetTasks();
+        scheduler.runTasks();
+        TEST_ASSERT(sawFlag.load());
+        TEST_ASSERT(scheduler.getStats().compensations == 2u);
+    }
+
+    TEST_FUNCTION(manyBlockedWithinCap)
+    {
+        TEST_START;
+        // Four tasks that only finish once all four are blocked at the same time.
+        constexpr int count = 4;
+        std::atomic<int> arrived{0};
+        std::atomic<int> released{0};
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setMaxCompensatingThreads(count - 1));
+        std::vector<std::shared_ptr<TaskGraph::Task>> tasks;
+        for (int i = 0; i < count; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Barrier" + std::to_string(i));
+            t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+                auto scope = ctx.blockingScope();
+                ++arrived;
+                if (TestHelpers::waitFor([&] { return arrived.load() == count; }, std::chrono::seconds(2)))
+                    ++released;
+            });
+            tasks.push_back(t);
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        scheduler.runTasks();
+
+        TEST_ASSERT(released.load() == count);
+        TEST_ASSERT(scheduler.getStats().compensations == static_cast<uint64_t>(count - 1));
+        TEST_ASSERT(scheduler.getCompensatingThreadCount() == 0u);
+    }
+
+    TEST_FUNCTION(capZeroDisablesCompensation)
+    {
+        TEST_START;
+        std::atomic<bool> flag{false};
+        std::atomic<bool> sawFlag{false};
+        auto waiter = std::make_shared<TaskGraph::Task>("Waiter");
+        waiter->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            auto scope = ctx.blockingScope();
+            sawFlag = TestHelpers::waitFor([&] { return flag.load(); }, std::chrono::milliseconds(100));
+        });
+        auto setter = std::make_shared<TaskGraph::Task>("Setter");
+        setter->setWorkFunction([&] { flag = true; });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setMaxCompensatingThreads(0));
+        TEST_ASSERT(scheduler.addTask(waiter));
+        TEST_ASSERT(scheduler.addTask(setter));
+        scheduler.runTasks();
+
+        TEST_ASSERT(waiter->isDone());
+        TEST_ASSERT(setter->isDone());
+        TEST_ASSERT(!sawFlag.load());
+        TEST_ASSERT(scheduler.getStats().compensations == 0u);
+    }
+
+    TEST_FUNCTION(blockedNotCountedBusy)
+    {
+        TEST_START;
+        std::atomic<bool> inside{false};
+        std::atomic<bool> release{false};
+        auto t = std::make_shared<TaskGraph::Task>("Blocked");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            auto scope = ctx.blockingScope();
+            inside = true;
+            TestHelpers::waitFor([&] { return release.load(); }, std::chrono::seconds(2));
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(TestHelpers::waitFor([&] { return inside.load(); }, std::chrono::seconds(2)));
+        TEST_ASSERT(scheduler.getBlockedThreadCount() == 1u);
+        TEST_ASSERT(scheduler.getBusyThreadCount() == 0u);
+        TEST_ASSERT(scheduler.getCompensatingThreadCount() == 1u);
+        release = true;
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(scheduler.getBlockedThreadCount() == 0u);
+        TEST_ASSERT(scheduler.getBusyThreadCount() == 0u);
+        TEST_ASSERT(scheduler.getCompensatingThreadCount() == 0u);
+    }
+
+    TEST_FUNCTION(nestedScopesCountOnce)
+    {
+        TEST_START;
+        std::atomic<unsigned int> blockedInner{0};
+        std::atomic<unsigned int> blockedAfterInner{0};
+        TaskGraph::TaskScheduler scheduler(1);
+        auto t = std::make_shared<TaskGraph::Task>("Nested");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            auto outer = ctx.blockingScope();
+            {
+                auto inner = ctx.blockingScope();
+                blockedInner = scheduler.getBlockedThreadCount();
+            }
+            blockedAfterInner = scheduler.getBlockedThreadCount();
+        });
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(blockedInner.load() == 1u);
+        TEST_ASSERT(blockedAfterInner.load() == 1u);
+        TEST_ASSERT(scheduler.getBlockedThreadCount() == 0u);
+        TEST_ASSERT(scheduler.getStats().compensations == 1u);
+    }
+
+    TEST_FUNCTION(outsideSchedulerIsNoop)
+    {
+        TEST_START;
+        TaskGraph::TaskScheduler scheduler(1);
+        std::atomic<bool> ran{false};
+        auto t = std::make_shared<TaskGraph::Task>("Direct");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            auto scope = ctx.blockingScope();
+            ran = true;
+        });
+        // Not part of a run: nothing is counted.
+        TaskGraph::TaskContext ctx(t.get(), &scheduler);
+        {
+            auto scope = ctx.blockingScope();
+            TEST_ASSERT(scheduler.getBlockedThreadCount() == 0u);
+        }
+        t->runTask(&ctx);
+        TEST_ASSERT(ran.load());
+        TEST_ASSERT(scheduler.getStats().compensations == 0u);
+    }
+
+    TEST_FUNCTION(capRejectedWhileRunning)
+    {
+        TEST_START;
+        std::atomic<bool> release{false};
+        auto t = std::make_shared<TaskGraph::Task>("Hold");
+        t->setWorkFunction([&] {
+            while (!release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.getMaxCompensatingThreads() == 8u);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(!scheduler.setMaxCompensatingThreads(2));
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+        release = true;
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+        TEST_ASSERT(scheduler.getMaxCompensatingThreads() == 8u);
+    }
+};
+
+TEST_INSTANTIATE(TST_BlockingScope);
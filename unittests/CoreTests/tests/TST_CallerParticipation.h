@@ -0,0 +1,166 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_CallerParticipation : public UnitTest::Test
+{
+    TEST_CLASS(TST_CallerParticipation)
+public:
+    TST_CallerParticipation()
+        : Test("TST_CallerParticipation")
+    {
+        ADD_TEST(TST_CallerParticipation::optionRoundTrip);
+        ADD_TEST(TST_CallerParticipation::callerRunsTasks);
+        ADD_TEST(TST_CallerParticipation::callerStealsInWorkStealingMode);
+        ADD_TEST(TST_CallerParticipation::asyncRunFinishedByWorker);
+        ADD_TEST(TST_CallerParticipation::destructorWaitsForAsyncRun);
+    }
+
+private:
+    struct ThreadSet
+    {
+        std::mutex m;
+        std::set<std::thread::id> ids;
+        void add()
+        {
+            std::lock_guard<std::mutex> lock(m);
+            ids.insert(std::this_thread::get_id());
+        }
+        bool contains(std::thread::id id)
+        {
+            std::lock_guard<std::mutex> lock(m);
+            return ids.count(id) > 0;
+        }
+    };
+
+    static std::shared_ptr<TaskGraph::Task> sleeper(const std::string& name, ThreadSet& threads, int ms)
+    {
+        auto t = std::make_shared<TaskGraph::Task>(name);
+        t->setWorkFunction([&threads, ms] {
+            threads.add();
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        });
+        return t;
+    }
+
+    static bool waitUntilIdle(TaskGraph::TaskScheduler& scheduler)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (scheduler.isRunning() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return !scheduler.isRunning();
+    }
+
+    TEST_FUNCTION(optionRoundTrip)
+    {
+        TEST_START;
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(!scheduler.getCallerParticipates());
+        TEST_ASSERT(scheduler.setCallerParticipates(true));
+        TEST_ASSERT(scheduler.getCallerParticipates());
+    }
+
+    TEST_FUNCTION(callerRunsTasks)
+    {
+        TEST_START;
+        // One worker and twenty 2 ms tasks: a participating caller takes some of them.
+        for (bool participate : { false, true })
+        {
+            ThreadSet threads;
+            TaskGraph::TaskScheduler scheduler(1);
+            TEST_ASSERT(scheduler.setCallerParticipates(participate));
+            for (int i = 0; i < 20; ++i)
+                TEST_ASSERT(scheduler.addTask(sleeper("T" + std::to_string(i), threads, 2)));
+            scheduler.runTasks();
+
+            TEST_ASSERT(scheduler.getStats().tasksExecuted == 20u);
+            TEST_ASSERT(threads.contains(std::this_thread::get_id()) == participate);
+            TEST_ASSERT(threads.ids.size() == (participate ? 2u : 1u));
+        }
+    }
+
+    TEST_FUNCTION(callerStealsInWorkStealingMode)
+    {
+        TEST_START;
+        ThreadSet threads;
+        auto root = sleeper("Root", threads, 0);
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setExecutionMode(TaskGraph::TaskScheduler::ExecutionMode::WorkStealing));
+        TEST_ASSERT(scheduler.setCallerParticipates(true));
+        TEST_ASSERT(scheduler.addTask(root));
+        std::vector<std::shared_ptr<TaskGraph::Task>> leaves;
+        for (int i = 0; i < 30; ++i)
+        {
+            auto leaf = sleeper("L" + std::to_string(i), threads, 1);
+            TEST_ASSERT(leaf->addDependency(root));
+            TEST_ASSERT(scheduler.addTask(leaf));
+            leaves.push_back(leaf);
+        }
+        scheduler.runTasks();
+
+        for (const auto& leaf : leaves)
+            TEST_ASSERT(leaf->isDone());
+        TEST_ASSERT(threads.contains(std::this_thread::get_id()));
+    }
+
+    TEST_FUNCTION(asyncRunFinishedByWorker)
+    {
+        TEST_START;
+        // No coordinator thread: completed() comes from the worker that retired the
+        // last task. Repeated to make sure back-to-back async runs work.
+        ThreadSet threads;
+        TaskGraph::TaskScheduler scheduler(2);
+        for (int i = 0; i < 6; ++i)
+            TEST_ASSERT(scheduler.addTask(sleeper("T" + std::to_string(i), threads, 5)));
+        std::mutex m;
+        std::vector<std::thread::id> completedOn;
+        QObject::connect(&scheduler, &TaskGraph::TaskScheduler::completed, [&m, &completedOn] {
+            std::lock_guard<std::mutex> lock(m);
+            completedOn.push_back(std::this_thread::get_id());
+        });
+
+        for (int run = 0; run < 3; ++run)
+        {
+            scheduler.runTasksAsync();
+            TEST_ASSERT(waitUntilIdle(scheduler));
+        }
+
+        std::lock_guard<std::mutex> lock(m);
+        TEST_ASSERT(completedOn.size() == 3u);
+        for (auto id : completedOn)
+            TEST_ASSERT(threads.contains(id));
+        TEST_ASSERT(scheduler.getStats().tasksExecuted == 18u);
+    }
+
+    TEST_FUNCTION(destructorWaitsForAsyncRun)
+    {
+        TEST_START;
+        ThreadSet threads;
+        std::vector<std::shared_ptr<TaskGraph::Task>> tasks;
+        {
+            TaskGraph::TaskScheduler scheduler(2);
+            for (int i = 0; i < 10; ++i)
+            {
+                tasks.push_back(sleeper("T" + std::to_string(i), threads, 5));
+                TEST_ASSERT(scheduler.addTask(tasks.back()));
+            }
+            scheduler.runTasksAsync();
+            TEST_ASSERT(scheduler.isRunning());
+        }
+        // Every task either ran or was cancelled; none is left running.
+        for (const auto& t : tasks)
+            TEST_ASSERT(t->getStatus() == TaskGraph::Task::Status::Done
+                        || t->getStatus() == TaskGraph::Task::Status::Cancelled);
+    }
+};
+
+TEST_INSTANTIATE(TST_CallerParticipation);
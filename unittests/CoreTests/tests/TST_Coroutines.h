@@ -0,0 +1,328 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <QCoreApplication>
+#include <QObject>
+#include <QVariant>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+class TST_Coroutines : public UnitTest::Test
+{
+    TEST_CLASS(TST_Coroutines)
+public:
+    TST_Coroutines()
+        : Test("TST_Coroutines")
+    {
+        ADD_TEST(TST_Coroutines::sleepFreesWorker);
+        ADD_TEST(TST_Coroutines::manySleepersFewWorkers);
+        ADD_TEST(TST_Coroutines::dependencyResult);
+        ADD_TEST(TST_Coroutines::failedDependencyThrows);
+        ADD_TEST(TST_Coroutines::indirectDependentThrows);
+        ADD_TEST(TST_Coroutines::guiRoundTrip);
+        ADD_TEST(TST_Coroutines::cancelWakesSleeper);
+        ADD_TEST(TST_Coroutines::timeoutWhileSuspended);
+        ADD_TEST(TST_Coroutines::retryAfterFailedAttempt);
+        ADD_TEST(TST_Coroutines::withoutThreads);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static bool waitUntilIdle(TaskGraph::TaskScheduler& scheduler, std::chrono::milliseconds limit)
+    {
+        const auto deadline = Clock::now() + limit;
+        while (scheduler.isRunning() && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return !scheduler.isRunning();
+    }
+
+    TEST_FUNCTION(sleepFreesWorker)
+    {
+        TEST_START;
+        std::atomic<bool> otherRan{false};
+        std::atomic<bool> otherRanFirst{false};
+        auto sleeper = std::make_shared<TaskGraph::Task>("Sleeper");
+        sleeper->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            co_await ctx.sleepFor(std::chrono::milliseconds(100));
+            otherRanFirst = otherRan.load();
+        });
+        auto other = std::make_shared<TaskGraph::Task>("Other");
+        other->setWorkFunction([&] { otherRan = true; });
+
+        // One worker: a blocking sleep would hold it for the whole 100 ms.
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(sleeper));
+        TEST_ASSERT(scheduler.addTask(other));
+        scheduler.runTasks();
+
+        TEST_ASSERT(sleeper->isDone());
+        TEST_ASSERT(other->isDone());
+        TEST_ASSERT(otherRanFirst.load());
+        TEST_ASSERT(scheduler.getStats().suspensions >= 1u);
+        TEST_ASSERT(sleeper->getLastDuration() >= std::chrono::milliseconds(100));
+    }
+
+    TEST_FUNCTION(manySleepersFewWorkers)
+    {
+        TEST_START;
+        std::atomic<int> finished{0};
+        TaskGraph::TaskScheduler scheduler(2);
+        for (int i = 0; i < 200; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Sleeper" + std::to_string(i));
+            t->setCoroutineFunction([&finished](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+                co_await ctx.sleepFor(std::chrono::milliseconds(50));
+                ++finished;
+            });
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+
+        // Blocking sleeps would take 200 * 50 ms / 2 workers = 5 s.
+        const auto start = Clock::now();
+        scheduler.runTasks();
+        const auto took = Clock::now() - start;
+
+        TEST_ASSERT(finished.load() == 200);
+        TEST_ASSERT(took < std::chrono::milliseconds(2000));
+        // A worker leaves the busy count only after it retired its last task, which
+        // may be just after runTasks() returned.
+        const auto deadline = Clock::now() + std::chrono::seconds(2);
+        while (scheduler.getBusyThreadCount() != 0u && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        TEST_ASSERT(scheduler.getBusyThreadCount() == 0u);
+    }
+
+    TEST_FUNCTION(dependencyResult)
+    {
+        TEST_START;
+        auto producer = std::make_shared<TaskGraph::Task>("Producer");
+        producer->setWorkFunction([](TaskGraph::TaskContext& ctx) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ctx.setResult(21);
+        });
+        // No edge between the two: the consumer waits for the producer inside its body.
+        auto consumer = std::make_shared<TaskGraph::Task>("Consumer");
+        consumer->setCoroutineFunction([&producer](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            const int v = co_await ctx.dependency<int>(*producer);
+            ctx.setResult(2 * v);
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(consumer));
+        TEST_ASSERT(scheduler.addTask(producer));
+        scheduler.runTasks();
+
+        TEST_ASSERT(producer->isDone());
+        TEST_ASSERT(consumer->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*consumer) == 42);
+    }
+
+    TEST_FUNCTION(failedDependencyThrows)
+    {
+        TEST_START;
+        auto bad = std::make_shared<TaskGraph::Task>("Bad");
+        bad->setWorkFunction([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            throw std::runtime_error("boom");
+        });
+        std::atomic<bool> caught{false};
+        auto waiter = std::make_shared<TaskGraph::Task>("Waiter");
+        waiter->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            try
+            {
+                co_await ctx.dependency(*bad);
+            }
+            catch (const std::runtime_error&)
+            {
+                caught = true;
+            }
+        });
+        // Awaiting a task that depends on the waiter would never resume.
+        auto dependent = std::make_shared<TaskGraph::Task>("Dependent");
+        dependent->setWorkFunction([] {});
+        dependent->addDependency(waiter);
+        auto cyclic = std::make_shared<TaskGraph::Task>("Cyclic");
+        cyclic->setCoroutineFunction([&dependent](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            co_await ctx.dependency(*dependent);
+        });
+        dependent->addDependency(cyclic);
+
+        TaskGraph::TaskScheduler scheduler(2);
+        scheduler.setFailurePolicy(TaskGraph::TaskScheduler::FailurePolicy::ContinueOthers);
+        TEST_ASSERT(scheduler.addTask(bad));
+        TEST_ASSERT(scheduler.addTask(waiter));
+        TEST_ASSERT(scheduler.addTask(dependent));
+        TEST_ASSERT(scheduler.addTask(cyclic));
+        scheduler.runTasks();
+
+        TEST_ASSERT(bad->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(caught.load());
+        TEST_ASSERT(waiter->isDone());
+        TEST_ASSERT(cyclic->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(dependent->getStatus() == TaskGraph::Task::Status::Skipped);
+    }
+
+    TEST_FUNCTION(indirectDependentThrows)
+    {
+        TEST_START;
+        // Cyclic -> Middle -> Far: Far only reaches the awaiting task in two steps.
+        auto middle = std::make_shared<TaskGraph::Task>("Middle");
+        middle->setWorkFunction([] {});
+        auto far = std::make_shared<TaskGraph::Task>("Far");
+        far->setWorkFunction([] {});
+        std::atomic<bool> caught{false};
+        auto cyclic = std::make_shared<TaskGraph::Task>("Cyclic");
+        cyclic->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            try
+            {
+                co_await ctx.dependency(*far);
+            }
+            catch (const std::runtime_error&)
+            {
+                caught = true;
+            }
+        });
+        middle->addDependency(cyclic);
+        far->addDependency(middle);
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(cyclic));
+        TEST_ASSERT(scheduler.addTask(middle));
+        TEST_ASSERT(scheduler.addTask(far));
+        scheduler.runTasks();
+
+        TEST_ASSERT(caught.load());
+        TEST_ASSERT(cyclic->isDone());
+        TEST_ASSERT(middle->isDone());
+        TEST_ASSERT(far->isDone());
+    }
+
+    TEST_FUNCTION(guiRoundTrip)
+    {
+        TEST_START;
+        QCoreApplication* app = QCoreApplication::instance();
+        TEST_ASSERT(app != nullptr);
+        if (!app) return;
+
+        auto t = std::make_shared<TaskGraph::Task>("AskGuiAsync");
+        t->setCoroutineFunction([](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            QVariant r = co_await ctx.askGuiAsync(QVariant(QStringLiteral("prompt")));
+            ctx.setResult(r.toInt());
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        QObject::connect(&scheduler, &TaskGraph::TaskScheduler::guiEventRequested,
+            [&scheduler](int id, QString /*name*/, QVariant /*payload*/) {
+                scheduler.respondToGuiEvent(id, QVariant(42));
+            });
+
+        scheduler.runTasksAsync();
+        const auto deadline = Clock::now() + std::chrono::seconds(3);
+        while (scheduler.isRunning() && Clock::now() < deadline)
+        {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+
+        TEST_ASSERT(!scheduler.isRunning());
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*t) == 42);
+    }
+
+    TEST_FUNCTION(cancelWakesSleeper)
+    {
+        TEST_START;
+        std::atomic<bool> resumedNormally{false};
+        auto t = std::make_shared<TaskGraph::Task>("LongSleeper");
+        t->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            co_await ctx.sleepFor(std::chrono::seconds(10));
+            resumedNormally = true;
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        scheduler.cancel();
+
+        TEST_ASSERT(waitUntilIdle(scheduler, std::chrono::seconds(2)));
+        TEST_ASSERT(!resumedNormally.load());
+        TEST_ASSERT(t->getStatus() == TaskGraph::Task::Status::Cancelled);
+    }
+
+    TEST_FUNCTION(timeoutWhileSuspended)
+    {
+        TEST_START;
+        auto t = std::make_shared<TaskGraph::Task>("TimedOut");
+        t->setTimeout(std::chrono::milliseconds(50));
+        t->setCoroutineFunction([](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            co_await ctx.sleepFor(std::chrono::seconds(10));
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        const auto start = Clock::now();
+        scheduler.runTasks();
+
+        TEST_ASSERT(Clock::now() - start < std::chrono::seconds(2));
+        TEST_ASSERT(t->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(t->getLastError() == QStringLiteral("timeout"));
+    }
+
+    TEST_FUNCTION(retryAfterFailedAttempt)
+    {
+        TEST_START;
+        std::atomic<int> attempts{0};
+        auto t = std::make_shared<TaskGraph::Task>("Flaky");
+        t->setMaxRetries(2);
+        t->setRetryBackoff(std::chrono::milliseconds(10));
+        t->setCoroutineFunction([&attempts](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            co_await ctx.sleepFor(std::chrono::milliseconds(5));
+            if (++attempts < 2)
+                throw std::runtime_error("flaky");
+            ctx.setResult(attempts.load());
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(attempts.load() == 2);
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*t) == 2);
+    }
+
+    TEST_FUNCTION(withoutThreads)
+    {
+        TEST_START;
+        auto a = std::make_shared<TaskGraph::Task>("A");
+        a->setCoroutineFunction([](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            co_await ctx.sleepFor(std::chrono::milliseconds(20));
+            ctx.setResult(5);
+        });
+        auto b = std::make_shared<TaskGraph::Task>("B");
+        b->setCoroutineFunction([&a](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            const int v = co_await ctx.dependency<int>(*a);
+            ctx.setResult(v + 1);
+        });
+
+        TaskGraph::TaskScheduler scheduler(0);
+        TEST_ASSERT(scheduler.addTask(b));
+        TEST_ASSERT(scheduler.addTask(a));
+        scheduler.runTasks();
+
+        TEST_ASSERT(a->isDone());
+        TEST_ASSERT(b->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*b) == 6);
+    }
+};
+
+TEST_INSTANTIATE(TST_Coroutines);
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_CriticalPath : public UnitTest::Test
+{
+    TEST_CLASS(TST_CriticalPath)
+public:
+    TST_CriticalPath()
+        : Test("TST_CriticalPath")
+    {
+        ADD_TEST(TST_CriticalPath::policyRoundTrip);
+        ADD_TEST(TST_CriticalPath::longChainStartsFirst);
+        ADD_TEST(TST_CriticalPath::fifoKeepsReadyOrder);
+        ADD_TEST(TST_CriticalPath::measuredDurationsOverrideWeights);
+    }
+
+private:
+    struct Recorder
+    {
+        std::mutex m;
+        std::vector<std::string> order;
+        void operator()(const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(m);
+            order.push_back(name);
+        }
+    };
+
+    // 6 independent short tasks added first, then a 5-task chain of weight-2 tasks.
+    static void buildChainAndShorts(TaskGraph::TaskScheduler& scheduler, Recorder& rec)
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("S" + std::to_string(i));
+            t->setWorkFunction([&rec, name = t->getName()] { rec(name); });
+            scheduler.addTask(t);
+        }
+        std::shared_ptr<TaskGraph::Task> prev;
+        for (int i = 0; i < 5; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("C" + std::to_string(i));
+            t->setWeight(2.0f);
+            t->setWorkFunction([&rec, name = t->getName()] { rec(name); });
+            if (prev)
+                t->addDependency(prev);
+            scheduler.addTask(t);
+            prev = t;
+        }
+    }
+
+    TEST_FUNCTION(policyRoundTrip)
+    {
+        TEST_START;
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.getSchedulingPolicy() == TaskGraph::TaskScheduler::SchedulingPolicy::Fifo);
+        TEST_ASSERT(scheduler.setSchedulingPolicy(TaskGraph::TaskScheduler::SchedulingPolicy::CriticalPath));
+        TEST_ASSERT(scheduler.getSchedulingPolicy() == TaskGraph::TaskScheduler::SchedulingPolicy::CriticalPath);
+    }
+
+    TEST_FUNCTION(longChainStartsFirst)
+    {
+        TEST_START;
+        // One worker makes the dispatch order observable: every chain task outranks
+        // every short task, so the whole chain runs first.
+        Recorder rec;
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setSchedulingPolicy(TaskGraph::TaskScheduler::SchedulingPolicy::CriticalPath));
+        buildChainAndShorts(scheduler, rec);
+        scheduler.runTasks();
+
+        TEST_ASSERT(rec.order.size() == 11u);
+        for (int i = 0; i < 5; ++i)
+            TEST_ASSERT(rec.order[i] == "C" + std::to_string(i));
+    }
+
+    TEST_FUNCTION(fifoKeepsReadyOrder)
+    {
+        TEST_START;
+        Recorder rec;
+        TaskGraph::TaskScheduler scheduler(1);
+        buildChainAndShorts(scheduler, rec);
+        scheduler.runTasks();
+
+        TEST_ASSERT(rec.order.size() == 11u);
+        TEST_ASSERT(rec.order[0] == "S0");
+    }
+
+    TEST_FUNCTION(measuredDurationsOverrideWeights)
+    {
+        TEST_START;
+        // "Heavy" has the larger weight but is fast; "Slow" has weight 1 but takes
+        // 20 ms. The first run ranks by weight, later runs by measured duration.
+        Recorder rec;
+        auto heavy = std::make_shared<TaskGraph::Task>("Heavy");
+        heavy->setWeight(5.0f);
+        heavy->setWorkFunction([&rec] { rec("Heavy"); });
+        auto slow = std::make_shared<TaskGraph::Task>("Slow");
+        slow->setWorkFunction([&rec] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            rec("Slow");
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setSchedulingPolicy(TaskGraph::TaskScheduler::SchedulingPolicy::CriticalPath));
+        TEST_ASSERT(scheduler.addTask(slow));
+        TEST_ASSERT(scheduler.addTask(heavy));
+
+        scheduler.runTasks();
+        TEST_ASSERT(rec.order.size() == 2u);
+        TEST_ASSERT(rec.order[0] == "Heavy");
+        TEST_ASSERT(slow->getLastDuration() >= std::chrono::milliseconds(20));
+
+        rec.order.clear();
+        scheduler.runTasks();
+        TEST_ASSERT(rec.order.size() == 2u);
+        TEST_ASSERT(rec.order[0] == "Slow");
+    }
+};
+
+TEST_INSTANTIATE(TST_CriticalPath);
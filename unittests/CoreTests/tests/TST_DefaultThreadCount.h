@@ -0,0 +1,180 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include "CpuQuota.h"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+class TST_DefaultThreadCount : public UnitTest::Test
+{
+    TEST_CLASS(TST_DefaultThreadCount)
+public:
+    TST_DefaultThreadCount()
+        : Test("TST_DefaultThreadCount")
+    {
+        ADD_TEST(TST_DefaultThreadCount::detectWithinHostLimits);
+        ADD_TEST(TST_DefaultThreadCount::cgroupV2Quota);
+        ADD_TEST(TST_DefaultThreadCount::tightestAncestorWins);
+        ADD_TEST(TST_DefaultThreadCount::cgroupV1Fallback);
+        ADD_TEST(TST_DefaultThreadCount::namespacedCgroupRoot);
+        ADD_TEST(TST_DefaultThreadCount::schedulerReportsSource);
+    }
+
+private:
+    // A throw-away directory standing in for / (proc files and cgroup mounts).
+    struct FakeRoot
+    {
+        std::filesystem::path path;
+        FakeRoot()
+        {
+            path = std::filesystem::temp_directory_path() / ("tg_cgroup_" + std::to_string(::getpid()));
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path / "proc/self");
+        }
+        ~FakeRoot()
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+        void write(const std::string& file, const std::string& content) const
+        {
+            const std::filesystem::path target = path / file;
+            std::filesystem::create_directories(target.parent_path());
+            std::ofstream(target) << content;
+        }
+        std::string str() const { return path.string(); }
+    };
+
+    static constexpr const char* v2Mount =
+        "30 24 0:26 / /sys/fs/cgroup rw,nosuid,nodev,noexec,relatime - cgroup2 cgroup2 rw,nsdelegate\n";
+    static constexpr const char* hybridMounts =
+        "32 24 0:28 / /sys/fs/cgroup rw,relatime - tmpfs tmpfs rw,mode=755\n"
+        "33 32 0:29 / /sys/fs/cgroup/cpu,cpuacct rw,relatime - cgroup cgroup rw,cpu,cpuacct\n"
+        "34 32 0:30 / /sys/fs/cgroup/cpuset rw,relatime - cgroup cgroup rw,cpuset\n"
+        "42 32 0:38 / /sys/fs/cgroup/unified rw,relatime - cgroup2 cgroup2 rw\n";
+
+    TEST_FUNCTION(detectWithinHostLimits)
+    {
+        TEST_START;
+        const TaskGraph::DefaultThreadCount detected = TaskGraph::TaskScheduler::detectDefaultThreadCount();
+        TEST_ASSERT(detected.count >= 1u);
+        TEST_ASSERT(detected.count <= std::max(1u, std::thread::hardware_concurrency()));
+        TEST_ASSERT(detected.source != TaskGraph::ThreadCountSource::Explicit);
+        const unsigned int affinity = TaskGraph::Internal::CpuQuota::affinityCpuCount();
+        if (affinity > 0)
+            TEST_ASSERT(detected.count <= affinity);
+        if (detected.source == TaskGraph::ThreadCountSource::Affinity)
+            TEST_ASSERT(detected.count == affinity);
+        TEST_ASSERT(TaskGraph::LibraryInfo::getDefaultThreadCount().count == detected.count);
+        TEST_ASSERT(TaskGraph::LibraryInfo::getInfoStr().find("Default Threads:") != std::string::npos);
+    }
+
+    TEST_FUNCTION(cgroupV2Quota)
+    {
+        TEST_START;
+        FakeRoot root;
+        root.write("proc/self/mountinfo", v2Mount);
+        root.write("proc/self/cgroup", "0::/kubepods/pod1\n");
+        root.write("sys/fs/cgroup/kubepods/pod1/cpu.max", "400000 100000\n");
+        root.write("sys/fs/cgroup/kubepods/cpu.max", "max 100000\n");
+
+        TaskGraph::ThreadCountSource source = TaskGraph::ThreadCountSource::Explicit;
+        TEST_ASSERT(TaskGraph::Internal::CpuQuota::cgroupCpuLimit(root.str(), source) == 4.0);
+        TEST_ASSERT(source == TaskGraph::ThreadCountSource::CgroupV2Quota);
+
+        // "max" all the way up: no limit.
+        root.write("sys/fs/cgroup/kubepods/pod1/cpu.max", "max 100000\n");
+        source = TaskGraph::ThreadCountSource::Explicit;
+        TEST_ASSERT(TaskGraph::Internal::CpuQuota::cgroupCpuLimit(root.str(), source) == 0.0);
+        TEST_ASSERT(source == TaskGraph::ThreadCountSource::Explicit);
+    }
+
+    TEST_FUNCTION(tightestAncestorWins)
+    {
+        TEST_START;
+        FakeRoot root;
+        root.write("proc/self/mountinfo", v2Mount);
+        root.write("proc/self/cgroup", "0::/a/b/c\n");
+        root.write("sys/fs/cgroup/a/b/c/cpu.max", "250000 100000\n");
+        root.write("sys/fs/cgroup/a/cpu.max", "150000 100000\n");
+
+        TaskGraph::ThreadCountSource source = TaskGraph::ThreadCountSource::Explicit;
+        TEST_ASSERT(TaskGraph::Internal::CpuQuota::cgroupCpuLimit(root.str(), source) == 1.5);
+        TEST_ASSERT(source == TaskGraph::ThreadCountSource::CgroupV2Quota);
+    }
+
+    TEST_FUNCTION(cgroupV1Fallback)
+    {
+        TEST_START;
+        // Hybrid layout: cgroup2 without the cpu controller, the quota sits in v1.
+        FakeRoot root;
+        root.write("proc/self/mountinfo", hybridMounts);
+        root.write("proc/self/cgroup", "5:cpuset:/\n4:cpu,cpuacct:/docker/abc\n0::/docker/abc\n");
+        root.write("sys/fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "200000\n");
+        root.write("sys/fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_period_us", "100000\n");
+
+        TaskGraph::ThreadCountSource source = TaskGraph::ThreadCountSource::Explicit;
+        TEST_ASSERT(TaskGraph::Internal::CpuQuota::cgroupCpuLimit(root.str(), source) == 2.0);
+        TEST_ASSERT(source == TaskGraph::ThreadCountSource::CgroupV1Quota);
+
+        // -1 is "no quota".
+        root.write("sys/fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "-1\n");
+        TEST_ASSERT(TaskGraph::Internal::CpuQuota::cgroupCpuLimit(root.str(), source) == 0.0);
+    }
+
+    TEST_FUNCTION(namespacedCgroupRoot)
+    {
+        TEST_START;
+        // The mount root is the container's own cgroup: its files sit at the mount point.
+        FakeRoot root;
+        root.write("proc/self/mountinfo",
+                   "33 32 0:29 /docker/abc /sys/fs/cgroup/cpu rw,relatime - cgroup cgroup rw,cpu\n");
+        root.write("proc/self/cgroup", "3:cpu:/docker/abc\n");
+        root.write("sys/fs/cgroup/cpu/cpu.cfs_quota_us", "50000\n");
+        root.write("sys/fs/cgroup/cpu/cpu.cfs_period_us", "100000\n");
+
+        TaskGraph::ThreadCountSource source = TaskGraph::ThreadCountSource::Explicit;
+        TEST_ASSERT(TaskGraph::Internal::CpuQuota::cgroupCpuLimit(root.str(), source) == 0.5);
+        TEST_ASSERT(source == TaskGraph::ThreadCountSource::CgroupV1Quota);
+    }
+
+    TEST_FUNCTION(schedulerReportsSource)
+    {
+        TEST_START;
+        const TaskGraph::DefaultThreadCount detected = TaskGraph::TaskScheduler::detectDefaultThreadCount();
+        TaskGraph::TaskScheduler automatic;
+        TEST_ASSERT(automatic.getThreadCountSource() == detected.source);
+        auto t = std::make_shared<TaskGraph::Task>("Run");
+        t->setWorkFunction([] {});
+        TEST_ASSERT(automatic.addTask(t));
+        automatic.runTasks();
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(automatic.getThreadCount() == detected.count);
+
+        TEST_ASSERT(automatic.enableThreads(3));
+        TEST_ASSERT(automatic.getThreadCount() == 3u);
+        TEST_ASSERT(automatic.getThreadCountSource() == TaskGraph::ThreadCountSource::Explicit);
+        TEST_ASSERT(automatic.enableThreads(TaskGraph::TaskScheduler::autoThreadCount));
+        TEST_ASSERT(automatic.getThreadCount() == detected.count);
+        TEST_ASSERT(automatic.getThreadCountSource() == detected.source);
+        TEST_ASSERT(automatic.disableThreads());
+        TEST_ASSERT(automatic.getThreadCountSource() == TaskGraph::ThreadCountSource::Explicit);
+
+        TaskGraph::TaskScheduler fixed(2);
+        TEST_ASSERT(fixed.getThreadCountSource() == TaskGraph::ThreadCountSource::Explicit);
+        TaskGraph::DefaultThreadCount named;
+        named.source = TaskGraph::ThreadCountSource::CgroupV2Quota;
+        TEST_ASSERT(std::string(named.sourceName()) == "cgroup v2 cpu.max");
+    }
+};
+
+TEST_INSTANTIATE(TST_DefaultThreadCount);
+
+#endif
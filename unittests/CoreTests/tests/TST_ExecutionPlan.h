@@ -0,0 +1,153 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TST_ExecutionPlan : public UnitTest::Test
+{
+    TEST_CLASS(TST_ExecutionPlan)
+public:
+    TST_ExecutionPlan()
+        : Test("TST_ExecutionPlan")
+    {
+        ADD_TEST(TST_ExecutionPlan::compiledPlanReused);
+        ADD_TEST(TST_ExecutionPlan::mutationInvalidates);
+        ADD_TEST(TST_ExecutionPlan::rerunAfterNewDependency);
+        ADD_TEST(TST_ExecutionPlan::missingDependencyRejected);
+        ADD_TEST(TST_ExecutionPlan::compileRejectedWhileRunning);
+    }
+
+private:
+    TEST_FUNCTION(compiledPlanReused)
+    {
+        TEST_START;
+        auto a = std::make_shared<TaskGraph::Task>("A");
+        auto b = std::make_shared<TaskGraph::Task>("B");
+        auto c = std::make_shared<TaskGraph::Task>("C");
+        TEST_ASSERT(b->addDependency(a));
+        TEST_ASSERT(c->addDependency(a));
+        std::atomic<int> counter{0};
+        for (auto& t : { a, b, c })
+            t->setWorkFunction([&counter] { counter.fetch_add(1); });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(a));
+        TEST_ASSERT(scheduler.addTask(b));
+        TEST_ASSERT(scheduler.addTask(c));
+        TEST_ASSERT(!scheduler.isCompiled());
+        TEST_ASSERT(scheduler.compile());
+        TEST_ASSERT(scheduler.isCompiled());
+        TEST_ASSERT(scheduler.getTaskGraph().size() == 2u);
+
+        for (int run = 0; run < 3; ++run)
+        {
+            counter = 0;
+            scheduler.runTasks();
+            TEST_ASSERT(counter.load() == 3);
+            TEST_ASSERT(b->isDone());
+            TEST_ASSERT(c->isDone());
+            TEST_ASSERT(scheduler.isCompiled());
+        }
+    }
+
+    TEST_FUNCTION(mutationInvalidates)
+    {
+        TEST_START;
+        auto a = std::make_shared<TaskGraph::Task>("A");
+        auto b = std::make_shared<TaskGraph::Task>("B");
+        auto c = std::make_shared<TaskGraph::Task>("C");
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(a));
+        TEST_ASSERT(scheduler.addTask(b));
+        TEST_ASSERT(scheduler.compile());
+
+        TEST_ASSERT(b->addDependency(a));
+        TEST_ASSERT(!scheduler.isCompiled());
+        TEST_ASSERT(scheduler.compile());
+
+        TEST_ASSERT(scheduler.addTask(c));
+        TEST_ASSERT(!scheduler.isCompiled());
+        TEST_ASSERT(scheduler.compile());
+
+        TEST_ASSERT(scheduler.removeTask(c));
+        TEST_ASSERT(!scheduler.isCompiled());
+        TEST_ASSERT(scheduler.compile());
+
+        TEST_ASSERT(b->clearDependencies());
+        TEST_ASSERT(!scheduler.isCompiled());
+    }
+
+    TEST_FUNCTION(rerunAfterNewDependency)
+    {
+        TEST_START;
+        // The first run uses a plan with A and B independent; the second run must
+        // honour the edge added in between without an explicit compile().
+        std::mutex m;
+        std::vector<std::string> order;
+        auto a = std::make_shared<TaskGraph::Task>("A");
+        auto b = std::make_shared<TaskGraph::Task>("B");
+        a->setWorkFunction([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            std::lock_guard<std::mutex> lock(m);
+            order.push_back("A");
+        });
+        b->setWorkFunction([&] {
+            std::lock_guard<std::mutex> lock(m);
+            order.push_back("B");
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(a));
+        TEST_ASSERT(scheduler.addTask(b));
+        scheduler.runTasks();
+        TEST_ASSERT(order.size() == 2u);
+
+        TEST_ASSERT(b->addDependency(a));
+        order.clear();
+        scheduler.runTasks();
+        TEST_ASSERT(order.size() == 2u);
+        TEST_ASSERT(order[0] == "A");
+        TEST_ASSERT(order[1] == "B");
+        TEST_ASSERT(scheduler.getTaskGraph().size() == 2u);
+    }
+
+    TEST_FUNCTION(missingDependencyRejected)
+    {
+        TEST_START;
+        auto a = std::make_shared<TaskGraph::Task>("A");
+        auto b = std::make_shared<TaskGraph::Task>("B");
+        TEST_ASSERT(b->addDependency(a));
+
+        TaskGraph::TaskScheduler scheduler(0);
+        TEST_ASSERT(scheduler.addTask(b));
+        TEST_ASSERT(!scheduler.compile());
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::missingDependency);
+        TEST_ASSERT(!scheduler.isCompiled());
+    }
+
+    TEST_FUNCTION(compileRejectedWhileRunning)
+    {
+        TEST_START;
+        auto slow = std::make_shared<TaskGraph::Task>("Slow");
+        slow->setWorkFunction([] { std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(slow));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(!scheduler.compile());
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+
+        while (scheduler.isRunning())
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        TEST_ASSERT(scheduler.isCompiled());
+    }
+};
+
+TEST_INSTANTIATE(TST_ExecutionPlan);
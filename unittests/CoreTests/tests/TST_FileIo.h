@@ -0,0 +1,320 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include "FileIoService.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+class TST_FileIo : public UnitTest::Test
+{
+    TEST_CLASS(TST_FileIo)
+public:
+    TST_FileIo()
+        : Test("TST_FileIo")
+    {
+        ADD_TEST(TST_FileIo::serviceCompletesEveryOp);
+        ADD_TEST(TST_FileIo::stopWithReadsInFlight);
+        ADD_TEST(TST_FileIo::stopWhileSubmitting);
+        ADD_TEST(TST_FileIo::roundTripBothBackends);
+        ADD_TEST(TST_FileIo::continuationReadsToEof);
+#if defined(__linux__)
+        ADD_TEST(TST_FileIo::errorsReported);
+        ADD_TEST(TST_FileIo::cancelWaitsForCompletion);
+#endif
+        ADD_TEST(TST_FileIo::backendRejectedWhileRunning);
+    }
+
+private:
+    // A temporary file filled with `size` bytes of a known pattern.
+    struct TempFile
+    {
+        std::FILE* file = nullptr;
+        int fd = -1;
+        explicit TempFile(size_t size)
+        {
+            file = std::tmpfile();
+#if defined(_WIN32)
+            fd = file ? ::_fileno(file) : -1;
+#else
+            fd = file ? ::fileno(file) : -1;
+#endif
+            std::vector<char> data(size);
+            for (size_t i = 0; i < size; ++i)
+                data[i] = static_cast<char>('a' + i % 26);
+            if (file && size > 0)
+            {
+                std::fwrite(data.data(), 1, size, file);
+                std::fflush(file);
+            }
+        }
+        ~TempFile()
+        {
+            if (file)
+                std::fclose(file);
+        }
+    };
+
+    TEST_FUNCTION(serviceCompletesEveryOp)
+    {
+        TEST_START;
+        TempFile temp(64 * 1024);
+        for (bool useIoUring : { true, false })
+        {
+            TaskGraph::Internal::FileIoService service;
+            service.setUseIoUring(useIoUring);
+            constexpr int ops = 1000;
+            std::vector<char> buffers(ops * 64);
+            std::atomic<int> done{0};
+            std::atomic<long> bytes{0};
+            for (int i = 0; i < ops; ++i)
+            {
+                service.submit(TaskGraph::Internal::FileIoService::Op::Read, temp.fd, &buffers[i * 64], 64,
+                               static_cast<uint64_t>(i) * 64, [&](long r) { bytes += r; ++done; });
+            }
+            TEST_ASSERT(TestHelpers::waitFor([&] { return done.load() == ops; }, std::chrono::seconds(5)));
+            TEST_ASSERT(bytes.load() == ops * 64);
+            TEST_ASSERT(service.getInFlightCount() == 0u);
+            TEST_ASSERT(buffers[64] == 'a' + 64 % 26);
+            if (!useIoUring)
+                TEST_ASSERT(service.getBackend() == TaskGraph::Internal::FileIoService::Backend::ThreadPool);
+            if (service.getBackend() == TaskGraph::Internal::FileIoService::Backend::IoUring)
+            {
+                // Entries beyond the ring's capacity overflow to the thread pool.
+                TEST_ASSERT(service.getSubmittedCount() >= 1u);
+                TEST_ASSERT(service.getSubmittedCount() <= static_cast<uint64_t>(ops));
+                TEST_ASSERT(service.getSubmitCalls() <= service.getSubmittedCount());
+            }
+        }
+    }
+
+    TEST_FUNCTION(stopWithReadsInFlight)
+    {
+        TEST_START;
+        // Destroyed right after submitting: whatever the ring and the pool still hold
+        // completes, and the destructor returns.
+        TempFile temp(64 * 1024);
+        constexpr int ops = 1000;
+        std::vector<char> buffers(ops * 64);
+        std::atomic<int> done{0};
+        {
+            TaskGraph::Internal::FileIoService service;
+            for (int i = 0; i < ops; ++i)
+            {
+                service.submit(TaskGraph::Internal::FileIoService::Op::Read, temp.fd, &buffers[i * 64], 64,
+                               static_cast<uint64_t>(i) * 64, [&done](long) { ++done; });
+            }
+        }
+        TEST_ASSERT(done.load() == ops);
+    }
+
+    TEST_FUNCTION(stopWhileSubmitting)
+    {
+        TEST_START;
+        // setUseIoUring stops the service each time. Submits racing with the stop
+        // end up in the pool or a restarted ring; every one completes and no stop hangs.
+        TempFile temp(64 * 1024);
+        constexpr int submitters = 4;
+        constexpr int opsEach = 2000;
+        std::vector<char> buffers(submitters * opsEach * 64);
+        std::atomic<int> done{0};
+        std::atomic<int> finished{0};
+        {
+            TaskGraph::Internal::FileIoService service;
+            std::vector<std::thread> threads;
+            for (int s = 0; s < submitters; ++s)
+            {
+                threads.emplace_back([&, s] {
+                    for (int i = 0; i < opsEach; ++i)
+                    {
+                        service.submit(TaskGraph::Internal::FileIoService::Op::Read, temp.fd, &buffers[(s * opsEach + i) * 64], 64,
+                                       static_cast<uint64_t>(i % 1024) * 64, [&done](long) { ++done; });
+                    }
+                    ++finished;
+                });
+            }
+            while (finished.load() < submitters)
+                service.setUseIoUring(true);
+            for (std::thread& t : threads)
+                t.join();
+        }
+        TEST_ASSERT(done.load() == submitters * opsEach);
+    }
+
+    TEST_FUNCTION(roundTripBothBackends)
+    {
+        TEST_START;
+        for (auto backend : { TaskGraph::TaskScheduler::FileIoBackend::Auto, TaskGraph::TaskScheduler::FileIoBackend::ThreadPool })
+        {
+            TempFile temp(0);
+            auto t = std::make_shared<TaskGraph::Task>("RoundTrip");
+            t->setCoroutineFunction([fd = temp.fd](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+                std::string out(256 * 1024, 'x');
+                for (size_t i = 0; i < out.size(); i += 4096)
+                    out[i] = static_cast<char>('0' + (i / 4096) % 10);
+                const long written = co_await ctx.writeAt(fd, out.data(), out.size(), 0);
+                co_await ctx.syncFile(fd);
+                std::string in(out.size(), '\0');
+                const long read = co_await ctx.readAt(fd, in.data(), in.size(), 0);
+                ctx.setResult(written == static_cast<long>(out.size()) && read == written && in == out);
+            });
+
+            TaskGraph::TaskScheduler scheduler(1);
+            TEST_ASSERT(scheduler.setFileIoBackend(backend));
+            TEST_ASSERT(scheduler.getFileIoBackend() == backend);
+            TEST_ASSERT(scheduler.getActiveFileIoBackend() == "none");
+            TEST_ASSERT(scheduler.addTask(t));
+            scheduler.runTasks();
+
+            TEST_ASSERT(t->isDone());
+            TEST_ASSERT(TaskGraph::getResultAs<bool>(*t));
+            if (backend == TaskGraph::TaskScheduler::FileIoBackend::ThreadPool)
+                TEST_ASSERT(scheduler.getActiveFileIoBackend() == "thread pool");
+            else
+                TEST_ASSERT(scheduler.getActiveFileIoBackend() != "none");
+        }
+    }
+
+    TEST_FUNCTION(continuationReadsToEof)
+    {
+        TEST_START;
+        constexpr size_t fileSize = 100 * 1000;
+        TempFile temp(fileSize);
+        auto buffer = std::make_shared<std::vector<char>>(16 * 1024);
+        auto total = std::make_shared<size_t>(0);
+        auto t = std::make_shared<TaskGraph::Task>("ReadChunks");
+        // Each continuation reads the next chunk until a read returns 0.
+        std::function<void(TaskGraph::TaskContext&, long)> onChunk;
+        onChunk = [&onChunk, buffer, total, fd = temp.fd](TaskGraph::TaskContext& ctx, long bytes) {
+            if (bytes <= 0)
+            {
+                ctx.setResult(*total);
+                return;
+            }
+            *total += static_cast<size_t>(bytes);
+            ctx.fileIoThen(TaskGraph::FileIoRequest::read(fd, buffer->data(), buffer->size(), *total), onChunk);
+        };
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            ctx.fileIoThen(TaskGraph::FileIoRequest::read(temp.fd, buffer->data(), buffer->size(), 0), onChunk);
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<size_t>(*t) == fileSize);
+    }
+
+#if defined(__linux__)
+    TEST_FUNCTION(errorsReported)
+    {
+        TEST_START;
+        // A descriptor that is certainly not open.
+        const int badFd = 1 << 20;
+        std::atomic<bool> thrown{false};
+        std::atomic<long> continuationResult{0};
+        auto co = std::make_shared<TaskGraph::Task>("Throws");
+        co->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            char c;
+            try
+            {
+                co_await ctx.readAt(badFd, &c, 1, 0);
+            }
+            catch (const std::runtime_error&)
+            {
+                thrown = true;
+            }
+        });
+        auto then = std::make_shared<TaskGraph::Task>("NegativeResult");
+        then->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            ctx.fileIoThen(TaskGraph::FileIoRequest::sync(badFd),
+                           [&](TaskGraph::TaskContext&, long r) { continuationResult = r; });
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(co));
+        TEST_ASSERT(scheduler.addTask(then));
+        scheduler.runTasks();
+
+        TEST_ASSERT(co->isDone());
+        TEST_ASSERT(thrown.load());
+        TEST_ASSERT(then->isDone());
+        TEST_ASSERT(continuationResult.load() < 0);
+    }
+
+    TEST_FUNCTION(cancelWaitsForCompletion)
+    {
+        TEST_START;
+        // A read on an empty pipe stays in flight until a byte arrives (io_uring only;
+        // pread cannot read a pipe).
+        int fds[2];
+        TEST_ASSERT(::pipe(fds) == 0);
+        std::atomic<bool> continued{false};
+        char byte = 0;
+        auto t = std::make_shared<TaskGraph::Task>("PipeRead");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            ctx.fileIoThen(TaskGraph::FileIoRequest::read(fds[0], &byte, 1, 0),
+                           [&](TaskGraph::TaskContext&, long) { continued = true; });
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(TestHelpers::waitFor([&] { return scheduler.getActiveFileIoBackend() != "none"; }, std::chrono::seconds(2)));
+        if (scheduler.getActiveFileIoBackend() == "io_uring")
+        {
+            TEST_ASSERT(TestHelpers::waitFor([&] { return scheduler.getStats().suspensions >= 1u; }, std::chrono::seconds(2)));
+            scheduler.cancel();
+            // The buffer is still owned by the kernel: the task must not end yet.
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            TEST_ASSERT(scheduler.isRunning());
+            TEST_ASSERT(t->getStatus() == TaskGraph::Task::Status::Running);
+            const char c = 'x';
+            (void)::write(fds[1], &c, 1);
+        }
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+        if (scheduler.getActiveFileIoBackend() == "io_uring")
+        {
+            TEST_ASSERT(byte == 'x');
+            TEST_ASSERT(!continued.load());
+            TEST_ASSERT(t->getStatus() == TaskGraph::Task::Status::Cancelled);
+        }
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+#endif
+
+    TEST_FUNCTION(backendRejectedWhileRunning)
+    {
+        TEST_START;
+        std::atomic<bool> release{false};
+        auto t = std::make_shared<TaskGraph::Task>("Hold");
+        t->setWorkFunction([&] {
+            while (!release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(!scheduler.setFileIoBackend(TaskGraph::TaskScheduler::FileIoBackend::ThreadPool));
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+        release = true;
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+        TEST_ASSERT(scheduler.getFileIoBackend() == TaskGraph::TaskScheduler::FileIoBackend::Auto);
+    }
+};
+
+TEST_INSTANTIATE(TST_FileIo);
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+class TST_ForkJoin : public UnitTest::Test
+{
+    TEST_CLASS(TST_ForkJoin)
+public:
+    TST_ForkJoin()
+        : Test("TST_ForkJoin")
+    {
+        ADD_TEST(TST_ForkJoin::childResultsInsideBody);
+        ADD_TEST(TST_ForkJoin::recursiveSumOnOneWorker);
+        ADD_TEST(TST_ForkJoin::recursiveSumWorkStealing);
+        ADD_TEST(TST_ForkJoin::recursiveSumWithoutThreads);
+        ADD_TEST(TST_ForkJoin::childrenDroppedAfterRun);
+        ADD_TEST(TST_ForkJoin::failedChildReported);
+        ADD_TEST(TST_ForkJoin::failedChildFailFast);
+        ADD_TEST(TST_ForkJoin::cancelDuringJoin);
+        ADD_TEST(TST_ForkJoin::invalidJoinRejected);
+    }
+
+private:
+    // Sum of [lo, hi), split in halves down to ranges of at most 4 values.
+    static long long parallelSum(TaskGraph::TaskContext& ctx, int lo, int hi)
+    {
+        if (hi - lo <= 4)
+        {
+            long long sum = 0;
+            for (int i = lo; i < hi; ++i)
+                sum += i;
+            return sum;
+        }
+        const int mid = lo + (hi - lo) / 2;
+        long long left = 0;
+        long long right = 0;
+        auto l = std::make_shared<TaskGraph::Task>("L");
+        l->setWorkFunction([&left, lo, mid](TaskGraph::TaskContext& c) { left = parallelSum(c, lo, mid); });
+        auto r = std::make_shared<TaskGraph::Task>("R");
+        r->setWorkFunction([&right, mid, hi](TaskGraph::TaskContext& c) { right = parallelSum(c, mid, hi); });
+        if (!ctx.spawnAndWait({ l, r }))
+            return -1;
+        return left + right;
+    }
+
+    static bool runRecursiveSum(TaskGraph::TaskScheduler& scheduler, int n)
+    {
+        long long result = 0;
+        auto root = std::make_shared<TaskGraph::Task>("Root");
+        root->setWorkFunction([&result, n](TaskGraph::TaskContext& ctx) { result = parallelSum(ctx, 0, n); });
+        if (!scheduler.addTask(root))
+            return false;
+        scheduler.runTasks();
+        return root->isDone() && result == static_cast<long long>(n) * (n - 1) / 2;
+    }
+
+    TEST_FUNCTION(childResultsInsideBody)
+    {
+        TEST_START;
+        auto a = std::make_shared<TaskGraph::Task>("A");
+        a->setWorkFunction([](TaskGraph::TaskContext& ctx) { ctx.setResult(20); });
+        auto b = std::make_shared<TaskGraph::Task>("B");
+        b->setWorkFunction([](TaskGraph::TaskContext& ctx) { ctx.setResult(22); });
+
+        std::atomic<bool> joined{false};
+        auto parent = std::make_shared<TaskGraph::Task>("Parent");
+        parent->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            joined = ctx.spawnAndWait({ a, b });
+            ctx.setResult(TaskGraph::getResultAs<int>(*a) + TaskGraph::getResultAs<int>(*b));
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(parent));
+        scheduler.runTasks();
+
+        TEST_ASSERT(joined.load());
+        TEST_ASSERT(parent->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*parent) == 42);
+        // The children ended with the run.
+        TEST_ASSERT(scheduler.getTotalTasks() == 1u);
+    }
+
+    TEST_FUNCTION(recursiveSumOnOneWorker)
+    {
+        TEST_START;
+        // With a blocking wait the only worker would deadlock on the first join.
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(runRecursiveSum(scheduler, 256));
+        TEST_ASSERT(scheduler.getStats().joinHelps > 0u);
+    }
+
+    TEST_FUNCTION(recursiveSumWorkStealing)
+    {
+        TEST_START;
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.setExecutionMode(TaskGraph::TaskScheduler::ExecutionMode::WorkStealing));
+        TEST_ASSERT(runRecursiveSum(scheduler, 1024));
+    }
+
+    TEST_FUNCTION(recursiveSumWithoutThreads)
+    {
+        TEST_START;
+        TaskGraph::TaskScheduler scheduler(0);
+        TEST_ASSERT(runRecursiveSum(scheduler, 128));
+    }
+
+    TEST_FUNCTION(childrenDroppedAfterRun)
+    {
+        TEST_START;
+        // The children capture their parent's stack frame: kept in the graph they
+        // would run again as roots of the next run, long after it is gone.
+        constexpr int n = 256;
+        long long result = 0;
+        auto root = std::make_shared<TaskGraph::Task>("Root");
+        root->setWorkFunction([&result](TaskGraph::TaskContext& ctx) { result = parallelSum(ctx, 0, n); });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(root));
+        for (int run = 0; run < 2; ++run)
+        {
+            result = 0;
+            scheduler.runTasks();
+            TEST_ASSERT(root->isDone());
+            TEST_ASSERT(result == static_cast<long long>(n) * (n - 1) / 2);
+            TEST_ASSERT(scheduler.getTotalTasks() == 1u);
+            // The compiled plan is reused.
+            TEST_ASSERT(scheduler.isCompiled());
+        }
+    }
+
+    TEST_FUNCTION(failedChildReported)
+    {
+        TEST_START;
+        auto bad = std::make_shared<TaskGraph::Task>("Bad");
+        bad->setWorkFunction([] { throw std::runtime_error("boom"); });
+        auto good = std::make_shared<TaskGraph::Task>("Good");
+        good->setWorkFunction([] {});
+
+        std::atomic<int> joined{-1};
+        auto parent = std::make_shared<TaskGraph::Task>("Parent");
+        parent->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            joined = ctx.spawnAndWait({ bad, good }) ? 1 : 0;
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        scheduler.setFailurePolicy(TaskGraph::TaskScheduler::FailurePolicy::ContinueOthers);
+        TEST_ASSERT(scheduler.addTask(parent));
+        scheduler.runTasks();
+
+        TEST_ASSERT(joined.load() == 0);
+        TEST_ASSERT(parent->isDone());
+        TEST_ASSERT(bad->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(good->isDone());
+    }
+
+    TEST_FUNCTION(failedChildFailFast)
+    {
+        TEST_START;
+        // One worker: the waiter runs Bad first, Other is still queued when the run aborts.
+        auto bad = std::make_shared<TaskGraph::Task>("Bad");
+        bad->setWorkFunction([] { throw std::runtime_error("boom"); });
+        auto other = std::make_shared<TaskGraph::Task>("Other");
+        other->setWorkFunction([] {});
+
+        std::atomic<int> joined{-1};
+        auto parent = std::make_shared<TaskGraph::Task>("Parent");
+        parent->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            joined = ctx.spawnAndWait({ bad, other }) ? 1 : 0;
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(parent));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+
+        TEST_ASSERT(joined.load() == 0);
+        TEST_ASSERT(bad->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(other->getStatus() == TaskGraph::Task::Status::Cancelled || other->isDone());
+    }
+
+    TEST_FUNCTION(cancelDuringJoin)
+    {
+        TEST_START;
+        std::atomic<bool> started{false};
+        auto slow = std::make_shared<TaskGraph::Task>("Slow");
+        slow->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            started = true;
+            TestHelpers::waitFor([&] { return ctx.isCancelRequested(); }, std::chrono::seconds(2));
+        });
+        auto other = std::make_shared<TaskGraph::Task>("Other");
+        other->setWorkFunction([] {});
+
+        std::atomic<int> joined{-1};
+        auto parent = std::make_shared<TaskGraph::Task>("Parent");
+        parent->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            joined = ctx.spawnAndWait({ slow, other }) ? 1 : 0;
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(parent));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(TestHelpers::waitFor([&] { return started.load(); }, std::chrono::seconds(2)));
+        scheduler.cancel();
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+
+        TEST_ASSERT(joined.load() == 0);
+        TEST_ASSERT(slow->isCancelRequested());
+        TEST_ASSERT(other->getStatus() == TaskGraph::Task::Status::Cancelled || other->isDone());
+    }
+
+    TEST_FUNCTION(invalidJoinRejected)
+    {
+        TEST_START;
+        auto stranger = std::make_shared<TaskGraph::Task>("Stranger");
+        auto child = std::make_shared<TaskGraph::Task>("Child");
+        child->setWorkFunction([] {});
+
+        // Reaches the parent in two steps: Parent -> Child -> Grandchild.
+        auto grandchild = std::make_shared<TaskGraph::Task>("Grandchild");
+        grandchild->setWorkFunction([] {});
+
+        std::atomic<int> untracked{-1};
+        std::atomic<int> dependent{-1};
+        std::atomic<int> indirect{-1};
+        auto parent = std::make_shared<TaskGraph::Task>("Parent");
+        TEST_ASSERT(child->addDependency(parent));
+        TEST_ASSERT(grandchild->addDependency(child));
+        parent->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            untracked = ctx.join({ stranger }) ? 1 : 0;
+            dependent = ctx.join({ child }) ? 1 : 0;
+            indirect = ctx.join({ grandchild }) ? 1 : 0;
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(parent));
+        TEST_ASSERT(scheduler.addTask(child));
+        TEST_ASSERT(scheduler.addTask(grandchild));
+        scheduler.runTasks();
+
+        TEST_ASSERT(untracked.load() == 0);
+        TEST_ASSERT(dependent.load() == 0);
+        TEST_ASSERT(indirect.load() == 0);
+        TEST_ASSERT(parent->isDone());
+        TEST_ASSERT(child->isDone());
+        TEST_ASSERT(grandchild->isDone());
+    }
+};
+
+TEST_INSTANTIATE(TST_ForkJoin);
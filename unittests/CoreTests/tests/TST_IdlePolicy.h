@@ -0,0 +1,156 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_IdlePolicy : public UnitTest::Test
+{
+    TEST_CLASS(TST_IdlePolicy)
+public:
+    TST_IdlePolicy()
+        : Test("TST_IdlePolicy")
+    {
+        ADD_TEST(TST_IdlePolicy::policyRoundTrip);
+        ADD_TEST(TST_IdlePolicy::everyPolicyRunsLadder);
+        ADD_TEST(TST_IdlePolicy::spinningPicksUpWork);
+        ADD_TEST(TST_IdlePolicy::busyPollParksBetweenRuns);
+        ADD_TEST(TST_IdlePolicy::changeRejectedWhileRunning);
+    }
+
+private:
+    using IdlePolicy = TaskGraph::TaskScheduler::IdlePolicy;
+    using ExecutionMode = TaskGraph::TaskScheduler::ExecutionMode;
+
+    // `levels` levels of two tasks; both tasks of a level depend on both tasks of
+    // the previous one, so every level hands work over to a second worker.
+    static std::vector<std::shared_ptr<TaskGraph::Task>> ladder(int levels, std::atomic<int>& counter)
+    {
+        std::vector<std::shared_ptr<TaskGraph::Task>> tasks;
+        for (int i = 0; i < levels * 2; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("L" + std::to_string(i));
+            t->setWorkFunction([&counter] { counter.fetch_add(1); });
+            tasks.push_back(t);
+        }
+        for (int l = levels - 1; l > 0; --l)
+        {
+            for (int k = 0; k < 2; ++k)
+            {
+                tasks[l * 2 + k]->addDependency(tasks[(l - 1) * 2]);
+                tasks[l * 2 + k]->addDependency(tasks[(l - 1) * 2 + 1]);
+            }
+        }
+        return tasks;
+    }
+
+    TEST_FUNCTION(policyRoundTrip)
+    {
+        TEST_START;
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.getIdlePolicy() == IdlePolicy::Blocking);
+        TEST_ASSERT(scheduler.getIdleSpinDuration().count() == 50);
+        TEST_ASSERT(scheduler.setIdlePolicy(IdlePolicy::SpinThenPark));
+        TEST_ASSERT(scheduler.getIdlePolicy() == IdlePolicy::SpinThenPark);
+        TEST_ASSERT(scheduler.setIdleSpinDuration(std::chrono::microseconds(200)));
+        TEST_ASSERT(scheduler.getIdleSpinDuration().count() == 200);
+    }
+
+    TEST_FUNCTION(everyPolicyRunsLadder)
+    {
+        TEST_START;
+        for (auto policy : { IdlePolicy::Blocking, IdlePolicy::SpinThenPark, IdlePolicy::BusyPoll })
+        {
+            for (auto mode : { ExecutionMode::SharedQueue, ExecutionMode::WorkStealing })
+            {
+                std::atomic<int> counter{0};
+                TaskGraph::TaskScheduler scheduler(3);
+                TEST_ASSERT(scheduler.setIdlePolicy(policy));
+                TEST_ASSERT(scheduler.setExecutionMode(mode));
+                for (const auto& t : ladder(100, counter))
+                    TEST_ASSERT(scheduler.addTask(t));
+                scheduler.runTasks();
+                scheduler.runTasks();
+                TEST_ASSERT(counter.load() == 400);
+            }
+        }
+    }
+
+    TEST_FUNCTION(spinningPicksUpWork)
+    {
+        TEST_START;
+        // "Quick" finishes at once and leaves its worker spinning (budget 50 ms)
+        // while "Slow" sleeps. Slow then unblocks two sleeping tasks: its own worker
+        // takes one, the spinning worker picks up the other without parking.
+        auto sleeper = [](const std::string& name, int ms) {
+            auto t = std::make_shared<TaskGraph::Task>(name);
+            t->setWorkFunction([ms] { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); });
+            return t;
+        };
+        auto slow = sleeper("Slow", 5);
+        auto quick = sleeper("Quick", 0);
+        auto next1 = sleeper("Next1", 2);
+        auto next2 = sleeper("Next2", 2);
+        TEST_ASSERT(next1->addDependency(slow));
+        TEST_ASSERT(next2->addDependency(slow));
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.setIdlePolicy(IdlePolicy::SpinThenPark));
+        TEST_ASSERT(scheduler.setIdleSpinDuration(std::chrono::milliseconds(50)));
+        for (const auto& t : { slow, quick, next1, next2 })
+            TEST_ASSERT(scheduler.addTask(t));
+        for (int i = 0; i < 3; ++i)
+            scheduler.runTasks();
+
+        const TaskGraph::TaskScheduler::Stats stats = scheduler.getStats();
+        TEST_ASSERT(stats.tasksExecuted == 12u);
+        TEST_ASSERT(stats.spinHits > 0u);
+    }
+
+    TEST_FUNCTION(busyPollParksBetweenRuns)
+    {
+        TEST_START;
+        std::atomic<int> counter{0};
+        const size_t workers = 2;
+        TaskGraph::TaskScheduler scheduler(workers);
+        TEST_ASSERT(scheduler.setIdlePolicy(IdlePolicy::BusyPoll));
+        for (const auto& t : ladder(20, counter))
+            TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+        TEST_ASSERT(counter.load() == 40);
+
+        // Once the run is over the pollers stop burning CPU and park.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (scheduler.getStats().parks < workers && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        TEST_ASSERT(scheduler.getStats().parks >= workers);
+    }
+
+    TEST_FUNCTION(changeRejectedWhileRunning)
+    {
+        TEST_START;
+        std::atomic<bool> release{false};
+        auto t = std::make_shared<TaskGraph::Task>("Hold");
+        t->setWorkFunction([&release] {
+            while (!release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(!scheduler.setIdlePolicy(IdlePolicy::BusyPoll));
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+        TEST_ASSERT(!scheduler.setIdleSpinDuration(std::chrono::microseconds(10)));
+        TEST_ASSERT(scheduler.getIdlePolicy() == IdlePolicy::Blocking);
+        release.store(true);
+        while (scheduler.isRunning())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+};
+
+TEST_INSTANTIATE(TST_IdlePolicy);
@@ -0,0 +1,238 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include "IoReactor.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+class TST_IoReactor : public UnitTest::Test
+{
+    TEST_CLASS(TST_IoReactor)
+public:
+    TST_IoReactor()
+        : Test("TST_IoReactor")
+    {
+        ADD_TEST(TST_IoReactor::firesWhenReadable);
+        ADD_TEST(TST_IoReactor::unwatchPreventsFiring);
+        ADD_TEST(TST_IoReactor::awaitFreesWorker);
+        ADD_TEST(TST_IoReactor::timeoutWhileWaiting);
+        ADD_TEST(TST_IoReactor::cancelWhileWaiting);
+        ADD_TEST(TST_IoReactor::continuationChain);
+        ADD_TEST(TST_IoReactor::regularFileRejected);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Both ends closed on scope exit.
+    struct Pipe
+    {
+        int fds[2] = { -1, -1 };
+        Pipe() { (void)::pipe(fds); }
+        ~Pipe()
+        {
+            for (int fd : fds)
+                if (fd >= 0)
+                    ::close(fd);
+        }
+        int readEnd() const { return fds[0]; }
+        int writeEnd() const { return fds[1]; }
+        void write(char c) const { (void)::write(fds[1], &c, 1); }
+    };
+
+    TEST_FUNCTION(firesWhenReadable)
+    {
+        TEST_START;
+        Pipe pipe;
+        TaskGraph::Internal::IoReactor reactor;
+        std::atomic<int> events{0};
+        std::atomic<int> calls{0};
+        const auto id = reactor.watch(pipe.readEnd(), TaskGraph::Internal::IoReactor::Readable,
+            [&](int ready) { events = ready; ++calls; });
+        // Two watches on the same fd fire independently.
+        std::atomic<int> second{0};
+        reactor.watch(pipe.readEnd(), TaskGraph::Internal::IoReactor::Readable, [&](int) { ++second; });
+        TEST_ASSERT(id != TaskGraph::Internal::IoReactor::invalidWatch);
+        TEST_ASSERT(reactor.isThreadRunning());
+        TEST_ASSERT(reactor.getWatchCount() == 2u);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        TEST_ASSERT(calls.load() == 0);
+        pipe.write('x');
+        TEST_ASSERT(TestHelpers::waitFor([&] { return calls.load() == 1 && second.load() == 1; }, std::chrono::seconds(2)));
+        TEST_ASSERT(events.load() & TaskGraph::Internal::IoReactor::Readable);
+        // One-shot: the watches are gone and cannot be removed again.
+        TEST_ASSERT(TestHelpers::waitFor([&] { return reactor.getWatchCount() == 0u; }, std::chrono::seconds(1)));
+        TEST_ASSERT(!reactor.unwatch(id));
+    }
+
+    TEST_FUNCTION(unwatchPreventsFiring)
+    {
+        TEST_START;
+        Pipe pipe;
+        TaskGraph::Internal::IoReactor reactor;
+        std::atomic<int> calls{0};
+        const auto id = reactor.watch(pipe.readEnd(), TaskGraph::Internal::IoReactor::Readable, [&](int) { ++calls; });
+        TEST_ASSERT(reactor.unwatch(id));
+        TEST_ASSERT(reactor.getWatchCount() == 0u);
+        pipe.write('x');
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        TEST_ASSERT(calls.load() == 0);
+        TEST_ASSERT(!reactor.unwatch(TaskGraph::Internal::IoReactor::invalidWatch));
+    }
+
+    TEST_FUNCTION(awaitFreesWorker)
+    {
+        TEST_START;
+        Pipe pipe;
+        std::atomic<bool> writerRanFirst{false};
+        auto reader = std::make_shared<TaskGraph::Task>("Reader");
+        reader->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            const int ready = co_await ctx.waitForFd(pipe.readEnd(), TaskGraph::TaskContext::Readable);
+            char c = 0;
+            if (ready & TaskGraph::TaskContext::Readable)
+                (void)::read(pipe.readEnd(), &c, 1);
+            ctx.setResult(static_cast<int>(c));
+        });
+        // No edge: on a single worker the writer only runs if the reader gave the worker back.
+        auto writer = std::make_shared<TaskGraph::Task>("Writer");
+        writer->setWorkFunction([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            writerRanFirst = reader->getStatus() == TaskGraph::Task::Status::Running;
+            pipe.write('z');
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(reader));
+        TEST_ASSERT(scheduler.addTask(writer));
+        scheduler.runTasks();
+
+        TEST_ASSERT(reader->isDone());
+        TEST_ASSERT(writer->isDone());
+        TEST_ASSERT(writerRanFirst.load());
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*reader) == 'z');
+        TEST_ASSERT(scheduler.getStats().suspensions >= 1u);
+    }
+
+    TEST_FUNCTION(timeoutWhileWaiting)
+    {
+        TEST_START;
+        Pipe pipe;
+        auto t = std::make_shared<TaskGraph::Task>("NeverReadable");
+        t->setTimeout(std::chrono::milliseconds(50));
+        t->setCoroutineFunction([&pipe](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            co_await ctx.waitForFd(pipe.readEnd(), TaskGraph::TaskContext::Readable);
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        const auto start = Clock::now();
+        scheduler.runTasks();
+
+        TEST_ASSERT(Clock::now() - start < std::chrono::seconds(2));
+        TEST_ASSERT(t->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(t->getLastError() == QStringLiteral("timeout"));
+    }
+
+    TEST_FUNCTION(cancelWhileWaiting)
+    {
+        TEST_START;
+        Pipe pipe;
+        std::atomic<bool> continued{false};
+        auto t = std::make_shared<TaskGraph::Task>("WaitThen");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            ctx.waitForFdThen(pipe.readEnd(), TaskGraph::TaskContext::Readable,
+                [&](TaskGraph::TaskContext&, int) { continued = true; });
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(TestHelpers::waitFor([&] { return scheduler.getStats().suspensions >= 1u; }, std::chrono::seconds(2)));
+        scheduler.cancel();
+
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+        TEST_ASSERT(!continued.load());
+        TEST_ASSERT(t->getStatus() == TaskGraph::Task::Status::Cancelled);
+    }
+
+    TEST_FUNCTION(continuationChain)
+    {
+        TEST_START;
+        Pipe pipe;
+        std::atomic<int> bytes{0};
+        auto t = std::make_shared<TaskGraph::Task>("ReadTwice");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            const int fd = pipe.readEnd();
+            ctx.waitForFdThen(fd, TaskGraph::TaskContext::Readable, [&, fd](TaskGraph::TaskContext& c, int) {
+                char a = 0;
+                bytes += static_cast<int>(::read(fd, &a, 1));
+                c.waitForFdThen(fd, TaskGraph::TaskContext::Readable, [&, fd, a](TaskGraph::TaskContext& c2, int) {
+                    char b = 0;
+                    bytes += static_cast<int>(::read(fd, &b, 1));
+                    c2.setResult(std::string{ a, b });
+                });
+            });
+        });
+        auto writer = std::make_shared<TaskGraph::Task>("Writer");
+        writer->setWorkFunction([&] {
+            pipe.write('o');
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            pipe.write('k');
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        TEST_ASSERT(scheduler.addTask(writer));
+        scheduler.runTasks();
+
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(bytes.load() == 2);
+        TEST_ASSERT(TaskGraph::getResultAs<std::string>(*t) == "ok");
+    }
+
+    TEST_FUNCTION(regularFileRejected)
+    {
+        TEST_START;
+        // epoll cannot watch regular files: the await throws instead of hanging.
+        std::FILE* file = std::tmpfile();
+        TEST_ASSERT(file != nullptr);
+        if (!file) return;
+        const int fd = ::fileno(file);
+
+        std::atomic<bool> caught{false};
+        auto t = std::make_shared<TaskGraph::Task>("RegularFile");
+        t->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            try
+            {
+                co_await ctx.waitForFd(fd, TaskGraph::TaskContext::Readable);
+            }
+            catch (const std::runtime_error&)
+            {
+                caught = true;
+            }
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+        std::fclose(file);
+
+        TEST_ASSERT(caught.load());
+        TEST_ASSERT(t->isDone());
+    }
+};
+
+TEST_INSTANTIATE(TST_IoReactor);
+
+#endif
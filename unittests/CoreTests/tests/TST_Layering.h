@@ -0,0 +1,100 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+class TST_Layering : public UnitTest::Test
+{
+    TEST_CLASS(TST_Layering)
+public:
+    TST_Layering()
+        : Test("TST_Layering")
+    {
+        ADD_TEST(TST_Layering::longestPathDecidesLayer);
+        ADD_TEST(TST_Layering::deepChain);
+        ADD_TEST(TST_Layering::wideFan);
+    }
+
+private:
+    static bool contains(const TaskGraph::TaskList& layer, const std::shared_ptr<TaskGraph::Task>& t)
+    {
+        return std::find(layer.begin(), layer.end(), t) != layer.end();
+    }
+
+    TEST_FUNCTION(longestPathDecidesLayer)
+    {
+        TEST_START;
+        // A -> B -> C and A -> C: C must wait for B's layer. D is independent.
+        auto a = std::make_shared<TaskGraph::Task>("A");
+        auto b = std::make_shared<TaskGraph::Task>("B");
+        auto c = std::make_shared<TaskGraph::Task>("C");
+        auto d = std::make_shared<TaskGraph::Task>("D");
+        TEST_ASSERT(b->addDependency(a));
+        TEST_ASSERT(c->addDependency(b));
+        TEST_ASSERT(c->addDependency(a));
+
+        TaskGraph::TaskScheduler scheduler(0);
+        TEST_ASSERT(scheduler.addTask(c));
+        TEST_ASSERT(scheduler.addTask(b));
+        TEST_ASSERT(scheduler.addTask(a));
+        TEST_ASSERT(scheduler.addTask(d));
+
+        auto layers = scheduler.getTaskGraph();
+        TEST_ASSERT(layers.size() == 3u);
+        TEST_ASSERT(layers[0].size() == 2u);
+        TEST_ASSERT(contains(layers[0], a));
+        TEST_ASSERT(contains(layers[0], d));
+        TEST_ASSERT(layers[1].size() == 1u && contains(layers[1], b));
+        TEST_ASSERT(layers[2].size() == 1u && contains(layers[2], c));
+    }
+
+    TEST_FUNCTION(deepChain)
+    {
+        TEST_START;
+        const size_t depth = 20000;
+        TaskGraph::TaskScheduler scheduler(0);
+        std::vector<std::shared_ptr<TaskGraph::Task>> chain;
+        chain.reserve(depth);
+        for (size_t i = 0; i < depth; ++i)
+            chain.push_back(std::make_shared<TaskGraph::Task>("C" + std::to_string(i)));
+        // Wired back to front: addDependency's cycle check then never walks the chain.
+        for (size_t i = depth - 1; i > 0; --i)
+            TEST_ASSERT(chain[i]->addDependency(chain[i - 1]));
+        // Add in reverse so the order of m_allTasks does not match the layering.
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+            TEST_ASSERT(scheduler.addTask(*it));
+
+        auto layers = scheduler.getTaskGraph();
+        TEST_ASSERT(layers.size() == depth);
+        TEST_ASSERT(layers.front().size() == 1u && layers.front()[0] == chain.front());
+        TEST_ASSERT(layers.back().size() == 1u && layers.back()[0] == chain.back());
+    }
+
+    TEST_FUNCTION(wideFan)
+    {
+        TEST_START;
+        auto root = std::make_shared<TaskGraph::Task>("Root");
+        auto sink = std::make_shared<TaskGraph::Task>("Sink");
+        TaskGraph::TaskScheduler scheduler(0);
+        TEST_ASSERT(scheduler.addTask(root));
+        TEST_ASSERT(scheduler.addTask(sink));
+        for (int i = 0; i < 5000; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("F" + std::to_string(i));
+            TEST_ASSERT(t->addDependency(root));
+            TEST_ASSERT(sink->addDependency(t));
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+
+        auto layers = scheduler.getTaskGraph();
+        TEST_ASSERT(layers.size() == 3u);
+        TEST_ASSERT(layers[0].size() == 1u);
+        TEST_ASSERT(layers[1].size() == 5000u);
+        TEST_ASSERT(layers[2].size() == 1u && layers[2][0] == sink);
+    }
+};
+
+TEST_INSTANTIATE(TST_Layering);
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_MemoryBudget : public UnitTest::Test
+{
+    TEST_CLASS(TST_MemoryBudget)
+public:
+    TST_MemoryBudget()
+        : Test("TST_MemoryBudget")
+    {
+        ADD_TEST(TST_MemoryBudget::budgetLimitsRunningEstimates);
+        ADD_TEST(TST_MemoryBudget::oversizedEstimateRunsAlone);
+        ADD_TEST(TST_MemoryBudget::unestimatedTasksNotThrottled);
+        ADD_TEST(TST_MemoryBudget::peakMeasuredWithoutBudget);
+        ADD_TEST(TST_MemoryBudget::budgetRejectedWhileRunning);
+    }
+
+private:
+    // Tracks the sum of the estimates of the bodies running at once.
+    struct Footprint
+    {
+        std::atomic<uint64_t> now{0};
+        std::atomic<uint64_t> max{0};
+        void enter(uint64_t bytes)
+        {
+            const uint64_t n = now += bytes;
+            uint64_t seen = max.load();
+            while (n > seen && !max.compare_exchange_weak(seen, n)) {}
+        }
+        void leave(uint64_t bytes) { now -= bytes; }
+    };
+
+    TEST_FUNCTION(budgetLimitsRunningEstimates)
+    {
+        TEST_START;
+        Footprint memory;
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.setMemoryBudget(100));
+        TEST_ASSERT(scheduler.getMemoryBudget() == 100u);
+        std::vector<std::shared_ptr<TaskGraph::Task>> tasks;
+        for (int i = 0; i < 6; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Load" + std::to_string(i));
+            t->setMemoryEstimate(40);
+            t->setWorkFunction([&memory] {
+                memory.enter(40);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                memory.leave(40);
+            });
+            tasks.push_back(t);
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        scheduler.runTasks();
+
+        for (const auto& t : tasks)
+            TEST_ASSERT(t->isDone());
+        TEST_ASSERT(memory.max.load() == 80u);
+        TEST_ASSERT(scheduler.getStats().peakMemoryInUse == 80u);
+        TEST_ASSERT(scheduler.getMemoryInUse() == 0u);
+        TEST_ASSERT(scheduler.getStats().resourceWaits >= 1u);
+
+        scheduler.resetStats();
+        TEST_ASSERT(scheduler.getStats().peakMemoryInUse == 0u);
+    }
+
+    TEST_FUNCTION(oversizedEstimateRunsAlone)
+    {
+        TEST_START;
+        Footprint memory;
+        std::atomic<bool> bigOverlapped{false};
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.setMemoryBudget(100));
+        auto big = std::make_shared<TaskGraph::Task>("Big");
+        big->setMemoryEstimate(1000);
+        big->setWorkFunction([&] {
+            memory.enter(1000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (memory.now.load() != 1000u)
+                bigOverlapped = true;
+            memory.leave(1000);
+        });
+        TEST_ASSERT(scheduler.addTask(big));
+        std::vector<std::shared_ptr<TaskGraph::Task>> small;
+        for (int i = 0; i < 4; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Small" + std::to_string(i));
+            t->setMemoryEstimate(30);
+            t->setWorkFunction([&memory] {
+                memory.enter(30);
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                memory.leave(30);
+            });
+            small.push_back(t);
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        scheduler.runTasks();
+
+        TEST_ASSERT(big->isDone());
+        for (const auto& t : small)
+            TEST_ASSERT(t->isDone());
+        TEST_ASSERT(!bigOverlapped.load());
+        // The oversized task counts as the whole budget.
+        TEST_ASSERT(scheduler.getStats().peakMemoryInUse == 100u);
+    }
+
+    TEST_FUNCTION(unestimatedTasksNotThrottled)
+    {
+        TEST_START;
+        // The holder fills the budget until a task without an estimate releases it.
+        std::atomic<bool> released{false};
+        std::atomic<bool> sawRelease{false};
+        auto holder = std::make_shared<TaskGraph::Task>("Holder");
+        holder->setMemoryEstimate(100);
+        holder->setWorkFunction([&] {
+            sawRelease = TestHelpers::waitFor([&] { return released.load(); }, std::chrono::seconds(2));
+        });
+        auto unestimated = std::make_shared<TaskGraph::Task>("Unestimated");
+        unestimated->setWorkFunction([&] { released = true; });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.setMemoryBudget(100));
+        TEST_ASSERT(scheduler.addTask(holder));
+        TEST_ASSERT(scheduler.addTask(unestimated));
+        scheduler.runTasks();
+
+        TEST_ASSERT(holder->isDone());
+        TEST_ASSERT(unestimated->isDone());
+        TEST_ASSERT(sawRelease.load());
+        TEST_ASSERT(scheduler.getStats().resourceWaits == 0u);
+    }
+
+    TEST_FUNCTION(peakMeasuredWithoutBudget)
+    {
+        TEST_START;
+        // Four tasks that only finish once all four run at the same time.
+        constexpr int count = 4;
+        std::atomic<int> arrived{0};
+        std::atomic<int> met{0};
+        TaskGraph::TaskScheduler scheduler(count);
+        TEST_ASSERT(scheduler.getMemoryBudget() == 0u);
+        std::vector<std::shared_ptr<TaskGraph::Task>> tasks;
+        for (int i = 0; i < count; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Barrier" + std::to_string(i));
+            t->setMemoryEstimate(uint64_t(1) << 30);
+            t->setWorkFunction([&] {
+                ++arrived;
+                if (TestHelpers::waitFor([&] { return arrived.load() == count; }, std::chrono::seconds(2)))
+                    ++met;
+            });
+            tasks.push_back(t);
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        scheduler.runTasks();
+
+        TEST_ASSERT(met.load() == count);
+        TEST_ASSERT(scheduler.getStats().peakMemoryInUse == uint64_t(count) << 30);
+        TEST_ASSERT(scheduler.getStats().resourceWaits == 0u);
+    }
+
+    TEST_FUNCTION(budgetRejectedWhileRunning)
+    {
+        TEST_START;
+        std::atomic<bool> release{false};
+        auto t = std::make_shared<TaskGraph::Task>("Hold");
+        t->setMemoryEstimate(64);
+        t->setWorkFunction([&] {
+            while (!release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setMemoryBudget(1024));
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(TestHelpers::waitFor([&] { return scheduler.getMemoryInUse() == 64u; }, std::chrono::seconds(2)));
+        TEST_ASSERT(!scheduler.setMemoryBudget(16));
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+        release = true;
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+        TEST_ASSERT(scheduler.getMemoryBudget() == 1024u);
+        TEST_ASSERT(scheduler.getMemoryInUse() == 0u);
+        TEST_ASSERT(scheduler.setMemoryBudget(0));
+        TEST_ASSERT(scheduler.getMemoryBudget() == 0u);
+    }
+};
+
+TEST_INSTANTIATE(TST_MemoryBudget);
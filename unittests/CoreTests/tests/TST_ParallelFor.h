@@ -0,0 +1,188 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_ParallelFor : public UnitTest::Test
+{
+    TEST_CLASS(TST_ParallelFor)
+public:
+    TST_ParallelFor()
+        : Test("TST_ParallelFor")
+    {
+        ADD_TEST(TST_ParallelFor::coversRangeOnce);
+        ADD_TEST(TST_ParallelFor::workersHelp);
+        ADD_TEST(TST_ParallelFor::reduceInIndexOrder);
+        ADD_TEST(TST_ParallelFor::cancelStopsChunks);
+        ADD_TEST(TST_ParallelFor::chunkExceptionFailsTask);
+        ADD_TEST(TST_ParallelFor::withoutThreads);
+    }
+
+private:
+    TEST_FUNCTION(coversRangeOnce)
+    {
+        TEST_START;
+        const size_t n = 100000;
+        std::vector<std::atomic<int>> hits(n);
+        std::atomic<bool> complete{false};
+        auto t = std::make_shared<TaskGraph::Task>("Loop");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            complete = ctx.parallelFor(0, n, 0, [&hits](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i)
+                    hits[i].fetch_add(1);
+            });
+        });
+
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(complete.load());
+        TEST_ASSERT(t->isDone());
+        bool once = true;
+        for (const auto& h : hits)
+            once = once && h.load() == 1;
+        TEST_ASSERT(once);
+        // The loop is part of its task, not a set of graph nodes.
+        TEST_ASSERT(scheduler.getTotalTasks() == 1u);
+        TEST_ASSERT(scheduler.getProgress() == 100);
+    }
+
+    TEST_FUNCTION(workersHelp)
+    {
+        TEST_START;
+        std::mutex idsMutex;
+        std::set<std::thread::id> ids;
+        auto t = std::make_shared<TaskGraph::Task>("Loop");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            ctx.parallelFor(0, 32, 1, [&](size_t, size_t) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                std::lock_guard<std::mutex> lock(idsMutex);
+                ids.insert(std::this_thread::get_id());
+            });
+        });
+
+        TaskGraph::TaskScheduler scheduler(3);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(ids.size() >= 2u);
+        TEST_ASSERT(scheduler.getStats().loopHelps > 0u);
+    }
+
+    TEST_FUNCTION(reduceInIndexOrder)
+    {
+        TEST_START;
+        long long sum = 0;
+        std::string digits;
+        auto t = std::make_shared<TaskGraph::Task>("Reduce");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            sum = ctx.parallelReduce(size_t(1), size_t(100001), 0, 0LL,
+                [](size_t b, size_t e) {
+                    long long s = 0;
+                    for (size_t i = b; i < e; ++i)
+                        s += static_cast<long long>(i);
+                    return s;
+                },
+                [](long long a, long long b) { return a + b; });
+            digits = ctx.parallelReduce(size_t(0), size_t(40), 3, std::string(),
+                [](size_t b, size_t e) {
+                    std::string s;
+                    for (size_t i = b; i < e; ++i)
+                        s += static_cast<char>('0' + i % 10);
+                    return s;
+                },
+                [](std::string a, std::string b) { return a + b; });
+        });
+
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        std::string expected;
+        for (size_t i = 0; i < 40; ++i)
+            expected += static_cast<char>('0' + i % 10);
+        TEST_ASSERT(sum == 100000LL * 100001LL / 2);
+        TEST_ASSERT(digits == expected);
+    }
+
+    TEST_FUNCTION(cancelStopsChunks)
+    {
+        TEST_START;
+        TaskGraph::TaskScheduler scheduler(2);
+        std::atomic<int> ran{0};
+        std::atomic<int> complete{-1};
+        auto t = std::make_shared<TaskGraph::Task>("Loop");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            complete = ctx.parallelFor(0, 1000, 1, [&](size_t b, size_t) {
+                if (b == 10)
+                    scheduler.cancel();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                ++ran;
+            }) ? 1 : 0;
+        });
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(complete.load() == 0);
+        TEST_ASSERT(ran.load() < 1000);
+    }
+
+    TEST_FUNCTION(chunkExceptionFailsTask)
+    {
+        TEST_START;
+        std::atomic<int> ran{0};
+        auto t = std::make_shared<TaskGraph::Task>("Loop");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            ctx.parallelFor(0, 1000, 1, [&](size_t b, size_t) {
+                if (b == 3)
+                    throw std::runtime_error("bad chunk");
+                ++ran;
+            });
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(t->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(t->getLastError().contains("bad chunk"));
+        TEST_ASSERT(ran.load() < 999);
+    }
+
+    TEST_FUNCTION(withoutThreads)
+    {
+        TEST_START;
+        long long sum = 0;
+        auto t = std::make_shared<TaskGraph::Task>("Reduce");
+        t->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            sum = ctx.parallelReduce(size_t(0), size_t(1000), 7, 0LL,
+                [](size_t b, size_t e) {
+                    long long s = 0;
+                    for (size_t i = b; i < e; ++i)
+                        s += static_cast<long long>(i);
+                    return s;
+                },
+                [](long long a, long long b) { return a + b; });
+        });
+
+        TaskGraph::TaskScheduler scheduler(0);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(sum == 999LL * 1000LL / 2);
+        TEST_ASSERT(scheduler.getStats().loopHelps == 0u);
+    }
+};
+
+TEST_INSTANTIATE(TST_ParallelFor);
@@ -0,0 +1,165 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+class TST_ProcessTask : public UnitTest::Test
+{
+    TEST_CLASS(TST_ProcessTask)
+public:
+    TST_ProcessTask()
+        : Test("TST_ProcessTask")
+    {
+        ADD_TEST(TST_ProcessTask::capturesStdout);
+        ADD_TEST(TST_ProcessTask::exitCodeFails);
+        ADD_TEST(TST_ProcessTask::missingProgramFails);
+        ADD_TEST(TST_ProcessTask::largeStderrDoesNotStall);
+        ADD_TEST(TST_ProcessTask::manyChildrenOneWorker);
+        ADD_TEST(TST_ProcessTask::timeoutKillsChild);
+        ADD_TEST(TST_ProcessTask::cancelKillsChild);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static std::shared_ptr<TaskGraph::ProcessTask> shell(const std::string& name, const std::string& script)
+    {
+        return std::make_shared<TaskGraph::ProcessTask>(name, "sh", std::vector<std::string>{ "-c", script });
+    }
+
+    TEST_FUNCTION(capturesStdout)
+    {
+        TEST_START;
+        auto p = shell("Echo", "echo hello; echo world");
+        p->setCaptureStdout(true);
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(p));
+        scheduler.runTasks();
+
+        TEST_ASSERT(p->isDone());
+        TEST_ASSERT(p->getExitCode() == 0);
+        TEST_ASSERT(p->getPid() == 0);
+        TEST_ASSERT(TaskGraph::getResultAs<std::string>(*p) == "hello\nworld\n");
+    }
+
+    TEST_FUNCTION(exitCodeFails)
+    {
+        TEST_START;
+        auto p = shell("Exit3", "echo oops >&2; exit 3");
+        auto after = std::make_shared<TaskGraph::Task>("After");
+        after->setWorkFunction([] {});
+        after->addDependency(p);
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(p));
+        TEST_ASSERT(scheduler.addTask(after));
+        scheduler.runTasks();
+
+        TEST_ASSERT(p->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(p->getExitCode() == 3);
+        TEST_ASSERT(p->getLastError().contains(QStringLiteral("code 3")));
+        TEST_ASSERT(after->getStatus() == TaskGraph::Task::Status::Cancelled);
+    }
+
+    TEST_FUNCTION(missingProgramFails)
+    {
+        TEST_START;
+        auto p = std::make_shared<TaskGraph::ProcessTask>("Missing", "taskgraph-no-such-program");
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(p));
+        scheduler.runTasks();
+
+        TEST_ASSERT(p->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(p->getLastError().contains(QStringLiteral("cannot start")));
+    }
+
+    TEST_FUNCTION(largeStderrDoesNotStall)
+    {
+        TEST_START;
+        // More than a pipe buffer on stderr before anything reaches stdout.
+        auto p = shell("Noisy", "i=0; while [ $i -lt 4000 ]; do echo 'warning line padding padding' >&2; i=$((i+1)); done; echo done");
+        p->setCaptureStdout(true);
+        p->setTimeout(std::chrono::seconds(20));
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(p));
+        scheduler.runTasks();
+
+        TEST_ASSERT(p->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<std::string>(*p) == "done\n");
+    }
+
+    TEST_FUNCTION(manyChildrenOneWorker)
+    {
+        TEST_START;
+        TaskGraph::TaskScheduler scheduler(1);
+        std::vector<std::shared_ptr<TaskGraph::ProcessTask>> children;
+        for (int i = 0; i < 16; ++i)
+        {
+            children.push_back(std::make_shared<TaskGraph::ProcessTask>("Sleep" + std::to_string(i), "sleep",
+                                                                        std::vector<std::string>{ "0.3" }));
+            TEST_ASSERT(scheduler.addTask(children.back()));
+        }
+
+        // A worker held per child would take 16 * 0.3 s = 4.8 s.
+        const auto start = Clock::now();
+        scheduler.runTasks();
+        const auto took = Clock::now() - start;
+
+        for (const auto& c : children)
+            TEST_ASSERT(c->isDone());
+        TEST_ASSERT(took < std::chrono::milliseconds(2500));
+    }
+
+    TEST_FUNCTION(timeoutKillsChild)
+    {
+        TEST_START;
+        auto p = std::make_shared<TaskGraph::ProcessTask>("Hang", "sleep", std::vector<std::string>{ "10" });
+        p->setTimeout(std::chrono::milliseconds(100));
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(p));
+        const auto start = Clock::now();
+        scheduler.runTasks();
+
+        TEST_ASSERT(Clock::now() - start < std::chrono::seconds(3));
+        TEST_ASSERT(p->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(p->getLastError() == QStringLiteral("timeout"));
+        TEST_ASSERT(p->getPid() == 0);
+    }
+
+    TEST_FUNCTION(cancelKillsChild)
+    {
+        TEST_START;
+        auto p = std::make_shared<TaskGraph::ProcessTask>("HangCancel", "sleep", std::vector<std::string>{ "10" });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(p));
+        scheduler.runTasksAsync();
+        const auto deadline = Clock::now() + std::chrono::seconds(2);
+        while (p->getPid() == 0 && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        TEST_ASSERT(p->getPid() != 0);
+        scheduler.cancel();
+
+        const auto stop = Clock::now() + std::chrono::seconds(3);
+        while (scheduler.isRunning() && Clock::now() < stop)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        TEST_ASSERT(!scheduler.isRunning());
+        TEST_ASSERT(p->getStatus() == TaskGraph::Task::Status::Cancelled);
+        TEST_ASSERT(p->getPid() == 0);
+    }
+};
+
+TEST_INSTANTIATE(TST_ProcessTask);
+
+#endif
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_ResourcePools : public UnitTest::Test
+{
+    TEST_CLASS(TST_ResourcePools)
+public:
+    TST_ResourcePools()
+        : Test("TST_ResourcePools")
+    {
+        ADD_TEST(TST_ResourcePools::capacityLimitsConcurrency);
+        ADD_TEST(TST_ResourcePools::waitingTasksFreeTheirWorker);
+        ADD_TEST(TST_ResourcePools::oversizedRequirementRunsAlone);
+        ADD_TEST(TST_ResourcePools::unknownResourceIgnored);
+        ADD_TEST(TST_ResourcePools::cancelWhileWaiting);
+        ADD_TEST(TST_ResourcePools::capacityRejectedWhileRunning);
+    }
+
+private:
+    TEST_FUNCTION(capacityLimitsConcurrency)
+    {
+        TEST_START;
+        TestHelpers::Concurrency disk;
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.setResourceCapacity("disk", 2));
+        std::vector<std::shared_ptr<TaskGraph::Task>> tasks;
+        for (int i = 0; i < 8; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Disk" + std::to_string(i));
+            t->setResourceRequirement("disk", 1);
+            t->setWorkFunction([&disk] {
+                disk.enter();
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                disk.leave();
+            });
+            tasks.push_back(t);
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        scheduler.runTasks();
+
+        for (const auto& t : tasks)
+            TEST_ASSERT(t->isDone());
+        TEST_ASSERT(disk.max.load() == 2);
+        TEST_ASSERT(scheduler.getResourceInUse("disk") == 0u);
+        TEST_ASSERT(scheduler.getStats().resourceWaits >= 1u);
+    }
+
+    TEST_FUNCTION(waitingTasksFreeTheirWorker)
+    {
+        TEST_START;
+        // Two workers, one licence: the licence tasks queue up without taking the
+        // second worker away from the free tasks.
+        std::atomic<int> freeDone{0};
+        std::atomic<int> licenceStarts{0};
+        std::atomic<int> freeDoneAtSecondStart{-1};
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.setResourceCapacity("licence", 1));
+        std::vector<std::shared_ptr<TaskGraph::Task>> tasks;
+        for (int i = 0; i < 3; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Licence" + std::to_string(i));
+            t->setResourceRequirement("licence", 1);
+            t->setWorkFunction([&] {
+                if (++licenceStarts == 2)
+                    freeDoneAtSecondStart = freeDone.load();
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            });
+            tasks.push_back(t);
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Free" + std::to_string(i));
+            t->setWorkFunction([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                ++freeDone;
+            });
+            tasks.push_back(t);
+        }
+        for (const auto& t : tasks)
+            TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        for (const auto& t : tasks)
+            TEST_ASSERT(t->isDone());
+        TEST_ASSERT(freeDoneAtSecondStart.load() == 4);
+    }
+
+    TEST_FUNCTION(oversizedRequirementRunsAlone)
+    {
+        TEST_START;
+        TestHelpers::Concurrency disk;
+        std::atomic<bool> bigOverlapped{false};
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.setResourceCapacity("disk", 2));
+        auto big = std::make_shared<TaskGraph::Task>("Big");
+        big->setResourceRequirement("disk", 5);
+        big->setWorkFunction([&] {
+            disk.enter();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (disk.now.load() != 1)
+                bigOverlapped = true;
+            disk.leave();
+        });
+        TEST_ASSERT(scheduler.addTask(big));
+        std::vector<std::shared_ptr<TaskGraph::Task>> small;
+        for (int i = 0; i < 4; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Small" + std::to_string(i));
+            t->setResourceRequirement("disk", 1);
+            t->setWorkFunction([&disk] {
+                disk.enter();
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                disk.leave();
+            });
+            small.push_back(t);
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        scheduler.runTasks();
+
+        TEST_ASSERT(big->isDone());
+        for (const auto& t : small)
+            TEST_ASSERT(t->isDone());
+        TEST_ASSERT(!bigOverlapped.load());
+        TEST_ASSERT(disk.max.load() <= 2);
+    }
+
+    TEST_FUNCTION(unknownResourceIgnored)
+    {
+        TEST_START;
+        auto t = std::make_shared<TaskGraph::Task>("Gpu");
+        t->setResourceRequirement("gpu", 1);
+        t->setWorkFunction([] {});
+        TEST_ASSERT(t->getResourceRequirement("gpu") == 1u);
+        TEST_ASSERT(t->getResourceRequirement("disk") == 0u);
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(scheduler.getResourceCapacity("gpu") == 0u);
+        TEST_ASSERT(scheduler.getStats().resourceWaits == 0u);
+    }
+
+    TEST_FUNCTION(cancelWhileWaiting)
+    {
+        TEST_START;
+        std::atomic<bool> holding{false};
+        std::atomic<bool> holdUntilCancel{true};
+        auto holder = std::make_shared<TaskGraph::Task>("Holder");
+        holder->setResourceRequirement("licence", 1);
+        holder->setWorkFunction([&](TaskGraph::TaskContext& ctx) {
+            holding = true;
+            while (holdUntilCancel.load() && !ctx.isCancelRequested())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+        auto waiter = std::make_shared<TaskGraph::Task>("Waiter");
+        waiter->setResourceRequirement("licence", 1);
+        waiter->setWorkFunction([] {});
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.setResourceCapacity("licence", 1));
+        TEST_ASSERT(scheduler.addTask(holder));
+        TEST_ASSERT(scheduler.addTask(waiter));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(TestHelpers::waitFor([&] { return holding.load() && scheduler.getStats().resourceWaits == 1u; }, std::chrono::seconds(2)));
+        TEST_ASSERT(scheduler.getResourceInUse("licence") == 1u);
+        scheduler.cancel();
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+        TEST_ASSERT(waiter->getStatus() == TaskGraph::Task::Status::Cancelled);
+        TEST_ASSERT(scheduler.getResourceInUse("licence") == 0u);
+
+        // The pool starts empty in the next run.
+        holdUntilCancel = false;
+        scheduler.resetTasks();
+        scheduler.runTasks();
+        TEST_ASSERT(holder->isDone());
+        TEST_ASSERT(waiter->isDone());
+    }
+
+    TEST_FUNCTION(capacityRejectedWhileRunning)
+    {
+        TEST_START;
+        std::atomic<bool> release{false};
+        auto t = std::make_shared<TaskGraph::Task>("Hold");
+        t->setWorkFunction([&] {
+            while (!release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setResourceCapacity("disk", 3));
+        TEST_ASSERT(scheduler.getResourceCapacity("disk") == 3u);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(!scheduler.setResourceCapacity("disk", 1));
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+        release = true;
+        TEST_ASSERT(TestHelpers::waitFor([&] { return !scheduler.isRunning(); }, std::chrono::seconds(2)));
+        TEST_ASSERT(scheduler.getResourceCapacity("disk") == 3u);
+        TEST_ASSERT(scheduler.setResourceCapacity("disk", 0));
+        TEST_ASSERT(scheduler.getResourceCapacity("disk") == 0u);
+    }
+};
+
+TEST_INSTANTIATE(TST_ResourcePools);
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_RetryBackoff : public UnitTest::Test
+{
+    TEST_CLASS(TST_RetryBackoff)
+public:
+    TST_RetryBackoff()
+        : Test("TST_RetryBackoff")
+    {
+        ADD_TEST(TST_RetryBackoff::exponentialDelays);
+        ADD_TEST(TST_RetryBackoff::workerFreeDuringBackoff);
+        ADD_TEST(TST_RetryBackoff::syncModeWaitsForParkedRetry);
+        ADD_TEST(TST_RetryBackoff::cancelWhileParked);
+        ADD_TEST(TST_RetryBackoff::failFastRetiresParkedRetry);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static std::shared_ptr<TaskGraph::Task> flaky(const std::string& name, std::atomic<int>& attempts, int failures)
+    {
+        auto t = std::make_shared<TaskGraph::Task>(name);
+        t->setWorkFunction([&attempts, failures] {
+            if (++attempts <= failures)
+                throw std::runtime_error("transient");
+        });
+        return t;
+    }
+
+    TEST_FUNCTION(exponentialDelays)
+    {
+        TEST_START;
+        TaskGraph::Task t("T");
+        TEST_ASSERT(t.getRetryDelay(1).count() == 0);
+        t.setRetryBackoff(std::chrono::milliseconds(100));
+        TEST_ASSERT(t.getRetryDelay(1).count() == 100);
+        TEST_ASSERT(t.getRetryDelay(3).count() == 100);
+
+        t.setRetryBackoffMultiplier(2.0);
+        t.setRetryBackoffCap(std::chrono::milliseconds(500));
+        TEST_ASSERT(t.getRetryDelay(1).count() == 100);
+        TEST_ASSERT(t.getRetryDelay(2).count() == 200);
+        TEST_ASSERT(t.getRetryDelay(3).count() == 400);
+        TEST_ASSERT(t.getRetryDelay(4).count() == 500);
+        TEST_ASSERT(t.getRetryDelay(200).count() == 500);
+
+        t.setRetryBackoffMultiplier(0.5);
+        TEST_ASSERT(t.getRetryBackoffMultiplier() == 1.0);
+        t.setRetryJitter(2.0);
+        TEST_ASSERT(t.getRetryJitter() == 1.0);
+        t.setRetryJitter(-1.0);
+        TEST_ASSERT(t.getRetryJitter() == 0.0);
+    }
+
+    TEST_FUNCTION(workerFreeDuringBackoff)
+    {
+        TEST_START;
+        // One worker. While "Flaky" waits 200 ms for its retry, the worker runs
+        // the other tasks instead of sleeping.
+        std::atomic<int> attempts{0};
+        auto f = flaky("Flaky", attempts, 1);
+        f->setMaxRetries(1);
+        f->setRetryBackoff(std::chrono::milliseconds(200));
+
+        std::atomic<int> othersDone{0};
+        std::atomic<int> othersDoneAtRetry{-1};
+        f->setWorkFunction([&] {
+            if (++attempts == 1)
+                throw std::runtime_error("transient");
+            othersDoneAtRetry = othersDone.load();
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(f));
+        for (int i = 0; i < 5; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Other" + std::to_string(i));
+            t->setWorkFunction([&othersDone] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                ++othersDone;
+            });
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        scheduler.runTasks();
+
+        TEST_ASSERT(f->isDone());
+        TEST_ASSERT(attempts.load() == 2);
+        TEST_ASSERT(othersDoneAtRetry.load() == 5);
+        TEST_ASSERT(scheduler.getStats().retriesParked == 1u);
+    }
+
+    TEST_FUNCTION(syncModeWaitsForParkedRetry)
+    {
+        TEST_START;
+        std::atomic<int> attempts{0};
+        auto f = flaky("Flaky", attempts, 2);
+        f->setMaxRetries(2);
+        f->setRetryBackoff(std::chrono::milliseconds(10));
+        f->setRetryBackoffMultiplier(2.0);
+        auto after = std::make_shared<TaskGraph::Task>("After");
+        TEST_ASSERT(after->addDependency(f));
+
+        TaskGraph::TaskScheduler scheduler(0);
+        TEST_ASSERT(scheduler.addTask(f));
+        TEST_ASSERT(scheduler.addTask(after));
+        auto start = Clock::now();
+        scheduler.runTasks();
+
+        TEST_ASSERT(f->isDone());
+        TEST_ASSERT(after->isDone());
+        TEST_ASSERT(attempts.load() == 3);
+        TEST_ASSERT(Clock::now() - start >= std::chrono::milliseconds(30));
+    }
+
+    TEST_FUNCTION(cancelWhileParked)
+    {
+        TEST_START;
+        std::atomic<int> attempts{0};
+        auto f = flaky("Flaky", attempts, 1);
+        f->setMaxRetries(1);
+        f->setRetryBackoff(std::chrono::seconds(10));
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.addTask(f));
+        scheduler.runTasksAsync();
+        auto deadline = Clock::now() + std::chrono::seconds(5);
+        while (scheduler.getStats().retriesParked == 0 && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        TEST_ASSERT(scheduler.getStats().retriesParked == 1u);
+
+        auto cancelAt = Clock::now();
+        scheduler.cancel();
+        while (scheduler.isRunning() && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        TEST_ASSERT(!scheduler.isRunning());
+        TEST_ASSERT(Clock::now() - cancelAt < std::chrono::seconds(2));
+        TEST_ASSERT(f->getStatus() == TaskGraph::Task::Status::Cancelled);
+        TEST_ASSERT(attempts.load() == 1);
+    }
+
+    TEST_FUNCTION(failFastRetiresParkedRetry)
+    {
+        TEST_START;
+        // "Flaky" parks for 10 s; "Broken" then fails for good and aborts the run,
+        // which must not wait for the parked retry.
+        std::atomic<int> attempts{0};
+        auto f = flaky("Flaky", attempts, 1);
+        f->setMaxRetries(1);
+        f->setRetryBackoff(std::chrono::seconds(10));
+        auto broken = std::make_shared<TaskGraph::Task>("Broken");
+        broken->setWorkFunction([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            throw std::runtime_error("permanent");
+        });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        scheduler.setFailurePolicy(TaskGraph::TaskScheduler::FailurePolicy::FailFast);
+        TEST_ASSERT(scheduler.addTask(f));
+        TEST_ASSERT(scheduler.addTask(broken));
+        auto start = Clock::now();
+        scheduler.runTasks();
+
+        TEST_ASSERT(Clock::now() - start < std::chrono::seconds(2));
+        TEST_ASSERT(broken->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(f->getStatus() == TaskGraph::Task::Status::Cancelled);
+    }
+};
+
+TEST_INSTANTIATE(TST_RetryBackoff);
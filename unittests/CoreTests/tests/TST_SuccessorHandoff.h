@@ -0,0 +1,151 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_SuccessorHandoff : public UnitTest::Test
+{
+    TEST_CLASS(TST_SuccessorHandoff)
+public:
+    TST_SuccessorHandoff()
+        : Test("TST_SuccessorHandoff")
+    {
+        ADD_TEST(TST_SuccessorHandoff::optionRoundTrip);
+        ADD_TEST(TST_SuccessorHandoff::chainStaysOnOneWorker);
+        ADD_TEST(TST_SuccessorHandoff::fanOutHandsOffOne);
+        ADD_TEST(TST_SuccessorHandoff::disabledQueuesEverything);
+        ADD_TEST(TST_SuccessorHandoff::outrankedSuccessorIsQueued);
+    }
+
+private:
+    using ExecutionMode = TaskGraph::TaskScheduler::ExecutionMode;
+
+    struct Recorder
+    {
+        std::mutex m;
+        std::vector<std::string> order;
+        std::set<std::thread::id> threads;
+        void operator()(const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(m);
+            order.push_back(name);
+            threads.insert(std::this_thread::get_id());
+        }
+    };
+
+    static std::shared_ptr<TaskGraph::Task> recorded(const std::string& name, Recorder& rec, int priority = 0)
+    {
+        auto t = std::make_shared<TaskGraph::Task>(name);
+        t->setPriority(priority);
+        t->setWorkFunction([&rec, name] { rec(name); });
+        return t;
+    }
+
+    TEST_FUNCTION(optionRoundTrip)
+    {
+        TEST_START;
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.getSuccessorHandoff());
+        TEST_ASSERT(scheduler.setSuccessorHandoff(false));
+        TEST_ASSERT(!scheduler.getSuccessorHandoff());
+    }
+
+    TEST_FUNCTION(chainStaysOnOneWorker)
+    {
+        TEST_START;
+        const int length = 200;
+        for (auto mode : { ExecutionMode::SharedQueue, ExecutionMode::WorkStealing })
+        {
+            Recorder rec;
+            std::vector<std::shared_ptr<TaskGraph::Task>> chain;
+            for (int i = 0; i < length; ++i)
+                chain.push_back(recorded("C" + std::to_string(i), rec));
+            for (int i = length - 1; i > 0; --i)
+                TEST_ASSERT(chain[i]->addDependency(chain[i - 1]));
+
+            TaskGraph::TaskScheduler scheduler(4);
+            TEST_ASSERT(scheduler.setExecutionMode(mode));
+            for (const auto& t : chain)
+                TEST_ASSERT(scheduler.addTask(t));
+            scheduler.runTasks();
+
+            const TaskGraph::TaskScheduler::Stats stats = scheduler.getStats();
+            TEST_ASSERT(rec.order.size() == static_cast<size_t>(length));
+            TEST_ASSERT(rec.threads.size() == 1u);
+            TEST_ASSERT(stats.handoffs == static_cast<uint64_t>(length - 1));
+            TEST_ASSERT(stats.tasksExecuted == static_cast<uint64_t>(length));
+        }
+    }
+
+    TEST_FUNCTION(fanOutHandsOffOne)
+    {
+        TEST_START;
+        Recorder rec;
+        auto root = recorded("Root", rec);
+        TaskGraph::TaskScheduler scheduler(3);
+        TEST_ASSERT(scheduler.addTask(root));
+        for (int i = 0; i < 10; ++i)
+        {
+            auto leaf = recorded("Leaf" + std::to_string(i), rec);
+            TEST_ASSERT(leaf->addDependency(root));
+            TEST_ASSERT(scheduler.addTask(leaf));
+        }
+        scheduler.runTasks();
+
+        TEST_ASSERT(rec.order.size() == 11u);
+        TEST_ASSERT(scheduler.getStats().handoffs == 1u);
+    }
+
+    TEST_FUNCTION(disabledQueuesEverything)
+    {
+        TEST_START;
+        Recorder rec;
+        auto a = recorded("A", rec);
+        auto b = recorded("B", rec);
+        TEST_ASSERT(b->addDependency(a));
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.setSuccessorHandoff(false));
+        TEST_ASSERT(scheduler.addTask(a));
+        TEST_ASSERT(scheduler.addTask(b));
+        scheduler.runTasks();
+
+        TEST_ASSERT(rec.order.size() == 2u);
+        TEST_ASSERT(scheduler.getStats().handoffs == 0u);
+    }
+
+    TEST_FUNCTION(outrankedSuccessorIsQueued)
+    {
+        TEST_START;
+        // "Gate" (priority 5) runs first and unblocks "Next". With "Other"
+        // (priority 3) waiting, a priority-0 Next must not jump the queue, while a
+        // priority-10 Next is handed off directly.
+        for (int nextPriority : { 0, 10 })
+        {
+            Recorder rec;
+            auto gate = recorded("Gate", rec, 5);
+            auto other = recorded("Other", rec, 3);
+            auto next = recorded("Next", rec, nextPriority);
+            TEST_ASSERT(next->addDependency(gate));
+
+            TaskGraph::TaskScheduler scheduler(1);
+            TEST_ASSERT(scheduler.addTask(gate));
+            TEST_ASSERT(scheduler.addTask(other));
+            TEST_ASSERT(scheduler.addTask(next));
+            scheduler.runTasks();
+
+            TEST_ASSERT(rec.order.size() == 3u);
+            TEST_ASSERT(rec.order[0] == "Gate");
+            TEST_ASSERT(rec.order[1] == (nextPriority == 0 ? "Other" : "Next"));
+            TEST_ASSERT(scheduler.getStats().handoffs == (nextPriority == 0 ? 0u : 1u));
+        }
+    }
+};
+
+TEST_INSTANTIATE(TST_SuccessorHandoff);
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include "TimerService.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+class TST_TimerService : public UnitTest::Test
+{
+    TEST_CLASS(TST_TimerService)
+public:
+    TST_TimerService()
+        : Test("TST_TimerService")
+    {
+        ADD_TEST(TST_TimerService::firesInDeadlineOrder);
+        ADD_TEST(TST_TimerService::disarmPreventsFiring);
+        ADD_TEST(TST_TimerService::manyTimersOneThread);
+        ADD_TEST(TST_TimerService::timedTasksStillTimeOut);
+    }
+
+private:
+    using Timers = TaskGraph::Internal::TimerService;
+
+    TEST_FUNCTION(firesInDeadlineOrder)
+    {
+        TEST_START;
+        Timers timers;
+        TEST_ASSERT(!timers.isThreadRunning());
+
+        std::atomic<int> order{0};
+        std::atomic<int> first{0};
+        std::atomic<int> second{0};
+        timers.arm(std::chrono::milliseconds(40), [&] { second = ++order; });
+        timers.arm(std::chrono::milliseconds(10), [&] { first = ++order; });
+        TEST_ASSERT(timers.isThreadRunning());
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (order.load() < 2 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        TEST_ASSERT(first.load() == 1);
+        TEST_ASSERT(second.load() == 2);
+        TEST_ASSERT(timers.getPendingCount() == 0u);
+    }
+
+    TEST_FUNCTION(disarmPreventsFiring)
+    {
+        TEST_START;
+        Timers timers;
+        std::atomic<bool> fired{false};
+        auto id = timers.arm(std::chrono::milliseconds(20), [&] { fired = true; });
+        TEST_ASSERT(id != Timers::invalidTimer);
+        TEST_ASSERT(timers.disarm(id));
+        TEST_ASSERT(!timers.disarm(id));
+        TEST_ASSERT(timers.getPendingCount() == 0u);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        TEST_ASSERT(!fired.load());
+        TEST_ASSERT(!timers.disarm(Timers::invalidTimer));
+    }
+
+    TEST_FUNCTION(manyTimersOneThread)
+    {
+        TEST_START;
+        // 10k armed then disarmed timers: slots are recycled, an old id cannot
+        // cancel the timer that reuses its slot.
+        Timers timers;
+        std::atomic<int> fired{0};
+        for (int i = 0; i < 10000; ++i)
+        {
+            auto id = timers.arm(std::chrono::seconds(30), [&] { fired.fetch_add(1); });
+            TEST_ASSERT(timers.disarm(id));
+        }
+        auto stale = timers.arm(std::chrono::seconds(30), [] {});
+        TEST_ASSERT(timers.disarm(stale));
+        auto live = timers.arm(std::chrono::milliseconds(5), [&] { fired.fetch_add(1); });
+        TEST_ASSERT(!timers.disarm(stale));
+        TEST_ASSERT(timers.getPendingCount() == 1u);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (fired.load() == 0 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        TEST_ASSERT(fired.load() == 1);
+        TEST_ASSERT(!timers.disarm(live));
+    }
+
+    TEST_FUNCTION(timedTasksStillTimeOut)
+    {
+        TEST_START;
+        // 500 fast tasks with a long safety timeout plus one that exceeds its own.
+        TaskGraph::TaskScheduler scheduler(4);
+        for (int i = 0; i < 500; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Fast" + std::to_string(i));
+            t->setTimeout(std::chrono::seconds(30));
+            t->setWorkFunction([] {});
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+        auto slow = std::make_shared<TaskGraph::Task>("Slow");
+        slow->setTimeout(std::chrono::milliseconds(30));
+        slow->setWorkFunction([slow] {
+            while (!slow->isCancelRequested())
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        });
+        TEST_ASSERT(scheduler.addTask(slow));
+        scheduler.setFailurePolicy(TaskGraph::TaskScheduler::FailurePolicy::ContinueOthers);
+
+        auto start = std::chrono::steady_clock::now();
+        scheduler.runTasks();
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+        TEST_ASSERT(slow->getStatus() == TaskGraph::Task::Status::Failed);
+        TEST_ASSERT(slow->getLastError().contains(QStringLiteral("timeout")));
+        TEST_ASSERT(ms < 2000);
+    }
+};
+
+TEST_INSTANTIATE(TST_TimerService);
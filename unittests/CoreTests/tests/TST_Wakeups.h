@@ -0,0 +1,116 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TST_Wakeups : public UnitTest::Test
+{
+    TEST_CLASS(TST_Wakeups)
+public:
+    TST_Wakeups()
+        : Test("TST_Wakeups")
+    {
+        ADD_TEST(TST_Wakeups::statsCountAndReset);
+        ADD_TEST(TST_Wakeups::chainWakesNoOtherWorker);
+        ADD_TEST(TST_Wakeups::fanOutWakesEachWorkerOnce);
+    }
+
+private:
+    static std::shared_ptr<TaskGraph::Task> counted(const std::string& name, std::atomic<int>& counter)
+    {
+        auto t = std::make_shared<TaskGraph::Task>(name);
+        t->setWorkFunction([&counter] { counter.fetch_add(1); });
+        return t;
+    }
+
+    TEST_FUNCTION(statsCountAndReset)
+    {
+        TEST_START;
+        std::atomic<int> counter{0};
+        TaskGraph::TaskScheduler scheduler(2);
+        for (int i = 0; i < 10; ++i)
+            TEST_ASSERT(scheduler.addTask(counted("T" + std::to_string(i), counter)));
+        scheduler.runTasks();
+        scheduler.runTasks();
+
+        TaskGraph::TaskScheduler::Stats stats = scheduler.getStats();
+        TEST_ASSERT(counter.load() == 20);
+        TEST_ASSERT(stats.tasksExecuted == 20u);
+        TEST_ASSERT(stats.spuriousWakeups <= stats.wakeups);
+
+        scheduler.resetStats();
+        stats = scheduler.getStats();
+        TEST_ASSERT(stats.tasksExecuted == 0u);
+        TEST_ASSERT(stats.notifications == 0u);
+        TEST_ASSERT(stats.wakeups == 0u);
+    }
+
+    TEST_FUNCTION(chainWakesNoOtherWorker)
+    {
+        TEST_START;
+        // Each completion unblocks exactly one successor, which the completing
+        // worker runs itself: apart from the start of the run nobody is signalled.
+        // Waking every idle worker per completion would signal ~7 per task here.
+        const int length = 300;
+        const size_t workers = 8;
+        for (auto mode : { TaskGraph::TaskScheduler::ExecutionMode::SharedQueue,
+                           TaskGraph::TaskScheduler::ExecutionMode::WorkStealing })
+        {
+            std::atomic<int> counter{0};
+            std::vector<std::shared_ptr<TaskGraph::Task>> chain;
+            for (int i = 0; i < length; ++i)
+                chain.push_back(counted("C" + std::to_string(i), counter));
+            for (int i = length - 1; i > 0; --i)
+                TEST_ASSERT(chain[i]->addDependency(chain[i - 1]));
+
+            TaskGraph::TaskScheduler scheduler(workers);
+            TEST_ASSERT(scheduler.setExecutionMode(mode));
+            for (const auto& t : chain)
+                TEST_ASSERT(scheduler.addTask(t));
+            scheduler.runTasks();
+
+            const TaskGraph::TaskScheduler::Stats stats = scheduler.getStats();
+            TEST_ASSERT(counter.load() == length);
+            TEST_ASSERT(stats.tasksExecuted == static_cast<uint64_t>(length));
+            TEST_ASSERT(stats.notifications <= 1u);
+            TEST_ASSERT(stats.spuriousWakeups <= workers);
+        }
+    }
+
+    TEST_FUNCTION(fanOutWakesEachWorkerOnce)
+    {
+        TEST_START;
+        // One root unblocks 1000 leaves: every sleeping worker is signalled once,
+        // the leaves themselves unblock nothing and signal nobody.
+        const int leaves = 1000;
+        const size_t workers = 4;
+        for (auto mode : { TaskGraph::TaskScheduler::ExecutionMode::SharedQueue,
+                           TaskGraph::TaskScheduler::ExecutionMode::WorkStealing })
+        {
+            std::atomic<int> counter{0};
+            auto root = counted("Root", counter);
+            TaskGraph::TaskScheduler scheduler(workers);
+            TEST_ASSERT(scheduler.setExecutionMode(mode));
+            TEST_ASSERT(scheduler.addTask(root));
+            for (int i = 0; i < leaves; ++i)
+            {
+                auto leaf = counted("L" + std::to_string(i), counter);
+                TEST_ASSERT(leaf->addDependency(root));
+                TEST_ASSERT(scheduler.addTask(leaf));
+            }
+            scheduler.runTasks();
+
+            const TaskGraph::TaskScheduler::Stats stats = scheduler.getStats();
+            TEST_ASSERT(counter.load() == leaves + 1);
+            TEST_ASSERT(stats.tasksExecuted == static_cast<uint64_t>(leaves + 1));
+            // One for the root at run start plus at most one per other worker.
+            TEST_ASSERT(stats.notifications <= workers);
+        }
+    }
+};
+
+TEST_INSTANTIATE(TST_Wakeups);
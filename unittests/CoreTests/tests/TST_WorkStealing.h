@@ -0,0 +1,144 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+class TST_WorkStealing : public UnitTest::Test
+{
+    TEST_CLASS(TST_WorkStealing)
+public:
+    TST_WorkStealing()
+        : Test("TST_WorkStealing")
+    {
+        ADD_TEST(TST_WorkStealing::modeRoundTrip);
+        ADD_TEST(TST_WorkStealing::fanOutFanIn);
+        ADD_TEST(TST_WorkStealing::idleWorkersSteal);
+        ADD_TEST(TST_WorkStealing::modeChangeRejectedWhileRunning);
+    }
+
+private:
+    TEST_FUNCTION(modeRoundTrip)
+    {
+        TEST_START;
+        using ExecutionMode = TaskGraph::TaskScheduler::ExecutionMode;
+        const ExecutionMode defaultMode = TaskGraph::TaskScheduler::getDefaultExecutionMode();
+        {
+            TaskGraph::TaskScheduler scheduler(2);
+            TEST_ASSERT(scheduler.getExecutionMode() == defaultMode);
+            TEST_ASSERT(scheduler.setExecutionMode(ExecutionMode::SharedQueue));
+            TEST_ASSERT(scheduler.getExecutionMode() == ExecutionMode::SharedQueue);
+            TEST_ASSERT(scheduler.setExecutionMode(ExecutionMode::WorkStealing));
+            TEST_ASSERT(scheduler.getExecutionMode() == ExecutionMode::WorkStealing);
+        }
+
+        // The default only applies to schedulers constructed afterwards.
+        TaskGraph::TaskScheduler before(2);
+        const ExecutionMode other = defaultMode == ExecutionMode::SharedQueue ? ExecutionMode::WorkStealing
+                                                                              : ExecutionMode::SharedQueue;
+        TaskGraph::TaskScheduler::setDefaultExecutionMode(other);
+        TaskGraph::TaskScheduler after(2);
+        TaskGraph::TaskScheduler::setDefaultExecutionMode(defaultMode);
+        TEST_ASSERT(before.getExecutionMode() == defaultMode);
+        TEST_ASSERT(after.getExecutionMode() == other);
+    }
+
+    TEST_FUNCTION(fanOutFanIn)
+    {
+        TEST_START;
+        // root -> 200 leaves -> 200 chained successors -> sink
+        auto root = std::make_shared<TaskGraph::Task>("Root");
+        auto sink = std::make_shared<TaskGraph::Task>("Sink");
+        std::atomic<int> counter{0};
+        root->setWorkFunction([&counter] { counter.fetch_add(1); });
+        sink->setWorkFunction([&counter] { counter.fetch_add(1); });
+
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.setExecutionMode(TaskGraph::TaskScheduler::ExecutionMode::WorkStealing));
+        TEST_ASSERT(scheduler.addTask(root));
+        TEST_ASSERT(scheduler.addTask(sink));
+        for (int i = 0; i < 200; ++i)
+        {
+            auto leaf = std::make_shared<TaskGraph::Task>("Leaf" + std::to_string(i));
+            auto next = std::make_shared<TaskGraph::Task>("Next" + std::to_string(i));
+            leaf->setWorkFunction([&counter] { counter.fetch_add(1); });
+            next->setWorkFunction([&counter] { counter.fetch_add(1); });
+            TEST_ASSERT(leaf->addDependency(root));
+            TEST_ASSERT(next->addDependency(leaf));
+            TEST_ASSERT(sink->addDependency(next));
+            TEST_ASSERT(scheduler.addTask(leaf));
+            TEST_ASSERT(scheduler.addTask(next));
+        }
+
+        // Run twice: the per-worker deques must be clean between runs.
+        for (int run = 0; run < 2; ++run)
+        {
+            counter = 0;
+            scheduler.runTasks();
+            TEST_ASSERT(counter.load() == 402);
+            TEST_ASSERT(sink->isDone());
+            TEST_ASSERT(scheduler.getProgressF() == 1.0f);
+        }
+    }
+
+    TEST_FUNCTION(idleWorkersSteal)
+    {
+        TEST_START;
+        // A single root unblocks 8 slow successors onto one worker's deque; the
+        // other workers must steal them, so they overlap in time.
+        auto root = std::make_shared<TaskGraph::Task>("Root");
+        root->setWorkFunction([] {});
+
+        std::mutex m;
+        std::set<std::thread::id> threads;
+        TestHelpers::Concurrency concurrency;
+        TaskGraph::TaskScheduler scheduler(4);
+        TEST_ASSERT(scheduler.setExecutionMode(TaskGraph::TaskScheduler::ExecutionMode::WorkStealing));
+        TEST_ASSERT(scheduler.addTask(root));
+        for (int i = 0; i < 8; ++i)
+        {
+            auto t = std::make_shared<TaskGraph::Task>("Slow" + std::to_string(i));
+            t->setWorkFunction([&] {
+                {
+                    std::lock_guard<std::mutex> lock(m);
+                    threads.insert(std::this_thread::get_id());
+                }
+                concurrency.enter();
+                std::this_thread::sleep_for(std::chrono::milliseconds(30));
+                concurrency.leave();
+            });
+            TEST_ASSERT(t->addDependency(root));
+            TEST_ASSERT(scheduler.addTask(t));
+        }
+
+        scheduler.runTasks();
+
+        TEST_ASSERT(threads.size() > 1);
+        TEST_ASSERT(concurrency.max.load() > 1);
+    }
+
+    TEST_FUNCTION(modeChangeRejectedWhileRunning)
+    {
+        TEST_START;
+        auto slow = std::make_shared<TaskGraph::Task>("Slow");
+        slow->setWorkFunction([] { std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+
+        TaskGraph::TaskScheduler scheduler(2);
+        TEST_ASSERT(scheduler.setExecutionMode(TaskGraph::TaskScheduler::ExecutionMode::SharedQueue));
+        TEST_ASSERT(scheduler.addTask(slow));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(!scheduler.setExecutionMode(TaskGraph::TaskScheduler::ExecutionMode::WorkStealing));
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+        TEST_ASSERT(scheduler.getExecutionMode() == TaskGraph::TaskScheduler::ExecutionMode::SharedQueue);
+
+        while (scheduler.isRunning())
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+};
+
+TEST_INSTANTIATE(TST_WorkStealing);
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "UnitTest.h"
+#include "TaskGraph.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TST_Yield : public UnitTest::Test
+{
+    TEST_CLASS(TST_Yield)
+public:
+    TST_Yield()
+        : Test("TST_Yield")
+    {
+        ADD_TEST(TST_Yield::longCoroutineLetsShortTaskRun);
+        ADD_TEST(TST_Yield::yieldThenKeepsState);
+        ADD_TEST(TST_Yield::noYieldWithoutWaitingWork);
+        ADD_TEST(TST_Yield::higherPriorityDoesNotYield);
+        ADD_TEST(TST_Yield::cancelAtYieldPoint);
+        ADD_TEST(TST_Yield::timeSliceRejectedWhileRunning);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static void spin(std::chrono::microseconds duration)
+    {
+        const auto until = Clock::now() + duration;
+        while (Clock::now() < until) {}
+    }
+
+    TEST_FUNCTION(longCoroutineLetsShortTaskRun)
+    {
+        TEST_START;
+        std::mutex orderMutex;
+        std::vector<std::string> order;
+        auto record = [&](const std::string& what) {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.push_back(what);
+        };
+        auto longTask = std::make_shared<TaskGraph::Task>("Long");
+        longTask->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            int steps = 0;
+            for (int i = 0; i < 40; ++i)
+            {
+                spin(std::chrono::microseconds(500));
+                ++steps;
+                co_await ctx.yield();
+            }
+            ctx.setResult(steps);
+            record("long");
+        });
+        auto shortTask = std::make_shared<TaskGraph::Task>("Short");
+        shortTask->setWorkFunction([&] { record("short"); });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setTimeSlice(std::chrono::milliseconds(2)));
+        TEST_ASSERT(scheduler.addTask(longTask));
+        TEST_ASSERT(scheduler.addTask(shortTask));
+        scheduler.runTasks();
+
+        TEST_ASSERT(longTask->isDone());
+        TEST_ASSERT(shortTask->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<int>(*longTask) == 40);
+        TEST_ASSERT(order.size() == 2u);
+        TEST_ASSERT(order[0] == "short");
+        TEST_ASSERT(scheduler.getStats().yields >= 1u);
+        TEST_ASSERT(scheduler.getStats().suspensions == 0u);
+    }
+
+    TEST_FUNCTION(yieldThenKeepsState)
+    {
+        TEST_START;
+        std::atomic<bool> shortDone{false};
+        std::atomic<bool> shortRanBeforeEnd{false};
+        auto sum = std::make_shared<long>(0);
+        auto next = std::make_shared<int>(0);
+        std::function<void(TaskGraph::TaskContext&)> work;
+        work = [&work, sum, next, &shortDone, &shortRanBeforeEnd](TaskGraph::TaskContext& ctx) {
+            while (*next < 1000)
+            {
+                *sum += (*next)++;
+                spin(std::chrono::microseconds(20));
+                if (ctx.shouldYield())
+                {
+                    ctx.yieldThen(work);
+                    return;
+                }
+            }
+            shortRanBeforeEnd = shortDone.load();
+            ctx.setResult(*sum);
+        };
+        auto longTask = std::make_shared<TaskGraph::Task>("Resumable");
+        longTask->setWorkFunction(work);
+        auto shortTask = std::make_shared<TaskGraph::Task>("Short");
+        shortTask->setWorkFunction([&] { shortDone = true; });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setTimeSlice(std::chrono::milliseconds(1)));
+        TEST_ASSERT(scheduler.addTask(longTask));
+        TEST_ASSERT(scheduler.addTask(shortTask));
+        scheduler.runTasks();
+
+        TEST_ASSERT(longTask->isDone());
+        TEST_ASSERT(TaskGraph::getResultAs<long>(*longTask) == 999L * 1000L / 2L);
+        TEST_ASSERT(shortRanBeforeEnd.load());
+        TEST_ASSERT(scheduler.getStats().yields >= 1u);
+    }
+
+    TEST_FUNCTION(noYieldWithoutWaitingWork)
+    {
+        TEST_START;
+        std::atomic<int> yieldsSeen{0};
+        auto t = std::make_shared<TaskGraph::Task>("Alone");
+        t->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            for (int i = 0; i < 20; ++i)
+            {
+                spin(std::chrono::microseconds(200));
+                if (ctx.shouldYield())
+                    ++yieldsSeen;
+                co_await ctx.yield();
+            }
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setTimeSlice(std::chrono::microseconds(0)));
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasks();
+
+        TEST_ASSERT(t->isDone());
+        TEST_ASSERT(yieldsSeen.load() == 0);
+        TEST_ASSERT(scheduler.getStats().yields == 0u);
+    }
+
+    TEST_FUNCTION(higherPriorityDoesNotYield)
+    {
+        TEST_START;
+        std::atomic<bool> highDone{false};
+        std::atomic<bool> lowSawHighDone{false};
+        auto high = std::make_shared<TaskGraph::Task>("High");
+        high->setPriority(5);
+        high->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            for (int i = 0; i < 20; ++i)
+            {
+                spin(std::chrono::microseconds(500));
+                co_await ctx.yield();
+            }
+            highDone = true;
+        });
+        auto low = std::make_shared<TaskGraph::Task>("Low");
+        low->setWorkFunction([&] { lowSawHighDone = highDone.load(); });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.setTimeSlice(std::chrono::microseconds(0)));
+        TEST_ASSERT(scheduler.addTask(low));
+        TEST_ASSERT(scheduler.addTask(high));
+        scheduler.runTasks();
+
+        TEST_ASSERT(high->isDone());
+        TEST_ASSERT(low->isDone());
+        TEST_ASSERT(lowSawHighDone.load());
+        TEST_ASSERT(scheduler.getStats().yields == 0u);
+    }
+
+    TEST_FUNCTION(cancelAtYieldPoint)
+    {
+        TEST_START;
+        std::atomic<bool> started{false};
+        auto t = std::make_shared<TaskGraph::Task>("Endless");
+        t->setCoroutineFunction([&](TaskGraph::TaskContext& ctx) -> TaskGraph::CoTask {
+            started = true;
+            for (;;)
+            {
+                spin(std::chrono::microseconds(100));
+                co_await ctx.yield();
+            }
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        const auto deadline = Clock::now() + std::chrono::seconds(2);
+        while (!started.load() && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        TEST_ASSERT(started.load());
+        scheduler.cancel();
+
+        const auto stop = Clock::now() + std::chrono::seconds(2);
+        while (scheduler.isRunning() && Clock::now() < stop)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        TEST_ASSERT(!scheduler.isRunning());
+        TEST_ASSERT(t->getStatus() == TaskGraph::Task::Status::Cancelled);
+    }
+
+    TEST_FUNCTION(timeSliceRejectedWhileRunning)
+    {
+        TEST_START;
+        std::atomic<bool> release{false};
+        auto t = std::make_shared<TaskGraph::Task>("Hold");
+        t->setWorkFunction([&] {
+            while (!release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+
+        TaskGraph::TaskScheduler scheduler(1);
+        TEST_ASSERT(scheduler.getTimeSlice() == std::chrono::milliseconds(10));
+        TEST_ASSERT(scheduler.addTask(t));
+        scheduler.runTasksAsync();
+        TEST_ASSERT(!scheduler.setTimeSlice(std::chrono::milliseconds(1)));
+        TEST_ASSERT(scheduler.getLastError() == TaskGraph::TaskScheduler::Error::busy);
+        release = true;
+        const auto stop = Clock::now() + std::chrono::seconds(2);
+        while (scheduler.isRunning() && Clock::now() < stop)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        TEST_ASSERT(scheduler.getTimeSlice() == std::chrono::milliseconds(10));
+    }
+};
+
+TEST_INSTANTIATE(TST_Yield);